@@ -0,0 +1,12 @@
+# Generated by Sertools/frame_layout.py from SENSOR_REGISTRY (config.h), do not edit.
+FRAME_VERSION = 3
+FRAME_HEADER_BYTES = 5
+FRAME_MAX_BYTES = 57
+
+# (name, float channels, metadata bytes) of each sensor, in frame order
+SENSOR_LAYOUT = [
+    ('as7262', 6, 2),
+    ('hdc1080', 2, 0),
+    ('pt100', 1, 0),
+    ('anemometer', 1, 0),
+]
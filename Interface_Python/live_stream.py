@@ -0,0 +1,107 @@
+"""Live reader for the binary telemetry stream of a station (TELEMETRY_EN in config.h).
+
+Every packet is COBS(frame + CRC16 XMODEM big endian) followed by a 0x00 delimiter.
+The frames are the same as the ones saved on the SD card, so they are decoded with
+utils.decode_frame into the same DataFrames as utils.ReadBinaryData.
+
+Usage :
+    python live_stream.py COM4
+"""
+import argparse
+import binascii
+
+import utils
+
+TELEMETRY_BAUD_RATE = 250000
+TELEMETRY_CRC_BYTES = 2
+TELEMETRY_DELIMITER = b'\x00'
+
+
+def cobs_decode(packet: bytes):
+    """Returns the decoded bytes, or None if the packet is malformed."""
+    out = bytearray()
+    i = 0
+    while i < len(packet):
+        code = packet[i]
+        if code == 0 or i + code > len(packet):
+            return None
+        out += packet[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(packet):
+            out.append(0)
+    return bytes(out)
+
+
+def unpack_packet(packet: bytes):
+    """Returns the frame carried by a packet, or None if it is corrupted."""
+    data = cobs_decode(packet)
+    if data is None or len(data) <= TELEMETRY_CRC_BYTES:
+        return None
+    frame, crc = data[:-TELEMETRY_CRC_BYTES], data[-TELEMETRY_CRC_BYTES:]
+    if binascii.crc_hqx(frame, 0) != int.from_bytes(crc, 'big'):
+        return None
+    return frame
+
+
+class LiveStream:
+    def __init__(self, port, baudrate=TELEMETRY_BAUD_RATE):
+        import serial
+
+        self.serial = serial.Serial(port, baudrate=baudrate, bytesize=8, stopbits=serial.STOPBITS_ONE)
+        self.dfs = utils.new_dataframes()
+        self.health = utils.pd.DataFrame(columns=utils.MEAS_HEALTH)
+        self.diag = utils.pd.DataFrame(columns=utils.MEAS_DIAG)
+        self.as7262_range = utils.pd.DataFrame(columns=utils.MEAS_AS7262_RANGE)
+        self.rejected = 0
+        self._buffer = b''
+
+    def packets(self):
+        """Yields the raw packets as they come in, delimiter removed."""
+        while 1:
+            self._buffer += self.serial.read(self.serial.in_waiting or 1)
+            *packets, self._buffer = self._buffer.split(TELEMETRY_DELIMITER)
+            yield from (packet for packet in packets if packet)
+
+    def frames(self):
+        """Yields (sample time, measurements) and appends them to self.dfs."""
+        for packet in self.packets():
+            frame = unpack_packet(packet)
+            if frame is None or utils.checksum(frame) is False:
+                self.rejected += 1
+                continue
+            if frame[0] == utils.HEALTH_RECORD_TAG:
+                decoded = utils.decode_health(frame)
+                if decoded is not None:
+                    self.health.loc[decoded[0]] = decoded[1]
+                continue
+            if frame[0] == utils.DIAG_RECORD_TAG:
+                decoded = utils.decode_diag(frame)
+                if decoded is not None:
+                    self.diag.loc[decoded[0]] = decoded[1]
+                continue
+            meta = {}
+            decoded = utils.decode_frame(frame, meta)
+            if decoded is None:
+                self.rejected += 1
+                continue
+            sample_time, values = decoded
+            for key, value in values.items():
+                self.dfs[key].loc[sample_time] = value
+            if 'as7262_range' in meta:
+                self.as7262_range.loc[sample_time] = meta['as7262_range']
+            yield sample_time, values
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Read the live telemetry of a station.')
+    parser.add_argument('port')
+    parser.add_argument('--baudrate', type=int, default=TELEMETRY_BAUD_RATE)
+    args = parser.parse_args()
+
+    stream = LiveStream(args.port, args.baudrate)
+    for sample_time, values in stream.frames():
+        print(sample_time, values)
+
+
+if __name__ == '__main__':
+    main()
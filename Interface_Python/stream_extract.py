@@ -0,0 +1,93 @@
+"""Extracts the records of a stream log (SD_STREAM_EN in config.h, sdstream.h).
+
+The log is found by its superblock, at a block boundary, so the input can be an
+image of the whole card (dd if=/dev/sdX of=card.img), of the raw partition
+(SD_STREAM_RAW) or the STREAM.BIN file. The valid blocks that follow it are
+unpacked into a standard record stream, the same as DATALOG.BIN, which
+utils.ReadBinaryData reads.
+
+A raw partition is made once on the host, its type is SD_STREAM_PART_TYPE
+(0xDA) and the first partition stays FAT for config.bin, e.g. with sfdisk :
+    ,256M,c
+    ,,da
+
+Usage :
+    python stream_extract.py card.img DATALOG.BIN
+"""
+import argparse
+import binascii
+import mmap
+import struct
+
+BLOCK_BYTES = 512
+STREAM_MAGIC = b'TSLG'
+STREAM_LAYOUT_VERSION = 1
+STREAM_SUPER = struct.Struct('<4sBII')
+STREAM_BLOCK_TAG = 0xB5
+STREAM_HEADER = struct.Struct('<BI')
+STREAM_CRC_BYTES = 2
+
+
+def sealed(block):
+    """Tells if the CRC at the end of a block matches the rest of it."""
+    return binascii.crc_hqx(block[:-STREAM_CRC_BYTES], 0) == int.from_bytes(block[-STREAM_CRC_BYTES:], 'big')
+
+
+def find_superblock(image, start=0):
+    """Returns the offset of the first superblock of the image and the number of
+    data blocks that follow it, or None."""
+    i = image.find(STREAM_MAGIC, start)
+    while i >= 0:
+        block = image[i:i + BLOCK_BYTES]
+        if i % BLOCK_BYTES == 0 and len(block) == BLOCK_BYTES and sealed(block):
+            _, version, _, count = STREAM_SUPER.unpack_from(block)
+            if version == STREAM_LAYOUT_VERSION:
+                return i, count
+        i = image.find(STREAM_MAGIC, i + 1)
+    return None
+
+
+def stream_blocks(data, count=None):
+    """Returns the records of the data blocks of a stream log, up to the first
+    one that isn't valid (erased, torn by a reset or left by an older log)."""
+    records = bytearray()
+    seq0 = None
+    end = len(data) if count is None else min(len(data), count * BLOCK_BYTES)
+    for k, i in enumerate(range(0, end - BLOCK_BYTES + 1, BLOCK_BYTES)):
+        block = data[i:i + BLOCK_BYTES]
+        tag, seq = STREAM_HEADER.unpack_from(block)
+        if seq0 is None:
+            seq0 = seq
+        if tag != STREAM_BLOCK_TAG or seq != seq0 + k or not sealed(block):
+            break
+        records += block[STREAM_HEADER.size:-STREAM_CRC_BYTES]
+    return bytes(records)
+
+
+def extract(image):
+    """Returns the records of the stream log of an image, None if it holds none."""
+    found = find_superblock(image)
+    if found is None:
+        return None
+    offset, count = found
+    return stream_blocks(image[offset + BLOCK_BYTES:offset + (count + 1) * BLOCK_BYTES], count)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Extract the records of a stream log from a card image.')
+    parser.add_argument('image', help='image of the card, of the raw partition or STREAM.BIN')
+    parser.add_argument('output', help='record stream, read as a DATALOG.BIN')
+    args = parser.parse_args()
+
+    with open(args.image, 'rb') as f, mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as image:
+        records = extract(image)
+    if records is None:
+        raise SystemExit('No stream log in ' + args.image)
+
+    with open(args.output, 'wb') as f:
+        f.write(records)
+    print(f'{len(records) // (BLOCK_BYTES - STREAM_HEADER.size - STREAM_CRC_BYTES)} blocks extracted')
+
+
+if __name__ == '__main__':
+    main()
@@ -6,8 +6,12 @@ from pytz import timezone
 
 from PyQt5 import QtWidgets
 
+import os
 import struct
 
+import frame_layout
+import stream_extract
+
 # Some constant definitions : lists of measurements.
 MEAS_AS7262 = ['450nm', '500nm', '550nm', '570nm', '600nm', '650nm']
 MEAS_HDC1080 = ['temp', 'rh%']
@@ -22,12 +26,64 @@ BYTE_COUNT_TIME = 8
 
 BYTES_IN_FRAME = 50
 
+# Tagged measurement frames (FRAME_TAG in config.h) : tag, version, length,
+# presence bitmap, flags (version 2 and up), then the timestamp and the
+# measurements of the present sensors. From version 3, the AS7262 channels are
+# followed by the gain code and the integration time (2.8 ms cycles) they used.
+FRAME_TAG = 0xA4
+FRAME_HEADER_BYTES = {1: 4, 2: 5, frame_layout.FRAME_VERSION: frame_layout.FRAME_HEADER_BYTES}
+FRAME_FLAG_DARK = 1 << 0
+FRAME_FLAG_MISSING = 1 << 1  # A due sensor failed, it isn't in the frame
+FRAME_FLAG_NO_TIME = 1 << 2  # The RTC couldn't be read, the timestamp is 0
+FRAME_PAD = 0xFF  # End of an SD block (memory.cpp)
+SENSOR_MEAS = {'as7262': MEAS_AS7262, 'hdc1080': MEAS_HDC1080, 'rtd': MEAS_RTD, 'anemometer': MEAS_ANEMOMETER}
+# The slot of each sensor comes from the firmware registry (frame_layout.py),
+# the metadata bytes were added in version 3.
+META_VERSION = 3
+AS7262_RANGE_VERSION = 3
+AS7262_GAINS = [1.0, 3.7, 16.0, 64.0]
+AS7262_CYCLE_MS = 2.8
+MEAS_AS7262_RANGE = ['gain', 'integration_ms']
+
+assert [len(SENSOR_MEAS[sensor]) for sensor in SENSORLIST] == [count for _, count, _ in frame_layout.SENSOR_LAYOUT], \
+    'SENSOR_MEAS doesn\'t match the firmware registry, run Sertools/frame_layout.py'
+
+# Health records (health.h), interleaved with the measurement frames.
+HEALTH_RECORD_TAG = 0xA5
+HEALTH_RAILS = ['pt100', 'hdc1080', 'as7262', 'relay_9v', 'sd', 'cpu', 'sleep']
+# Version 2 adds the stack high water and the fewest free SRAM bytes (sram.h).
+MEAS_HEALTH = ['wakes', 'period_s', 'awake_ms'] + [f'{rail}_uC' for rail in HEALTH_RAILS] + ['stack_B', 'sram_free_B']
+HEALTH_FORMAT = {1: '<BBBIHII' + 'I' * len(HEALTH_RAILS)}
+HEALTH_FORMAT[2] = HEALTH_FORMAT[1] + 'HH'
+
+# Diagnostics records (diag.h), interleaved the same way. They tell the behavior
+# of the station itself apart from its environment : a drift here is a firmware
+# or hardware regression. Version 1 only timed the directory syncs, version 2
+# times every block write and adds the writes the card refused, version 3 adds
+# the RTC reads and alarms that failed.
+DIAG_RECORD_TAG = 0xA6
+MEAS_DIAG = ['wakes', 'wake_mean_ms', 'wake_max_ms', 'bus_recoveries', 'bus_stuck'] + \
+    [f'{sensor}_init_failures' for sensor in SENSORLIST] + [f'{sensor}_read_failures' for sensor in SENSORLIST] + \
+    ['sd_writes', 'sd_write_mean_us', 'sd_write_max_us', 'supply_mV', 'sd_failures', 'rtc_failures']
+DIAG_FORMAT = {1: '<BBBIHHHHH' + 'B' * 2 * len(SENSORLIST) + 'HIIH'}
+DIAG_FORMAT[2] = DIAG_FORMAT[1] + 'H'
+DIAG_FORMAT[3] = DIAG_FORMAT[2] + 'H'
+RECORD_TAGS = (HEALTH_RECORD_TAG, DIAG_RECORD_TAG)
+
+# Stream log (SD_STREAM_FILE_NAME, sdstream.h), unpacked by stream_extract.py.
+STREAM_FILE_NAME = 'STREAM.BIN'
+
 class ReadBinaryData:
     def __init__(self, progressbar: QtWidgets.QProgressBar, frame_size, fn=r'D:\DATALOG.BIN'):
 
         self.bytes = None
         self.frame_list = None
+        self.health_list = None
+        self.diag_list = None
         self.dfs = None
+        self.health = None
+        self.diag = None
+        self.as7262_range = None
         self.frame_size = frame_size
         self.sample_count = 0
         self.progressbar = progressbar
@@ -37,14 +93,17 @@ class ReadBinaryData:
     def import_data(self, fn):
         with open(fn, 'rb') as f:
             self.bytes = f.read()
-            self.frame_list = [list(self.bytes[i:i + self.frame_size]) for i in range(0, len(self.bytes), self.frame_size)]
-            self.sample_count = len(self.bytes) / self.frame_size
+            if os.path.basename(fn).upper() == STREAM_FILE_NAME:
+                self.bytes = stream_extract.extract(self.bytes) or b''
+            records = list(split_records(self.bytes, self.frame_size))
+            self.frame_list = [list(record) for record in records if record[0] not in RECORD_TAGS]
+            self.health_list = [record for record in records if record[0] == HEALTH_RECORD_TAG]
+            self.diag_list = [record for record in records if record[0] == DIAG_RECORD_TAG]
+            self.sample_count = len(self.frame_list)
 
     def split_data(self):
-        df_light = pd.DataFrame(columns=MEAS_AS7262)
-        df_temp_rh = pd.DataFrame(columns=MEAS_HDC1080)
-        df_soil_temp = pd.DataFrame(columns=MEAS_RTD)
-        df_anemometer = pd.DataFrame(columns=MEAS_ANEMOMETER)
+        self.dfs = new_dataframes()
+        self.as7262_range = pd.DataFrame(columns=MEAS_AS7262_RANGE)
 
         for i, frame in enumerate(self.frame_list):
 
@@ -53,33 +112,41 @@ class ReadBinaryData:
             if checksum(frame) is False:
                 continue
 
-            # The time is the first element.
-            sample_time = struct.unpack('>Q', bytes([frame.pop(0) for _ in range(BYTE_COUNT_TIME)]))[0]
-            # Then the spectral measurements.
-            light_data = [struct.unpack('f', bytes([frame.pop(0) for _ in range(BYTE_COUNT_FLOAT)]))[0]
-                          for _ in range(len(MEAS_AS7262))]
-            df_light.loc[sample_time] = light_data
-            # Then the air temperature and relative humidity.
-            temp_rh_data = (struct.unpack('f', bytes([frame.pop(0) for _ in range(BYTE_COUNT_FLOAT)]))[0],
-                            struct.unpack('f', bytes([frame.pop(0) for _ in range(BYTE_COUNT_FLOAT)]))[0])
-            df_temp_rh.loc[sample_time] = temp_rh_data
-            # Then the soil temperature.
-            soil_temp_data = struct.unpack('f', bytes([frame.pop(0) for _ in range(BYTE_COUNT_FLOAT)]))[0]
-            df_soil_temp.loc[sample_time] = soil_temp_data
-            # Then the wind speed.
-            wind_speed_data = struct.unpack('f', bytes([frame.pop(0) for _ in range(BYTE_COUNT_FLOAT)]))[0]
-            df_anemometer.loc[sample_time] = wind_speed_data
-
-        #df_light.index = pd.to_datetime(df_light.index, unit='s').tz_localize('canada/eastern')
-        df_light.index = pd.to_datetime(df_light.index - 14400, unit='s').tz_localize(None)
-        df_temp_rh.index = pd.to_datetime(df_temp_rh.index - 14400, unit='s').tz_localize(None)
-        df_soil_temp.index = pd.to_datetime(df_soil_temp.index - 14400, unit='s').tz_localize(None)
-        df_anemometer.index = pd.to_datetime(df_anemometer.index - 14400, unit='s').tz_localize(None)
-
-        self.dfs = {'as7262': df_light,
-                    'hdc1080': df_temp_rh,
-                    'rtd': df_soil_temp,
-                    'anemometer': df_anemometer}
+            meta = {}
+            decoded = decode_frame(frame, meta)
+            if decoded is None:
+                continue
+            sample_time, values = decoded
+            # A sample the RTC couldn't date has no place in the series.
+            if meta['no_time']:
+                continue
+            for key, value in values.items():
+                self.dfs[key].loc[sample_time] = value
+            if 'as7262_range' in meta:
+                self.as7262_range.loc[sample_time] = meta['as7262_range']
+
+        for df in self.dfs.values():
+            to_local_time(df)
+        to_local_time(self.as7262_range)
+
+        self.health = pd.DataFrame(columns=MEAS_HEALTH)
+        for record in self.health_list:
+            if checksum(record) is False:
+                continue
+            decoded = decode_health(record)
+            if decoded is not None:
+                self.health.loc[decoded[0]] = decoded[1]
+        estimate_battery_use(self.health)
+        to_local_time(self.health)
+
+        self.diag = pd.DataFrame(columns=MEAS_DIAG)
+        for record in self.diag_list:
+            if checksum(record) is False:
+                continue
+            decoded = decode_diag(record)
+            if decoded is not None:
+                self.diag.loc[decoded[0]] = decoded[1]
+        to_local_time(self.diag)
 
 class GenerateDerivativeData:
     def __init__(self, dfs):
@@ -128,6 +195,122 @@ class GenerateDerivativeData:
                 df.to_excel(writer, sheet_name=key, index_label='datetime')
 
 
+def new_dataframes():
+    """Empty columnar structures, one DataFrame per sensor, indexed by the sample time."""
+    return {'as7262': pd.DataFrame(columns=MEAS_AS7262),
+            'hdc1080': pd.DataFrame(columns=MEAS_HDC1080),
+            'rtd': pd.DataFrame(columns=MEAS_RTD),
+            'anemometer': pd.DataFrame(columns=MEAS_ANEMOMETER)}
+
+
+def to_local_time(df: pd.DataFrame):
+    """Converts the unix time index to local time (UTC-4)."""
+    #df.index = pd.to_datetime(df.index, unit='s').tz_localize('canada/eastern')
+    df.index = pd.to_datetime(df.index - 14400, unit='s').tz_localize(None)
+
+
+def decode_frame(frame, meta=None):
+    """Decodes a frame whose checksum was validated. Returns the sample time and
+    the measurements of the sensors present in the frame, keyed like the DataFrames
+    of new_dataframes(), or None for an unknown version. The untagged frames of
+    older logs hold every sensor. The AS7262 range, when the frame holds one, is
+    stored in meta['as7262_range'] as MEAS_AS7262_RANGE values,
+    meta['missing'] tells if a sensor due at this sample failed, meta['dark']
+    if the AS7262 was skipped in the dark and meta['no_time'] if the sample
+    has no time (0)."""
+    frame = bytes(frame)
+    flags = 0
+    version = 0
+    if frame[0] == FRAME_TAG:
+        version = frame[1]
+        presence = frame[3]
+        i = FRAME_HEADER_BYTES.get(frame[1])
+        if i is None:
+            return None
+        if i > 4:
+            flags = frame[4]
+    else:
+        presence = (1 << len(SENSORLIST)) - 1
+        i = 0
+    # The time is the first element.
+    sample_time = struct.unpack_from('>Q', frame, i)[0]
+    i += BYTE_COUNT_TIME
+    # Then the measurements of each sensor read, in SENSORLIST order.
+    values = {}
+    for bit, (sensor, (_, count, meta_bytes)) in enumerate(zip(SENSORLIST, frame_layout.SENSOR_LAYOUT)):
+        if not presence & (1 << bit):
+            continue
+        data = struct.unpack_from('<' + 'f' * count, frame, i)
+        i += count * BYTE_COUNT_FLOAT
+        values[sensor] = list(data) if count > 1 else data[0]
+        if sensor == 'as7262' and version >= AS7262_RANGE_VERSION and meta is not None:
+            gain, cycles = frame[i], frame[i + 1]
+            meta['as7262_range'] = [AS7262_GAINS[gain & 0x03], cycles * AS7262_CYCLE_MS]
+        if version >= META_VERSION:
+            i += meta_bytes
+    # The AS7262 isn't read in the dark : the frame doesn't hold it and no
+    # value is made up for it, meta['dark'] tells the gated samples.
+    if meta is not None:
+        meta['missing'] = bool(flags & FRAME_FLAG_MISSING)
+        meta['dark'] = bool(flags & FRAME_FLAG_DARK)
+        meta['no_time'] = bool(flags & FRAME_FLAG_NO_TIME)
+    return sample_time, values
+
+
+def split_records(data: bytes, frame_size=BYTES_IN_FRAME):
+    """Splits the data log in measurement frames, health and diagnostics records. The tagged
+    records hold their length in their third byte, the untagged frames of older
+    logs start with the MSB of their timestamp, always 0. A record doesn't span
+    two SD blocks, the end of a block is padded with FRAME_PAD."""
+    i = 0
+    while i < len(data):
+        if data[i] in (HEALTH_RECORD_TAG, DIAG_RECORD_TAG, FRAME_TAG) and i + 2 < len(data) and data[i + 2] > 2:
+            length = data[i + 2]
+        elif data[i] == 0:
+            length = frame_size
+        elif data[i] == FRAME_PAD:
+            # End of an SD block, the next record starts the next block.
+            i += 1
+            continue
+        else:
+            # Lost sync, skip a byte.
+            i += 1
+            continue
+        if i + length > len(data):
+            break
+        yield data[i:i + length]
+        i += length
+
+
+def decode_health(record):
+    """Decodes a health record whose checksum was validated. Returns the timestamp
+    and the values of the MEAS_HEALTH columns, or None for an unknown version.
+    The columns an older version doesn't hold are None."""
+    fmt = HEALTH_FORMAT.get(record[1])
+    if fmt is None:
+        return None
+    _, _, _, timestamp, *values = struct.unpack_from(fmt, bytes(record))
+    return timestamp, values + [None] * (len(MEAS_HEALTH) - len(values))
+
+
+def decode_diag(record):
+    """Decodes a diagnostics record whose checksum was validated. Returns the
+    timestamp and the values of the MEAS_DIAG columns, or None for an unknown
+    version. The columns an older version doesn't hold are None."""
+    fmt = DIAG_FORMAT.get(record[1])
+    if fmt is None:
+        return None
+    _, _, _, timestamp, *values = struct.unpack_from(fmt, bytes(record))
+    return timestamp, values + [None] * (len(MEAS_DIAG) - len(values))
+
+
+def estimate_battery_use(health: pd.DataFrame):
+    """Adds the total charge of each period and the mean consumption in mAh/day."""
+    charge_columns = [f'{rail}_uC' for rail in HEALTH_RAILS]
+    health['total_mAh'] = health[charge_columns].sum(axis=1) / 3.6e6
+    health['mAh_per_day'] = health['total_mAh'] / health['period_s'].where(health['period_s'] > 0) * 86400
+
+
 def checksum(frame: bytearray, checksum_bytes=2):
     frame = list(frame)
     xsum = struct.unpack('>H', bytes([frame.pop(-i) for i in range(checksum_bytes, 0, -1)]))[0]
@@ -0,0 +1,39 @@
+/*
+ * bus.h
+ *
+ * Created: 2026-10-19 6:47:32 PM
+ *  Author: Alexis Laframboise
+ *
+ *	This module bounds the TWI (I2C) bus operations. Every
+ *	transfer of the Wire library gives up after its deadline
+ *	instead of hanging the station, and a bus left stuck by
+ *	a slave holding SDA low is recovered : SCL is clocked by
+ *	hand until SDA is released, a STOP is sent and the TWI
+ *	is reset.
+ */
+
+#ifndef BUS_H_
+#define BUS_H_
+
+#include <Arduino.h>
+
+/** @brief	Sets the deadline of the TWI transfers. Must be
+ *			called after Wire.begin().
+ *
+ */
+void bus_init(void);
+
+/** @brief	Frees a stuck bus and resets the TWI.
+ *
+ *  @return	1 if SDA is released, 0 if it is still held low
+ */
+uint8_t bus_recover(void);
+
+/** @brief	Tells if a TWI transfer missed its deadline since
+ *			the last call, the bus is recovered if so.
+ *
+ *  @return	1 if a transfer failed, 0 otherwise
+ */
+uint8_t bus_failed(void);
+
+#endif /* BUS_H_ */
@@ -0,0 +1,38 @@
+/*
+ * clock.h
+ *
+ * Created: 2026-10-19 5:26:47 PM
+ *  Author: Alexis Laframboise
+ *
+ *	This module divides the system clock (CLKPR) during the
+ *	long waits of a wake : sensor warm-ups, conversions and
+ *	SD card busy time. The CPU only spins in those waits, so
+ *	it draws much less at 1 MHz than at 16 MHz.
+ *
+ *	millis(), micros() and delay() stay right while the clock
+ *	is divided (timer0_set_clock_shift() in wiring.c), so do
+ *	the energy ticks. The full clock is always restored before
+ *	returning, the buses (TWI, SPI, USART) are never used at
+ *	the divided clock.
+ */
+
+#ifndef CLOCK_H_
+#define CLOCK_H_
+
+#include <Arduino.h>
+
+/** @brief	Sets the system clock prescaler, timer0 and the
+ *			energy ticks are compensated.
+ *
+ *  @param	log2 of the prescaler, 0 for the full clock
+ */
+void clock_prescale(uint8_t shift);
+
+/** @brief	Waits at the divided clock (CLOCK_WAIT_SHIFT), or
+ *			at full clock below CLOCK_WAIT_MIN_MS.
+ *
+ *  @param	time to wait, in ms
+ */
+void clock_wait_ms(uint16_t ms);
+
+#endif /* CLOCK_H_ */
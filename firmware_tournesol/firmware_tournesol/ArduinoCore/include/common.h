@@ -10,9 +10,15 @@
 #include <Arduino.h>
 
 #include "config.h"
+#include "registry.h"
 #include "connections.h"
+#include "trace.h"
 
+#if DEBUG_PRINTFUNCT_SERIAL
 #define PRINTFUNCT        Serial.println(__FUNCTION__)
+#else
+#define PRINTFUNCT
+#endif
 
 union data_float_bytes {
 	float value;
@@ -14,9 +14,45 @@
 
 /* Saving definition */
 #define SAVE_FILE_NAME	  ("datalog.bin")
+#define TIMESTAMP_BYTES	  (sizeof(uint64_t))
+#define CHECKSUM_BYTES	  (2)
+#define SD_BLOCK_BYTES	  (512)
+
+/* Stream log : the frames are written with one CMD25 sequence
+   that spans the wakes, in a contiguous file preallocated and
+   erased once (sdstream.h). SAVE_FILE_NAME isn't used then.
+   With SD_STREAM_RAW, the log fills the partition of type
+   SD_STREAM_PART_TYPE instead, the first partition stays FAT. */
+#ifndef SD_STREAM_EN			  /* The simulator compares both logs */
+#define SD_STREAM_EN	  (0)
+#endif
+#define SD_STREAM_FILE_NAME ("stream.bin")
+#define SD_STREAM_BLOCKS  (65536UL)	/* 32 MiB, a year of full frames every minute */
+#ifndef SD_STREAM_RAW			  /* Only with SD_STREAM_EN, the simulator checks it */
+#define SD_STREAM_RAW	  (0)
+#endif
+#define SD_STREAM_PART_TYPE (0xDA)	/* Non-FS data */
+
+/* Measurement frame : tag, version, length (checksum included),
+   presence bitmap (bit i : module i was read), flags, 64 bits big
+   endian timestamp, measurements of the present modules in
+   registry order, then the checksum. Older logs hold untagged
+   frames of every module, starting with the timestamp. */
+#define FRAME_TAG		  (0xA4)
+#define FRAME_VERSION	  (3)
+#define FRAME_HEADER_BYTES (5)
+
+/* Frame flags */
+#define FRAME_FLAG_DARK	  (1 << 0)	/* AS7262 skipped, it is dark */
+#define FRAME_FLAG_MISSING (1 << 1)	/* A due module failed, it isn't in the frame */
+#define FRAME_FLAG_NO_TIME (1 << 2)	/* The RTC couldn't be read, the timestamp is 0 */
+#define FRAME_PAD		  (0xFF)	/* End of an SD block, no record starts with it */
+#define FRAME_MEAS_OFFSET (FRAME_HEADER_BYTES + TIMESTAMP_BYTES)
+#define FRAME_MAX_BYTES	  (FRAME_MEAS_OFFSET + TOTAL_MEAS_BYTES + CHECKSUM_BYTES)	/* registry.h */
 
 /* Timing definitions */
 #define ERROR_BLINK_MS    (200)
+#define SIGNAL_WARNING_REPEAT (3)
 
 /* Error definitions */
 #define ERROR_OK          (0)
@@ -25,20 +61,47 @@
 #define ERROR_HDC1080     (1 << 2)
 #define ERROR_RTD         (1 << 3)
 #define ERROR_ANEMOMETER  (1 << 4)
-#define ERROR_COUNT       (5)
+#define ERROR_SETTINGS    (1 << 5)
+#define ERROR_RTC         (1 << 6)
+#define ERROR_COUNT       (7)
 
 /* Serial interface & debugging definitions */
-#define SERIAL_BAUD_RATE		  (9600)
 #define SERIAL_EN                 (1)
-#define DEBUG_DS3231_SERIAL       (0 & SERIAL_EN)
-#define DEBUG_AS7262_SERIAL       (1 & SERIAL_EN)
-#define DEBUG_HDC1080_SERIAL      (1 & SERIAL_EN)
-#define DEBUG_PT100_SERIAL        (1 & SERIAL_EN)
-#define DEBUG_ANEMOMETER_SERIAL   (1 & SERIAL_EN)
-#define DEBUG_SAVE_FRAME_SERIAL   (1 & SERIAL_EN)
-#define DEBUG_SIGNAL_ERROR_SERIAL (1 & SERIAL_EN)
 
+/* Live telemetry : every frame is sent as a COBS packet with a CRC.
+   Text debugging is disabled since it would corrupt the stream. */
+#define TELEMETRY_EN              (0 & SERIAL_EN)
+#define TELEMETRY_BAUD_RATE       (250000)  /* 0% error at 16 MHz */
+
+#define SERIAL_BAUD_RATE		  (TELEMETRY_EN ? TELEMETRY_BAUD_RATE : 9600)
+#define SERIAL_DEBUG_EN           (SERIAL_EN & !TELEMETRY_EN)
+#define DEBUG_DS3231_SERIAL       (0 & SERIAL_DEBUG_EN)
+#define DEBUG_AS7262_SERIAL       (1 & SERIAL_DEBUG_EN)
+#define DEBUG_HDC1080_SERIAL      (1 & SERIAL_DEBUG_EN)
+#define DEBUG_PT100_SERIAL        (1 & SERIAL_DEBUG_EN)
+#define DEBUG_ANEMOMETER_SERIAL   (1 & SERIAL_DEBUG_EN)
+#define DEBUG_SAVE_FRAME_SERIAL   (1 & SERIAL_DEBUG_EN)
+#define DEBUG_SIGNAL_ERROR_SERIAL (1 & SERIAL_DEBUG_EN)
+#define DEBUG_PRINTFUNCT_SERIAL   (0 & SERIAL_DEBUG_EN)
+#define DEBUG_POWER_SERIAL        (0 & SERIAL_DEBUG_EN)
+#define DEBUG_SRAM_SERIAL         (0 & SERIAL_DEBUG_EN)
+
+#ifndef DEBUG_NO_SD                       /* The simulator (sim/) builds with the SD */
 #define DEBUG_NO_SD               (1)
+#endif
+
+/* Execution trace definitions */
+#define TRACE_EN                  (1)
+#define TRACE_BUFFER_LEN          (32)    /* Entries, power of 2 */
+#define TRACE_SAVE_EN             (1 & TRACE_EN & !SD_STREAM_EN)  /* On failed wakes only, the stream owns the SD cache */
+#define TRACE_FILE_NAME           ("trace.bin")
+#define DEBUG_TRACE_SERIAL        (0 & SERIAL_DEBUG_EN & TRACE_EN)
+
+/* Settings block (calibration & station config), see settings.h.
+   The values below and the drivers calibration constants are
+   the defaults used when no valid block is found. */
+#define SETTINGS_FILE_NAME        ("config.bin")
+#define SETTINGS_EEPROM_ADDR      (0)
 
 /* DS3231 config */
 /* Alarm 1 config
@@ -63,19 +126,129 @@
 #define DS3231_ALARM2_MIN         (30)
 #define DS3231_ALARM2_HOUR        (12)
 
+/* Sampling schedule : with a period, alarm 1 is reprogrammed
+   after each sample on the next multiple of the period and
+   alarm 2 is disabled. A period of 0 keeps the alarm match
+   modes above. With the adaptive sampling, the period goes back
+   to SAMPLING_PERIOD_S as soon as a channel changes faster than
+   its threshold, and doubles up to the maximum otherwise.
+   Both periods can be overridden by the settings block. */
+#define SAMPLING_PERIOD_S         (60)     /* 0 to 65535 */
+#define SAMPLING_PERIOD_MAX_S     (960)
+#define ADAPTIVE_SAMPLING_EN      (1)
+#define SAMPLING_RATE_LIGHT       (100.0)  /* Calibrated counts per minute */
+#define SAMPLING_RATE_TEMPERATURE (0.2)    /* deg C per minute */
+#define SAMPLING_RATE_HUMIDITY    (1.0)    /* %RH per minute */
+#define SAMPLING_RATE_WIND        (0.5)    /* m/s per minute */
+/* Threshold of each channel of a sensor (SENSOR_REGISTRY), in frame order */
+#define AS7262_SAMPLING_RATES     SAMPLING_RATE_LIGHT, SAMPLING_RATE_LIGHT, SAMPLING_RATE_LIGHT, \
+								  SAMPLING_RATE_LIGHT, SAMPLING_RATE_LIGHT, SAMPLING_RATE_LIGHT
+#define HDC1080_SAMPLING_RATES    SAMPLING_RATE_TEMPERATURE, SAMPLING_RATE_HUMIDITY
+#define PT100_SAMPLING_RATES      SAMPLING_RATE_TEMPERATURE
+#define ANEMOMETER_SAMPLING_RATES SAMPLING_RATE_WIND
+
 /* Timestamp related */
 #define UPDATE_TIMESTAMP		  (0)
 #define UNIX_CURRENT_TIMESTAMP    (1649628900)
 
-/* Modules related */
-#define AS7262_MEAS_BYTES		  (AS726x_NUM_CHANNELS * sizeof(float))
-#define HDC1080_MEAS_BYTES		  (2 * sizeof(float))
-#define PT100_MEAS_BYTES		  (1 * sizeof(float))
-#define ANEMOMETER_MEAS_BYTES	  (1 * sizeof(float))
+/* Modules related, in registry order */
+#define MODULE_AS7262			  (1 << 0)
+#define MODULE_HDC1080			  (1 << 1)
+#define MODULE_PT100			  (1 << 2)
+#define MODULE_ANEMOMETER		  (1 << 3)
+#define MODULE_COUNT			  (4)
+#define MODULE_ALL				  ((1 << MODULE_COUNT) - 1)
+
+/* Per module schedule : a module is read on the first wake at
+   or after each multiple of its period, shifted by its phase.
+   A period of 0 reads it on every wake. */
+#define AS7262_PERIOD_S			  (0)
+#define AS7262_PHASE_S			  (0)
+#define HDC1080_PERIOD_S		  (0)
+#define HDC1080_PHASE_S			  (0)
+#define PT100_PERIOD_S			  (1800)
+#define PT100_PHASE_S			  (0)
+#define ANEMOMETER_PERIOD_S		  (0)
+#define ANEMOMETER_PHASE_S		  (0)
+
+/* AS7262 night gating : the AS7262 isn't powered when its last
+   reading was dark and the local time is in the night window. It is
+   still read every AS7262_DARK_RECHECK_S to catch artificial light.
+   The RTC holds UTC (set by the host), the window is in local hours :
+   STATION_UTC_OFFSET_H is added to the RTC time, without daylight
+   saving (the host decodes with the same fixed offset). */
+#define STATION_UTC_OFFSET_H	  (-4)     /* Local time - UTC */
+#define AS7262_DARK_GATING_EN	  (1)
+#define AS7262_DARK_THRESHOLD	  (50.0)   /* Sum of the calibrated channels */
+#define AS7262_NIGHT_START_H	  (21)     /* Local hours */
+#define AS7262_NIGHT_END_H		  (5)
+#define AS7262_DARK_RECHECK_S	  (3600)
+
+/* AS7262 auto-ranging : the gain and the integration time of a reading
+   are picked from the raw counts of the previous one, the shortest
+   integration that keeps the strongest channel within [LOW, HIGH] of
+   the full scale is used. Both are saved in the frame after the
+   channels (AS7262_RANGE_BYTES : gain code, integration cycles). */
+#define AS7262_AUTORANGE_EN		  (1)
+#define AS7262_RANGE_LOW		  (0.25)   /* Fraction of the full scale */
+#define AS7262_RANGE_HIGH		  (0.75)
+#define AS7262_DEFAULT_GAIN		  (3)      /* GAIN_64X, as set by begin() */
+#define AS7262_DEFAULT_INT_CYCLES (50)     /* 2.8 ms cycles, as set by begin() */
+#define AS7262_RANGE_BYTES		  (2)
+
+/* Sensor registry, in frame order : name, float channels and
+   metadata bytes saved after them, MODULE_* bits in the same order.
+   The frame layout and size are computed from it at compile time
+   (registry.h), Sertools/frame_layout.py generates the layout of
+   the host decoder from it. */
+#define SENSOR_REGISTRY(X)		  X(AS7262,		6, AS7262_RANGE_BYTES)\
+								  X(HDC1080,	2, 0)\
+								  X(PT100,		1, 0)\
+								  X(ANEMOMETER,	1, 0)
+
+/* Bus deadlines : a TWI transfer gives up after BUS_TWI_TIMEOUT_US,
+   the bus is then recovered (SCL clocked until the stuck slave
+   releases SDA, TWI reset) and the module is saved as missing. */
+#define BUS_TWI_TIMEOUT_US		  (25000)
+#define BUS_RECOVERY_CLOCKS		  (9)
+#define AS7262_READY_TIMEOUT_MS	  (500)    /* Past the expected conversion */
+
+/* Hardware watchdog, armed for each wake cycle */
+#define WATCHDOG_EN				  (1)
+#define WATCHDOG_TIMEOUT		  (WDTO_8S)
+
+/* Power domains, in registry order (see power.h) : warm-up of
+   each rail before its module is read, and estimate of the module
+   init and read time used to plan the switch-on of the next rails. */
+#define POWER_WARMUP_MS			  { 100,   /* AS7262 */\
+									15,    /* HDC1080 */\
+									200,   /* PT100 front-end */\
+									1000 } /* 9V relay and anemometer */
+#define POWER_READ_MS			  { 1300,  /* begin() resets the AS7262 for 1 s */\
+									40,\
+									1,\
+									1 }
+
+/* Clock division during the long waits (see clock.h) */
+#define CLOCK_WAIT_EN			  (1)
+#define CLOCK_WAIT_SHIFT		  (4)      /* 16 MHz / 2^4 = 1 MHz */
+#define CLOCK_WAIT_MIN_MS		  (1)
+
+/* Health record & energy accounting */
+#define HEALTH_PERIOD_WAKES		  (60)     /* Wakes between two health records */
+
+/* Diagnostics record (see diag.h) */
+#define DIAG_PERIOD_WAKES		  (60)     /* Wakes between two diagnostics records */
+#define DIAG_BANDGAP_MV			  (1100)   /* Internal reference, 1.0 to 1.2 V, to be calibrated */
 
-#define TOTAL_MEAS_BYTES		  (AS7262_MEAS_BYTES +\
-								   HDC1080_MEAS_BYTES+\
-								   PT100_MEAS_BYTES+\
-								   ANEMOMETER_MEAS_BYTES)
+/* Estimated current of each rail while it is on, in uA.
+   To be replaced by bench measurements of the station. */
+#define ENERGY_CURRENT_PT100_UA	  (1500)
+#define ENERGY_CURRENT_HDC1080_UA (300)
+#define ENERGY_CURRENT_AS7262_UA  (5000)
+#define ENERGY_CURRENT_RELAY_9V_UA (45000)
+#define ENERGY_CURRENT_SD_UA	  (25000)
+#define ENERGY_CURRENT_CPU_UA	  (15000)
+#define ENERGY_CURRENT_SLEEP_UA	  (350)
 
 #endif /* CONFIG_H_ */
\ No newline at end of file
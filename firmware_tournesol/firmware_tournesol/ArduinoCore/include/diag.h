@@ -0,0 +1,112 @@
+/*
+ * diag.h
+ *
+ * Created: 2026-10-19 9:12:45 PM
+ *  Author: Alexis Laframboise
+ *
+ *	This module builds the diagnostics records. Where the
+ *	health record (health.h) accounts the energy, this one
+ *	counts how the station itself behaves : wake duration,
+ *	TWI bus recoveries, sensor and RTC failures, SD write
+ *	latency and supply voltage. A change there is a firmware
+ *	or hardware regression, not the environment.
+ *
+ *	A diagnostics record is saved every DIAG_PERIOD_WAKES
+ *	wakes in the data log, between the measurement frames,
+ *	with the same layout as a health record : tag, version,
+ *	length (checksum included), the fields of diag_record_t
+ *	in little endian, then the 16 bits checksum. The counters
+ *	saturate instead of wrapping around.
+ */
+
+#ifndef DIAG_H_
+#define DIAG_H_
+
+#include <Arduino.h>
+
+#include "registry.h"
+
+#define DIAG_RECORD_TAG			(0xA6)
+#define DIAG_RECORD_VERSION		(3)
+
+typedef struct diag_record_t{
+	uint8_t tag;
+	uint8_t version;
+	uint8_t len;
+	uint32_t timestamp;						/* Unix time of the last wake */
+	uint16_t wakes;							/* Wakes in the period */
+	uint16_t wake_mean_ms;
+	uint16_t wake_max_ms;
+	uint16_t bus_recoveries;				/* TWI transfers past their deadline */
+	uint16_t bus_stuck;						/* Recoveries that left SDA low */
+	uint8_t init_failures[SENSOR_COUNT];	/* Per sensor, in registry order */
+	uint8_t read_failures[SENSOR_COUNT];
+	uint16_t sd_writes;						/* Blocks written */
+	uint32_t sd_write_mean_us;
+	uint32_t sd_write_max_us;
+	uint16_t supply_mV;						/* Measured at the end of the period */
+	uint16_t sd_failures;					/* Block writes refused by the card (version 2) */
+	uint16_t rtc_failures;					/* Time reads and alarms that failed (version 3) */
+} diag_record_t;
+
+union diag_record_bytes {
+	diag_record_t record;
+	uint8_t bytes[sizeof(diag_record_t)];
+};
+
+#define DIAG_RECORD_BYTES		(sizeof(diag_record_t))
+
+/** @brief	Counts a bus recovery.
+ *
+ *  @param	1 if SDA was released, 0 otherwise
+ */
+void diag_bus_recovered(uint8_t released);
+
+/** @brief	Counts a sensor whose init or read failed.
+ *
+ *  @param	sensor id
+ */
+void diag_init_failed(uint8_t id);
+void diag_read_failed(uint8_t id);
+
+/** @brief	Accounts an SD block write.
+ *
+ *  @param	duration of the write, in energy ticks
+ */
+void diag_sd_write(uint32_t ticks);
+
+/** @brief	Counts an SD block write that failed.
+ *
+ */
+void diag_sd_failed(void);
+
+/** @brief	Counts an RTC access that failed after its retry :
+ *			time read or alarm programming.
+ *
+ */
+void diag_rtc_failed(void);
+
+/** @brief	Measures the supply voltage against the internal
+ *			bandgap reference. The ADC must be clocked.
+ *
+ */
+void diag_measure_supply(void);
+
+/** @brief	Accounts a wake cycle, once its frame is saved.
+ *			The wake duration is the one so far, the records
+ *			and the directory sync that follow are left out.
+ *
+ *  @param	unix time of the wake
+ *  @return	1 if a diagnostics record is due, 0 otherwise
+ */
+uint8_t diag_update(uint32_t timestamp);
+
+/** @brief	Builds the diagnostics record of the period and
+ *			starts a new one.
+ *
+ *  @param	a pointer to an array of bytes.
+ *  @return	number of bytes written, checksum excluded
+ */
+uint8_t diag_build_record(uint8_t* data);
+
+#endif /* DIAG_H_ */
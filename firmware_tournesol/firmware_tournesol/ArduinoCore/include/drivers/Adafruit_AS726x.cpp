@@ -25,11 +25,7 @@
  */
 
 #include "Adafruit_AS726x.h"
-
-Adafruit_AS726x::~Adafruit_AS726x(void) {
-  if (i2c_dev)
-    delete i2c_dev;
-}
+#include "clock.h"
 
 /**************************************************************************/
 /*!
@@ -39,10 +35,10 @@ Adafruit_AS726x::~Adafruit_AS726x(void) {
 */
 /**************************************************************************/
 bool Adafruit_AS726x::begin(TwoWire *theWire) {
-  if (i2c_dev)
-    delete i2c_dev;
-  i2c_dev = new Adafruit_I2CDevice(_i2caddr, theWire);
-  if (!i2c_dev->begin()) {
+  // begin() runs at every reading, the device is kept in place (no heap).
+  i2c_dev = Adafruit_I2CDevice(_i2caddr, theWire);
+  _timed_out = false;
+  if (!i2c_dev.begin()) {
     return false;
   }
 
@@ -50,8 +46,8 @@ bool Adafruit_AS726x::begin(TwoWire *theWire) {
   virtualWrite(AS726X_CONTROL_SETUP, _control_setup.get());
   _control_setup.RST = 0;
 
-  // wait for it to boot up
-  delay(1000);
+  // wait for it to boot up, at the divided clock
+  clock_wait_ms(1000);
 
   // try to read the version reg to make sure we can connect
   uint8_t version = virtualRead(AS726X_HW_VERSION);
@@ -308,61 +304,56 @@ uint8_t Adafruit_AS726x::read8(byte reg) {
   return ret;
 }
 
-uint8_t Adafruit_AS726x::virtualRead(uint8_t addr) {
-  volatile uint8_t status, d;
-  while (1) {
-    // Read slave I²C status to see if the read buffer is ready.
-    status = read8(AS726X_SLAVE_STATUS_REG);
-    if ((status & AS726X_SLAVE_TX_VALID) == 0)
-      // No inbound TX pending at slave. Okay to write now.
-      break;
+bool Adafruit_AS726x::waitStatus(uint8_t mask, bool set) {
+  uint32_t start = millis();
+  while (millis() - start < AS726X_POLL_TIMEOUT_MS) {
+    // Read the slave I²C status until the flag reaches the wanted state.
+    uint8_t status = read8(AS726X_SLAVE_STATUS_REG);
+    if (((status & mask) != 0) == set)
+      return true;
   }
+  _timed_out = true;
+  return false;
+}
+
+uint8_t Adafruit_AS726x::virtualRead(uint8_t addr) {
+  if (_timed_out)
+    return 0;
+  // No inbound TX pending at slave. Okay to write now.
+  if (!waitStatus(AS726X_SLAVE_TX_VALID, false))
+    return 0;
   // Send the virtual register address (setting bit 7 to indicate a pending
   // write).
   write8(AS726X_SLAVE_WRITE_REG, addr);
-  while (1) {
-    // Read the slave I²C status to see if our read data is available.
-    status = read8(AS726X_SLAVE_STATUS_REG);
-    if ((status & AS726X_SLAVE_RX_VALID) != 0)
-      // Read data is ready.
-      break;
-  }
+  // Wait for our read data to be available.
+  if (!waitStatus(AS726X_SLAVE_RX_VALID, true))
+    return 0;
   // Read the data to complete the operation.
-  d = read8(AS726X_SLAVE_READ_REG);
-  return d;
+  return read8(AS726X_SLAVE_READ_REG);
 }
 
 void Adafruit_AS726x::virtualWrite(uint8_t addr, uint8_t value) {
-  volatile uint8_t status;
-  while (1) {
-    // Read slave I²C status to see if the write buffer is ready.
-    status = read8(AS726X_SLAVE_STATUS_REG);
-    if ((status & AS726X_SLAVE_TX_VALID) == 0)
-      // No inbound TX pending at slave. Okay to write now.
-      break;
-  }
+  if (_timed_out)
+    return;
+  // No inbound TX pending at slave. Okay to write now.
+  if (!waitStatus(AS726X_SLAVE_TX_VALID, false))
+    return;
   // Send the virtual register address (setting bit 7 to indicate a pending
   // write).
   write8(AS726X_SLAVE_WRITE_REG, (addr | 0x80));
-  // Serial.print("Address $"); Serial.print(addr, HEX);
-  while (1) {
-    // Read the slave I²C status to see if the write buffer is ready.
-    status = read8(AS726X_SLAVE_STATUS_REG);
-    if ((status & AS726X_SLAVE_TX_VALID) == 0)
-      // No inbound TX pending at slave. Okay to write data now.
-      break;
-  }
+  // Wait for the write buffer to be ready.
+  if (!waitStatus(AS726X_SLAVE_TX_VALID, false))
+    return;
   // Send the data to complete the operation.
   write8(AS726X_SLAVE_WRITE_REG, value);
-  // Serial.print(" = 0x"); Serial.println(value, HEX);
 }
 
 void Adafruit_AS726x::read(uint8_t reg, uint8_t *buf, uint8_t num) {
   uint8_t buffer[1] = {reg};
-  i2c_dev->write_then_read(buffer, 1, buf, num);
+  i2c_dev.write_then_read(buffer, 1, buf, num);
 }
 
 void Adafruit_AS726x::write(uint8_t reg, uint8_t *buf, uint8_t num) {
   uint8_t buffer[1] = {reg};
-  i2c_dev->write(buf, num, true, buffer, 1);
+  i2c_dev.write(buf, num, true, buffer, 1);
 }
@@ -29,6 +29,7 @@
     I2C ADDRESS/BITS
     -----------------------------------------------------------------------*/
 #define AS726x_ADDRESS (0x49) ///< default I2C address
+#define AS726X_POLL_TIMEOUT_MS (50) ///< virtual register handshake deadline
 /*=========================================================================*/
 
 /**************************************************************************/
@@ -213,11 +214,17 @@ public:
       @param addr Optional I2C address the sensor can be found on. Defaults to
      0x49.
   */
-  Adafruit_AS726x(int8_t addr = AS726x_ADDRESS) { _i2caddr = addr; };
-  ~Adafruit_AS726x(void);
+  Adafruit_AS726x(int8_t addr = AS726x_ADDRESS) : i2c_dev(addr) { _i2caddr = addr; };
 
   bool begin(TwoWire *theWire = &Wire);
 
+  /*!
+      @brief  Check if a virtual register access missed its deadline since
+     begin(), the accesses after it are skipped.
+      @return true if an access timed out, false otherwise.
+  */
+  bool timedOut() { return _timed_out; }
+
   /*========= LED STUFF =========*/
 
   // Set indicator LED current
@@ -342,12 +349,14 @@ public:
   /*==== END MEASUREMENTS =====*/
 
 private:
-  Adafruit_I2CDevice *i2c_dev = NULL; ///< Pointer to I2C bus interface
+  Adafruit_I2CDevice i2c_dev;         ///< I2C bus interface
   uint8_t _i2caddr;                   ///< the I2C address of the sensor
+  bool _timed_out = false;            ///< a virtual register access timed out
 
   void write8(byte reg, byte value);
   uint8_t read8(byte reg);
 
+  bool waitStatus(uint8_t mask, bool set);
   uint8_t virtualRead(uint8_t addr);
   void virtualWrite(uint8_t addr, uint8_t value);
 
@@ -46,6 +46,15 @@ void _reset_all_reg(void);
  */
 void _set_reg(const uint8_t addr, const uint8_t val);
 
+/** @brief	Reads consecutive registers in a single request.
+ *
+ *  @param	address of the first register
+ *  @param	buffer to fill
+ *  @param	number of registers, up to BUFFER_LENGTH
+ *  @return	number of registers read
+ */
+uint8_t _get_regs(const uint8_t addr, uint8_t* buf, const uint8_t len);
+
 /** @brief	Gets the value of a register.
  *
  *
@@ -70,6 +79,13 @@ int _set_alarm_mask(uint8_t mask, uint8_t alarm_num);
  */
 void _unix_to_datetime(void);
 
+/** @brief  Fills the datetime fields of the global variable
+ *			ts from the timekeeping registers.
+ *
+ *  @param	registers DS3231_DATETIME_SEC to DS3231_DATETIME_YEAR
+ */
+void _regs_to_datetime(const uint8_t* regs);
+
 /** @brief  This function works with the global variable
  *			ts. It takes the datetime fields to calculate
  *			the unixtime field.
@@ -134,26 +150,87 @@ void DS3231_set_datetime(DS3231_unix_time_t unixtime) {
 	_set_reg(DS3231_DATETIME_YEAR, _dec2bcd(ts.year - TIME_CALC_START_YEAR));
 }
 
-DS3231_unix_time_t DS3231_get_datetime(void) {
+DS3231_unix_time_t DS3231_set_next_alarm(uint32_t period_s) {
+	uint8_t regs[DS3231_REG_COUNT];
+	uint8_t alarm[4];
+	uint8_t first;
 
-	uint8_t sts_reg = _get_reg(DS3231_STATUS_ADDR);
+	if (period_s == 0 || _get_regs(DS3231_DATETIME_SEC, regs, DS3231_REG_COUNT) != DS3231_REG_COUNT) {
+		return 0;
+	}
 
-	if ((sts_reg & DS3231_STATUS_A1F) != 0){
-		_set_reg(DS3231_STATUS_ADDR | DS3231_STATUS_A1F, 0);
+	_regs_to_datetime(regs);
+	_datetime_to_unix();
+
+	DS3231_unix_time_t next = (ts.unixtime / period_s + 1) * period_s;
+	if (next - ts.unixtime < DS3231_ALARM_MIN_LEAD_S) {
+		next += period_s;
 	}
 
-	if ((sts_reg & DS3231_STATUS_A2F) != 0){
-		_set_reg(DS3231_STATUS_ADDR | DS3231_STATUS_A2F, 0);
+	ts.unixtime = next;
+	_unix_to_datetime();
+
+	// A1M1-A1M4 and DY/DT cleared : date, hours, minutes and seconds match.
+	alarm[0] = _dec2bcd(ts.sec);
+	alarm[1] = _dec2bcd(ts.min);
+	alarm[2] = _dec2bcd(ts.hour);
+	alarm[3] = _dec2bcd(ts.day);
+
+	for (first = 0; first < 4 && alarm[first] == regs[DS3231_ALARM1_ADDR + first]; first++);
+
+	// One write from the first changed alarm register to the status
+	// register. Alarm 2 and control registers in between keep their value.
+	Wire.beginTransmission(DS3231_I2C_ADDR);
+	if (first < 4) {
+		Wire.write(DS3231_ALARM1_ADDR + first);
+		Wire.write(alarm + first, 4 - first);
+		Wire.write(regs + DS3231_ALARM2_ADDR, DS3231_CONTROL_ADDR - DS3231_ALARM2_ADDR);
+	} else {
+		Wire.write(DS3231_CONTROL_ADDR);
+	}
+	Wire.write(regs[DS3231_CONTROL_ADDR] | DS3231_CONTROL_A1IE | DS3231_CONTROL_INTCN);
+	Wire.write(regs[DS3231_STATUS_ADDR] & ~(DS3231_STATUS_A1F | DS3231_STATUS_A2F));
+	if (Wire.endTransmission() != 0) {
+		return 0;
 	}
 
+	return next;
+}
+
+uint8_t DS3231_set_minute_alarm(void) {
+	uint8_t err;
+
+	// A1M2-A1M4 set : only the seconds (00) match.
+	Wire.beginTransmission(DS3231_I2C_ADDR);
+	Wire.write(DS3231_ALARM1_ADDR);
+	Wire.write(_dec2bcd(0));
+	Wire.write(DS3231_ALARM_MASK_BIT);
+	Wire.write(DS3231_ALARM_MASK_BIT);
+	Wire.write(DS3231_ALARM_MASK_BIT);
+	err = Wire.endTransmission();
+
+	// Written blind, the registers may not be readable.
+	Wire.beginTransmission(DS3231_I2C_ADDR);
+	Wire.write(DS3231_CONTROL_ADDR);
+	Wire.write(DS3231_CONTROL_A1IE | DS3231_CONTROL_INTCN);
+	Wire.write(0);
+	err |= Wire.endTransmission();
+
+	return (err == 0);
+}
+
+DS3231_unix_time_t DS3231_get_datetime(void) {
+	uint8_t regs[DS3231_REG_COUNT];
 
-	ts.sec = _bcd2dec(_get_reg(DS3231_DATETIME_SEC));
-	ts.min = _bcd2dec(_get_reg(DS3231_DATETIME_MIN));
-	ts.hour = _bcd2dec(_get_reg(DS3231_DATETIME_HOUR));
-	ts.day = _bcd2dec(_get_reg(DS3231_DATETIME_DATE));
-	ts.mon = _bcd2dec(_get_reg(DS3231_DATETIME_MONTH));
-	ts.year = _bcd2dec(_get_reg(DS3231_DATETIME_YEAR)) + TIME_CALC_START_YEAR;
+	if (_get_regs(DS3231_DATETIME_SEC, regs, DS3231_REG_COUNT) != DS3231_REG_COUNT) {
+		return 0;
+	}
+
+	if ((regs[DS3231_STATUS_ADDR] & (DS3231_STATUS_A1F | DS3231_STATUS_A2F)) != 0){
+		_set_reg(DS3231_STATUS_ADDR, regs[DS3231_STATUS_ADDR] & ~(DS3231_STATUS_A1F | DS3231_STATUS_A2F));
+	}
 
+	_regs_to_datetime(regs);
 	_datetime_to_unix();
 
 	return ts.unixtime;
@@ -172,6 +249,26 @@ void _set_reg(const uint8_t addr, const uint8_t val) {
 	Wire.endTransmission();
 }
 
+uint8_t _get_regs(const uint8_t addr, uint8_t* buf, const uint8_t len) {
+	uint8_t n = 0;
+
+	Wire.beginTransmission(DS3231_I2C_ADDR);
+	Wire.write(addr);
+	Wire.endTransmission();
+
+	uint32_t start = millis(); // start timeout
+	while (millis() - start < DS3231_I2C_TIMEOUT_MS) {
+		if (Wire.requestFrom((uint8_t)DS3231_I2C_ADDR, len) == len) {
+			while (n < len) {
+				buf[n++] = Wire.read();
+			}
+			break;
+		}
+	}
+
+	return n;
+}
+
 uint8_t _get_reg(const uint8_t addr) {
 	uint8_t retval = 0;
 
@@ -219,13 +316,15 @@ void _unix_to_datetime(void) {
 	uint16_t year = TIME_CALC_START_YEAR;
 	int i = 0;
 
-	while (seconds > (SECONDS_IN_DAY * DAYS_IN_YEAR)) {
+	while (1) {
 	if (((year % 4) == 0) && (((year % 100) != 0) || ((year % 400) == 0))) {
+		if (seconds < SECONDS_IN_DAY * DAYS_IN_LEAP_YEAR) break;
 		//Serial.print(year); Serial.println("Leap year!");
 		seconds -= SECONDS_IN_DAY * DAYS_IN_LEAP_YEAR;
 		year++;
 	}
 	else {
+		if (seconds < SECONDS_IN_DAY * DAYS_IN_YEAR) break;
 		//Serial.print(year); Serial.println("Normal year...");
 		seconds -= SECONDS_IN_DAY * DAYS_IN_YEAR;
 		year++;
@@ -234,8 +333,11 @@ void _unix_to_datetime(void) {
 
 	ts.year = year;
 
-	while (seconds > (DAYS_IN_MONTH[i] * SECONDS_IN_DAY)) {
-	seconds -= DAYS_IN_MONTH[i++] * SECONDS_IN_DAY;
+	uint8_t leap_year = (((year % 4) == 0) && (((year % 100) != 0) || ((year % 400) == 0)));
+
+	while (seconds >= ((DAYS_IN_MONTH[i] + (i == 1 && leap_year)) * SECONDS_IN_DAY)) {
+	seconds -= (DAYS_IN_MONTH[i] + (i == 1 && leap_year)) * SECONDS_IN_DAY;
+	i++;
 	}
 
 	ts.mon = i + 1;
@@ -247,6 +349,15 @@ void _unix_to_datetime(void) {
 	ts.hour = seconds / SECONDS_IN_HOUR;
 }
 
+void _regs_to_datetime(const uint8_t* regs) {
+	ts.sec = _bcd2dec(regs[DS3231_DATETIME_SEC]);
+	ts.min = _bcd2dec(regs[DS3231_DATETIME_MIN]);
+	ts.hour = _bcd2dec(regs[DS3231_DATETIME_HOUR]);
+	ts.day = _bcd2dec(regs[DS3231_DATETIME_DATE]);
+	ts.mon = _bcd2dec(regs[DS3231_DATETIME_MONTH] & 0x7F);  // Century bit
+	ts.year = _bcd2dec(regs[DS3231_DATETIME_YEAR]) + TIME_CALC_START_YEAR;
+}
+
 void _datetime_to_unix(void) {
 	uint64_t unixtime = ts.sec + (ts.min * SECONDS_IN_MINUTE) + (ts.hour * SECONDS_IN_HOUR);
 	uint8_t leap_year = (((ts.year % 4) == 0) && (((ts.year % 100) != 0) || ((ts.year % 400) == 0)));
@@ -57,6 +57,13 @@
 
 // general info
 #define DS3231_ALARM_COUNT		  (2)
+#define DS3231_REG_COUNT		  (DS3231_STATUS_ADDR + 1)  /* Burst read span */
+
+// minimum delay between the alarm programming and the alarm
+#define DS3231_ALARM_MIN_LEAD_S   (2)
+
+// alarm register bit that leaves the field out of the match (AxMx)
+#define DS3231_ALARM_MASK_BIT     (1 << 7)
 
 // default config : date of month, 24h, no alarms.
 #define DS3231_CONFIG_DEFAULT { 0, 0, NULL, NULL }
@@ -119,9 +126,33 @@ int DS3231_init(DS3231_config* pConfig);
  */
 void DS3231_set_datetime(DS3231_unix_time_t unix_time);
 
+/** @brief	Programs alarm 1 on the next multiple of the period
+ *			following the current time (date, hours, minutes and
+ *			seconds match). The time, alarm, control and status
+ *			registers are burst read, then the alarm 1 registers
+ *			that changed are written in the same transaction as
+ *			the control and status ones, which clears A1F/A2F.
+ *
+ *  @param	period in seconds, up to 28 days
+ *  @return	unix time of the alarm, 0 if the RTC couldn't be
+ *			read or the write wasn't acknowledged
+ */
+DS3231_unix_time_t DS3231_set_next_alarm(uint32_t period_s);
+
+/** @brief	Programs alarm 1 to match every minute at second 00,
+ *			without reading the RTC : the fallback when the next
+ *			alarm couldn't be programmed. The control register is
+ *			set to A1IE | INTCN and the status register cleared
+ *			(A1F, A2F, OSF and the 32 kHz output).
+ *
+ *  @return	1 if both writes were acknowledged, 0 otherwise
+ */
+uint8_t DS3231_set_minute_alarm(void);
+
 /** @brief	Gets the current time in seconds.
  *
- *  @return	seconds since 1 jan 1970
+ *  @return	seconds since 1 jan 1970, 0 if the RTC couldn't
+ *			be read
  */
 DS3231_unix_time_t DS3231_get_datetime(void);
 
@@ -10,10 +10,65 @@
 
 #include "PT100.h"
 
+#include <avr/pgmspace.h>
+
+/*
+ * Compile time generation of the ADC counts to temperature table.
+ * Everything below is constexpr (single expression, C++11) so
+ * only the table ends up in flash.
+ */
+
+/* Square root by Newton iterations */
+constexpr double _pt100_sqrt(double x, double g = 1.0, int n = 32) {
+  return (n == 0 || x <= 0) ? (x <= 0 ? 0 : g) : _pt100_sqrt(x, 0.5 * (g + x / g), n - 1);
+}
+
+/* Resistance seen by the circuit for an ADC count */
+constexpr double _pt100_ohms(double counts) {
+  return PT100_R0 + (counts - PT100_C2) / PT100_GAIN;
+}
+
+/* CVD residual and derivative, C term only below 0 deg C */
+constexpr double _pt100_cvd(double t, double ratio) {
+  return 1.0 + PT100_CVD_A * t + PT100_CVD_B * t * t +
+         (t < 0 ? PT100_CVD_C * (t - 100.0) * t * t * t : 0.0) - ratio;
+}
+constexpr double _pt100_cvd_slope(double t) {
+  return PT100_CVD_A + 2.0 * PT100_CVD_B * t +
+         (t < 0 ? PT100_CVD_C * (4.0 * t * t * t - 300.0 * t * t) : 0.0);
+}
+
+/* Newton refinement of the quadratic solution (exact above 0 deg C) */
+constexpr double _pt100_refine(double t, double ratio, int n = 4) {
+  return n == 0 ? t : _pt100_refine(t - _pt100_cvd(t, ratio) / _pt100_cvd_slope(t), ratio, n - 1);
+}
+constexpr double _pt100_celsius(double ratio) {
+  return _pt100_refine((-PT100_CVD_A + _pt100_sqrt(PT100_CVD_A * PT100_CVD_A -
+                        4.0 * PT100_CVD_B * (1.0 - ratio))) / (2.0 * PT100_CVD_B), ratio);
+}
+
+/* Table entry, rounded to the nearest hundredth of deg C */
+constexpr int16_t _pt100_cdeg(double celsius) {
+  return (int16_t)(celsius * 100.0 + (celsius < 0 ? -0.5 : 0.5));
+}
+#define PT100_LUT(i) _pt100_cdeg(_pt100_celsius(_pt100_ohms((i) << PT100_LUT_SHIFT) / PT100_R0))
+
+#define PT100_LUT_4(i)   PT100_LUT(i), PT100_LUT(i + 1), PT100_LUT(i + 2), PT100_LUT(i + 3)
+#define PT100_LUT_16(i)  PT100_LUT_4(i), PT100_LUT_4(i + 4), PT100_LUT_4(i + 8), PT100_LUT_4(i + 12)
+
+static_assert(PT100_LUT_SIZE == 65, "PT100_LUT initializer expects 64 segments");
+
+constexpr int16_t PT100_LUT_CDEG[PT100_LUT_SIZE] PROGMEM = {
+  PT100_LUT_16(0), PT100_LUT_16(16), PT100_LUT_16(32), PT100_LUT_16(48), PT100_LUT(64)
+};
+
+static_assert(PT100_LUT(0) < 0 && PT100_LUT(PT100_LUT_SIZE - 1) > 0, "PT100_LUT out of range");
+
 PT100::PT100(int pin, float ref) {
   _control_setup.calRef = ref;
   _control_setup.pin = pin;
   _control_setup.rawVal = 0;
+  setCalibration(PT100_C1, PT100_C2);
 }
 
 PT100::~PT100(void) {
@@ -29,6 +84,18 @@ PT100::~PT100(void) {
 /**************************************************************************/
 void PT100::setCalibrationReference(float ref) { _control_setup.calRef = ref; }
 
+/**************************************************************************/
+/*!
+    @brief  Sets the linear calibration of the circuit, T = c1 * (raw - c2)
+    @param  c1 deg C per count
+    @param  c2 count at 0 deg C
+*/
+/**************************************************************************/
+void PT100::setCalibration(float c1, float c2) {
+  _control_setup.calOffset = (int)(c2 + 0.5f);
+  _control_setup.calGain = (uint16_t)(c1 / PT100_C1 * (1 << PT100_CAL_SHIFT) + 0.5f);
+}
+
 /**************************************************************************/
 /*!
     @brief  
@@ -64,12 +131,38 @@ int PT100::getPin(void) { return _control_setup.pin; }
 */
 /**************************************************************************/
 float PT100::readTemperature(void) {
-  _control_setup.rawVal = analogRead(_control_setup.pin);
   // Bits to temperature
-  _control_setup.tempVal = PT100_C1 * (_control_setup.rawVal - PT100_C2); 
+  _control_setup.tempVal = readCentiDegrees() * 0.01f;
   return _control_setup.tempVal;
 }
 
+/**************************************************************************/
+/*!
+    @brief  Reads the ADC and converts it with linear interpolation
+            between the two nearest entries of PT100_LUT_CDEG.
+    @return temperature in hundredths of deg C
+*/
+/**************************************************************************/
+int16_t PT100::readCentiDegrees(void) {
+  _control_setup.rawVal = analogRead(_control_setup.pin);
+
+  int32_t counts = (int16_t)PT100_C2 +
+                   (((int32_t)(_control_setup.rawVal - _control_setup.calOffset) *
+                     _control_setup.calGain) >> PT100_CAL_SHIFT);
+  if (counts < 0) {
+    counts = 0;
+  } else if (counts > PT100_ADC_COUNTS - 1) {
+    counts = PT100_ADC_COUNTS - 1;
+  }
+
+  uint8_t i = counts >> PT100_LUT_SHIFT;
+  uint8_t frac = counts & ((1 << PT100_LUT_SHIFT) - 1);
+  int16_t t0 = pgm_read_word(&PT100_LUT_CDEG[i]);
+  int16_t t1 = pgm_read_word(&PT100_LUT_CDEG[i + 1]);
+
+  return t0 + (int16_t)(((int32_t)(t1 - t0) * frac) >> PT100_LUT_SHIFT);
+}
+
 /**************************************************************************/
 /*!
     @brief  
@@ -16,9 +16,28 @@
 #define PT100_CAL_REF            (float) (2.77)
 #define PT100_DEFAULT_PIN        (A0)           // pins_arduino.h
 
-// Conversion constants
+// Conversion constants (linear fit of the calibration)
 #define PT100_C1                 (float) (0.1516854)
 #define PT100_C2                 (float) (551)
+
+// Callendar-Van Dusen coefficients (IEC 60751)
+#define PT100_R0                 (100.0)
+#define PT100_CVD_A              (3.9083e-3)
+#define PT100_CVD_B              (-5.775e-7)
+#define PT100_CVD_C              (-4.183e-12)
+
+// Circuit model : counts = PT100_C2 + (R - R0) * PT100_GAIN [counts/ohm].
+// The gain is the one giving the slope of the linear fit at 0 deg C.
+#define PT100_GAIN               (1.0 / (PT100_C1 * PT100_R0 * PT100_CVD_A))
+
+// Lookup table : one entry every 2^PT100_LUT_SHIFT ADC counts
+#define PT100_ADC_COUNTS         (1024)
+#define PT100_LUT_SHIFT          (4)
+#define PT100_LUT_SIZE           ((PT100_ADC_COUNTS >> PT100_LUT_SHIFT) + 1)
+
+// Runtime calibration : raw counts are mapped on the nominal
+// C1/C2 of the table with a Q12 gain.
+#define PT100_CAL_SHIFT          (12)
 /**************************************************************************/
 /*!
     @brief  Class that stores state and functions for interacting with PT100
@@ -40,6 +59,14 @@ public:           // Access specifier
       @return
   */
   void setCalibrationReference(float ref);
+  /*!
+      @brief  Sets the linear calibration of the circuit,
+              T = c1 * (raw - c2). The lookup table is kept and
+              the raw counts are corrected before the lookup.
+      @param  c1 deg C per count
+      @param  c2 count at 0 deg C
+  */
+  void setCalibration(float c1, float c2);
   /*!
       @brief
       @return
@@ -60,6 +87,12 @@ public:           // Access specifier
       @return
   */
   float readTemperature(void);
+  /*!
+      @brief  Reads the temperature with the Callendar-Van Dusen
+              lookup table, in integer arithmetic only.
+      @return temperature in hundredths of deg C
+  */
+  int16_t readCentiDegrees(void);
   /*!
       @brief
       @return
@@ -72,6 +105,8 @@ private:
     int pin;
     int rawVal;
     float tempVal;
+    int calOffset;
+    uint16_t calGain;
   } _control_setup;
 };
 
@@ -13,6 +13,8 @@
 Anemometer::Anemometer(int pin) {
 	_control_setup.pin = pin;
 	_control_setup.rawVal = 0;
+	_control_setup.c1 = ANEMO_C1;
+	_control_setup.c2 = ANEMO_C2;
 }
 
 Anemometer::~Anemometer() {
@@ -37,6 +39,18 @@ void Anemometer::setPin(int pin) { _control_setup.pin = pin; }
 /**************************************************************************/
 int Anemometer::getPin() { return _control_setup.pin; }
 
+/**************************************************************************/
+/*!
+    @brief  Sets the linear calibration, speed = c1 * raw - c2
+    @param  c1 m/s per count
+    @param  c2 offset in m/s
+*/
+/**************************************************************************/
+void Anemometer::setCalibration(float c1, float c2) {
+	_control_setup.c1 = c1;
+	_control_setup.c2 = c2;
+}
+
 /**************************************************************************/
 /*!
     @brief
@@ -47,7 +61,7 @@ int Anemometer::getPin() { return _control_setup.pin; }
 float Anemometer::readWindSpeed() {
   _control_setup.rawVal = analogRead(_control_setup.pin);
   // Bits to wind readWindSpeed
-  _control_setup.speed = (_control_setup.rawVal * ANEMO_C1) - ANEMO_C2;
+  _control_setup.speed = (_control_setup.rawVal * _control_setup.c1) - _control_setup.c2;
 
   if(_control_setup.speed < 0) {
   	_control_setup.speed = 0;
@@ -46,6 +46,13 @@ public:              // Access specifier
   */
   int getPin();
 
+  /*!
+    @brief  Sets the linear calibration, speed = c1 * raw - c2
+    @param  c1 m/s per count
+    @param  c2 offset in m/s
+  */
+  void setCalibration(float c1, float c2);
+
   /*!
     @brief
     @return
@@ -58,6 +65,8 @@ private:
     int pin;
     int rawVal;
     float speed;
+    float c1;
+    float c2;
   } _control_setup;
 };
 
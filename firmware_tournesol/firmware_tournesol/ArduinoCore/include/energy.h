@@ -0,0 +1,112 @@
+/*
+ * energy.h
+ *
+ * Created: 2026-10-19 3:05:22 PM
+ *  Author: Alexis Laframboise
+ *
+ *	This module estimates the charge drawn by the station.
+ *	The time each supply rail stays on is measured with
+ *	Timer1 and multiplied by the rail current constants of
+ *	config.h. The charge is accumulated until the next
+ *	health record (see health.h).
+ *
+ *	Timer1 is taken over once the status blinker is disabled.
+ *	It runs at F_CPU / 1024 (64 us per tick at 16 MHz) and
+ *	stops during power down sleep, the sleep charge is then
+ *	estimated from the RTC timestamps.
+ */
+
+#ifndef ENERGY_H_
+#define ENERGY_H_
+
+#include <Arduino.h>
+
+#define ENERGY_TICK_US			(1024000000UL / F_CPU)
+
+typedef enum {
+	ENERGY_RAIL_PT100 = 0,
+	ENERGY_RAIL_HDC1080,
+	ENERGY_RAIL_AS7262,
+	ENERGY_RAIL_RELAY_9V,
+	ENERGY_RAIL_SD,
+	ENERGY_RAIL_CPU,
+	ENERGY_RAIL_SLEEP,		/* Not timed, see energy_add_sleep() */
+	ENERGY_RAIL_COUNT
+} energy_rail_t;
+
+/** @brief	Configures Timer1 as a free running tick counter.
+ *			Must be called after status_blinker_disable().
+ *
+ */
+void energy_init(void);
+
+/** @brief	Gets the Timer1 tick count, extended to 32 bits.
+ *
+ *  @return	ticks since energy_init(), ENERGY_TICK_US each
+ */
+uint32_t energy_ticks(void);
+
+/** @brief	Keeps the ticks at full clock rate when the system
+ *			clock prescaler changes (see clock.h). Called with
+ *			the interrupts disabled.
+ *
+ *  @param	log2 of the new prescaler
+ */
+void energy_clock_shift(uint8_t shift);
+
+/** @brief	Starts and stops the on-time measurement of a rail.
+ *			Calling twice in a row has no effect.
+ *
+ *  @param	rail id
+ */
+void energy_rail_on(uint8_t rail);
+void energy_rail_off(uint8_t rail);
+
+/** @brief	Gets the on-time of a rail during the current (or
+ *			last completed) wake, a rail still on included.
+ *
+ *  @param	rail id
+ *  @return	on-time in ms
+ */
+uint32_t energy_rail_ms(uint8_t rail);
+
+/** @brief	Starts accounting a new wake cycle. The CPU rail
+ *			is turned on.
+ *
+ */
+void energy_begin_wake(void);
+
+/** @brief	Closes the wake cycle : the CPU rail is turned off
+ *			and the charge of every rail is accumulated.
+ *
+ *  @return	charge drawn during the wake, in uC
+ */
+uint32_t energy_end_wake(void);
+
+/** @brief	Accumulates the sleep charge.
+ *
+ *  @param	time spent sleeping, in s
+ */
+void energy_add_sleep(uint32_t sleep_s);
+
+/** @brief	Gets the charge accumulated since the last
+ *			energy_clear().
+ *
+ *  @param	rail id
+ *  @return	charge in uC
+ */
+uint32_t energy_charge_uC(uint8_t rail);
+
+/** @brief	Gets the awake time accumulated since the last
+ *			energy_clear().
+ *
+ *  @return	awake time in ms
+ */
+uint32_t energy_awake_ms(void);
+
+/** @brief	Resets the accumulated charges.
+ *
+ */
+void energy_clear(void);
+
+#endif /* ENERGY_H_ */
@@ -0,0 +1,70 @@
+/*
+ * health.h
+ *
+ * Created: 2026-10-19 3:41:10 PM
+ *  Author: Alexis Laframboise
+ *
+ *	This module builds the health records. A health record
+ *	is saved every HEALTH_PERIOD_WAKES wakes in the data log,
+ *	between the measurement frames. Every record of the log
+ *	starts with its tag : HEALTH_RECORD_TAG, DIAG_RECORD_TAG
+ *	(diag.h) or FRAME_TAG (config.h), then its version and its
+ *	length, so a reader (utils.split_records) tells them apart
+ *	by the first byte and skips to the next one. Only the
+ *	untagged frames of older logs start with the MSB of their
+ *	timestamp, 0.
+ *
+ *	Record : tag, version, length (checksum included), then
+ *	the fields of health_record_t in little endian, then the
+ *	same 16 bits checksum as the measurement frames.
+ */
+
+#ifndef HEALTH_H_
+#define HEALTH_H_
+
+#include <Arduino.h>
+
+#include "energy.h"
+
+#define HEALTH_RECORD_TAG		(0xA5)
+#define HEALTH_RECORD_VERSION	(2)
+
+typedef struct health_record_t{
+	uint8_t tag;
+	uint8_t version;
+	uint8_t len;
+	uint32_t timestamp;						/* Unix time of the last wake */
+	uint16_t wakes;							/* Wakes in the period */
+	uint32_t period_s;						/* Time since the previous record */
+	uint32_t awake_ms;						/* Total awake time */
+	uint32_t charge_uC[ENERGY_RAIL_COUNT];	/* Charge per rail, see energy_rail_t */
+	uint16_t stack_high;					/* Stack high water since boot (version 2) */
+	uint16_t sram_free;						/* Fewest free SRAM bytes since boot (version 2) */
+} health_record_t;
+
+union health_record_bytes {
+	health_record_t record;
+	uint8_t bytes[sizeof(health_record_t)];
+};
+
+#define HEALTH_RECORD_BYTES		(sizeof(health_record_t))
+
+/** @brief	Accounts a wake cycle, once its frame is saved.
+ *			The charge of the wake is only accumulated by
+ *			energy_end_wake(), after the records of the wake :
+ *			it goes to the next health record.
+ *
+ *  @param	unix time of the wake
+ *  @return	1 if a health record is due, 0 otherwise
+ */
+uint8_t health_update(uint32_t timestamp);
+
+/** @brief	Builds the health record of the period and starts
+ *			a new one.
+ *
+ *  @param	a pointer to an array of bytes.
+ *  @return	number of bytes written, checksum excluded
+ */
+uint8_t health_build_record(uint8_t* data);
+
+#endif /* HEALTH_H_ */
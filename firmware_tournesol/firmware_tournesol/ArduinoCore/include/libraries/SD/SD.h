@@ -23,6 +23,11 @@
 #define FILE_READ O_READ
 #define FILE_WRITE (O_READ | O_WRITE | O_CREAT | O_APPEND)
 
+// Files open at the same time, at most 8 (the data log and the trace file)
+#ifndef SD_FILE_SLOTS
+#define SD_FILE_SLOTS 2
+#endif
+
 namespace SDLib {
 
   class File : public Stream {
@@ -36,6 +41,9 @@ namespace SDLib {
       virtual size_t write(uint8_t);
       virtual size_t write(const uint8_t *buf, size_t size);
       virtual int availableForWrite();
+      uint8_t *writeReserve(uint16_t size, uint8_t pad);
+      boolean writeCommit(uint16_t size);
+      boolean contiguousRange(uint32_t *bgnBlock, uint32_t *endBlock);
       virtual int read();
       virtual int peek();
       virtual int available();
@@ -82,6 +90,9 @@ namespace SDLib {
         return open(filename.c_str(), mode);
       }
 
+      // Create a file whose blocks are contiguous, in the root directory.
+      File createContiguous(const char *filepath, uint32_t size);
+
       // Methods to determine if the requested file path exists.
       boolean exists(const char *filepath);
       boolean exists(const String &filepath) {
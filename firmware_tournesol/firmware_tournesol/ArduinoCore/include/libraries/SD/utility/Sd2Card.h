@@ -114,6 +114,8 @@ unsigned int const SD_ERASE_TIMEOUT = 10000;
 unsigned int const SD_READ_TIMEOUT = 300;
 /** write time out ms */
 unsigned int const SD_WRITE_TIMEOUT = 600;
+/** busy time polled at full clock, a block program, ms */
+unsigned int const SD_BUSY_SPIN_MS = 2;
 //------------------------------------------------------------------------------
 // SD card errors
 /** timeout error for command CMD0 */
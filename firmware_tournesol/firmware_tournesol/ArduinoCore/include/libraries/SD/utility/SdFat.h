@@ -330,6 +330,8 @@ class SdFile : public Print {
     size_t write(uint8_t b);
     size_t write(const void* buf, uint16_t nbyte);
     size_t write(const char* str);
+    uint8_t* writeReserve(uint16_t nbyte, uint8_t pad);
+    uint8_t writeCommit(uint16_t nbyte);
     #ifdef __AVR__
     void write_P(PGM_P str);
     void writeln_P(PGM_P str);
@@ -444,12 +446,15 @@ class SdFile : public Print {
     uint8_t   dirIndex_;      // index of entry in dirBlock 0 <= dirIndex_ <= 0XF
     uint32_t  fileSize_;      // file size in bytes
     uint32_t  firstCluster_;  // first cluster of file
+    uint32_t  reserveBlock_;  // block of the pending writeReserve()
     SdVolume* vol_;           // volume where file is located
 
     // private functions
     uint8_t addCluster(void);
     uint8_t addDirCluster(void);
     dir_t* cacheDirEntry(uint8_t action);
+    uint8_t* cacheWriteBlock(uint32_t block);
+    uint8_t seekWriteBlock(uint32_t* block);
     static void (*dateTime_)(uint16_t* date, uint16_t* time);
     static uint8_t make83Name(const char* str, uint8_t* name);
     uint8_t openCachedEntry(uint8_t cacheIndex, uint8_t oflags);
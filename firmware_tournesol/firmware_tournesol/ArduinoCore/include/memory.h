@@ -11,6 +11,8 @@
 #ifndef MEMORY_H_
 #define MEMORY_H_
 
+#include "common.h"
+
 /** @brief	Initializes the memory related peripheral.
  *
  *
@@ -18,14 +20,35 @@
  */
 int init_memory(void);
 
-/** @brief	Saves
+/** @brief	Reserves the room of a frame in the SD block cache,
+ *			at the end of the data log (SAVE_FILE_NAME, or the
+ *			stream file with SD_STREAM_EN). The frame is built
+ *			in place, there is no other copy of it. The SPI
+ *			must be clocked (POWER_PHASE_SD).
+ *
+ *			A frame doesn't span two blocks : when the block
+ *			can't hold one more, its end is padded (FRAME_PAD).
+ *			Without a card, the cache is still the buffer.
  *
+ *  @return	the frame buffer, valid until memory_frame_end()
+ */
+frame_t& memory_frame_begin(void);
+
+/** @brief	Saves the frame built since memory_frame_begin().
+ *			Its block is written to the card right away, or
+ *			once full with SD_STREAM_EN.
+ *
+ *  @param	number of bytes of the frame
+ */
+void memory_frame_end(uint8_t len);
+
+/** @brief	Updates the directory entry (size) of the data
+ *			log after the frames of a wake, so they outlive a
+ *			reset. Must be called once the frames of the wake
+ *			aren't used anymore, the block cache is reused.
  *
- *  @param	file name to save the data to
- *  @param	pointer to the first data byte
- *  @param	number of bytes to save
  */
-void save_frame(char* fname, uint8_t* data, uint8_t len);
+void memory_sync(void);
 
 
 #endif /* MEMORY_H_ */
\ No newline at end of file
@@ -21,19 +21,43 @@
 #include "drivers/PT100.h"
 #include "drivers/anemometer.h"
 
-/** @brief	Runs the init function for every
- *			module
+/** @brief	Applies the settings (schedule) to the modules.
+ *			Must be called after settings_init().
  *
+ */
+void modules_configure(void);
+
+/** @brief	Finds the enabled modules due at a wake and
+ *			schedules their next reading. The AS7262 isn't
+ *			due while it is dark (AS7262_DARK_GATING_EN).
+ *
+ *  @param	unix time of the wake
+ *  @param	FRAME_FLAG_* bits to add to the frame
+ *  @return	MODULE_* bits of the modules due
+ */
+uint8_t modules_due(uint32_t timestamp, uint8_t* flags);
+
+/** @brief	Runs the init function of the modules, their
+ *			rails are switched on and left on.
+ *
+ *  @param	MODULE_* bits of the modules to init
  *  @return error code
  */
-int init_modules(void);
+int init_modules(uint8_t modules);
 
-/** @brief	Runs the read function for every
- *			module
+/** @brief	Powers, inits and reads the modules one after the
+ *			other following a power plan (see power.h), their
+ *			measurements are packed in registry order from
+ *			FRAME_MEAS_OFFSET. A module that fails is left
+ *			out of the frame and the next ones are still read,
+ *			every rail is off on return.
  *
- *  @param	a pointer to an array of bytes.
- *  @return	error code
+ *  @param	frame buffer
+ *  @param	MODULE_* bits of the modules to read, those read
+ *			on return
+ *  @param	error codes of the failed modules
+ *  @return	number of bytes read
  */
-int exec_modules(uint8_t* data);
+uint8_t exec_modules(frame_t& frame, uint8_t* modules, int* err);
 
 #endif /* MODULES_H_ */
\ No newline at end of file
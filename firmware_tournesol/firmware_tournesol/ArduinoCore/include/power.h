@@ -0,0 +1,108 @@
+/*
+ * power.h
+ *
+ * Created: 2026-10-19 4:41:08 PM
+ *  Author: Alexis Laframboise
+ *
+ *	This module manages the supply rail of each module
+ *	(power domain). Instead of powering every rail for the
+ *	whole wake, a plan gives each rail its own window : it
+ *	is switched on just soon enough for its warm-up to end
+ *	when its module is read, and off as soon as the read is
+ *	done. The warm-ups of the rails overlap the reads of the
+ *	modules before them.
+ *
+ *	The rails are in registry order, the anemometer rail
+ *	is the 9V relay.
+ *
+ *	It also gates the clock of the MCU peripherals (PRR)
+ *	by phase : only the TWI and the ADC while talking to
+ *	the sensors, only the SPI while writing to the SD card,
+ *	only the USART while sending telemetry, none while
+ *	sleeping. Sertools/power_model.py estimates the current
+ *	of each phase from the same table.
+ */
+
+#ifndef POWER_H_
+#define POWER_H_
+
+#include <Arduino.h>
+
+typedef enum {
+	POWER_RAIL_AS7262 = 0,
+	POWER_RAIL_HDC1080,
+	POWER_RAIL_PT100,
+	POWER_RAIL_RELAY_9V,
+	POWER_RAIL_COUNT
+} power_rail_t;
+
+typedef enum {
+	POWER_PHASE_SLEEP = 0,
+	POWER_PHASE_SENSORS,		/* RTC and sensors : TWI, ADC */
+	POWER_PHASE_SD,				/* SD card : SPI */
+	POWER_PHASE_SERIAL,			/* Telemetry : USART */
+	POWER_PHASE_COUNT
+} power_phase_t;
+
+/** @brief	Configures the rail pins, every rail is off. The
+ *			analog comparator and the digital input buffers
+ *			of the analog pins are disabled for good.
+ *
+ */
+void power_init(void);
+
+/** @brief	Gates the clock of the peripherals unused in a
+ *			phase. A peripheral is shut down before being
+ *			gated and initialized again once clocked. The
+ *			USART stays on when serial debugging is enabled,
+ *			except while sleeping.
+ *
+ *  @param	phase id
+ */
+void power_phase(uint8_t phase);
+
+/** @brief	Switches a rail on or off right away. Calling
+ *			twice in a row has no effect.
+ *
+ *  @param	rail id
+ */
+void power_on(uint8_t rail);
+void power_off(uint8_t rail);
+
+/** @brief	Switches every rail off and drops the plan.
+ *
+ */
+void power_all_off(void);
+
+/** @brief	Plans the switch-on time of the rails of a wake
+ *			from their warm-up and the read time estimates
+ *			of config.h. The rails due now are switched on.
+ *
+ *  @param	MODULE_* bits of the modules read, in registry order
+ */
+void power_plan(uint8_t modules);
+
+/** @brief	Waits until a rail is warmed up, switching on the
+ *			planned rails whose time has come meanwhile.
+ *			The rail is switched on if it isn't yet.
+ *
+ *  @param	rail id
+ */
+void power_ready(uint8_t rail);
+
+/** @brief	Switches a rail off once its module is read, and
+ *			the planned rails whose time has come on.
+ *
+ *  @param	rail id
+ */
+void power_done(uint8_t rail);
+
+/** @brief	Gets the time a rail was on since the last
+ *			power_plan(), for benchmarking.
+ *
+ *  @param	rail id
+ *  @return	on-time in ms
+ */
+uint16_t power_on_ms(uint8_t rail);
+
+#endif /* POWER_H_ */
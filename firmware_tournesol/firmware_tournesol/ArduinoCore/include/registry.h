@@ -0,0 +1,80 @@
+/*
+ * registry.h
+ *
+ * Created: 2026-10-19 6:02:15 PM
+ *  Author: Alexis Laframboise
+ *
+ *	Compile-time view of the sensor registry (SENSOR_REGISTRY
+ *	of config.h) : sensor ids, the layout of their slot in the
+ *	frame and the frame size. Everything here is constexpr, the
+ *	buffer sizes and their bounds follow the registry alone.
+ */
+
+#ifndef REGISTRY_H_
+#define REGISTRY_H_
+
+#include <Arduino.h>
+
+#include "config.h"
+
+#define SENSOR_ID(name, channels, meta)		SENSOR_##name,
+#define SENSOR_LAYOUT(name, channels, meta)	{channels, meta},
+
+typedef enum {
+	SENSOR_REGISTRY(SENSOR_ID)
+	SENSOR_COUNT
+} sensor_id_t;
+
+typedef struct sensor_layout_t{
+	uint8_t channels;		/* Floats, saved first */
+	uint8_t meta_bytes;		/* Saved after the floats */
+} sensor_layout_t;
+
+constexpr sensor_layout_t sensor_layout[SENSOR_COUNT] = {
+	SENSOR_REGISTRY(SENSOR_LAYOUT)
+};
+
+/** @brief	Gets the size of the slot of a sensor in the frame.
+ *
+ *  @param	sensor id
+ *  @return	number of bytes
+ */
+constexpr uint8_t sensor_meas_bytes(uint8_t id){
+	return sensor_layout[id].channels * sizeof(float) + sensor_layout[id].meta_bytes;
+}
+
+/** @brief	Gets the size of the measurements of a frame.
+ *
+ *  @param	MODULE_* bits of the modules present
+ *  @param	first sensor id counted
+ *  @return	number of bytes
+ */
+constexpr uint16_t sensor_frame_bytes(uint8_t modules, uint8_t id = 0){
+	return id == SENSOR_COUNT ? 0 :
+		((modules & bit(id)) ? sensor_meas_bytes(id) : 0) + sensor_frame_bytes(modules, id + 1);
+}
+
+/** @brief	Gets the number of float channels of a frame.
+ *
+ *  @param	MODULE_* bits of the modules present
+ *  @param	first sensor id counted
+ *  @return	number of channels
+ */
+constexpr uint8_t sensor_frame_channels(uint8_t modules, uint8_t id = 0){
+	return id == SENSOR_COUNT ? 0 :
+		((modules & bit(id)) ? sensor_layout[id].channels : 0) + sensor_frame_channels(modules, id + 1);
+}
+
+#define TOTAL_MEAS_BYTES		(sensor_frame_bytes(MODULE_ALL))
+#define TOTAL_MEAS_CHANNELS		(sensor_frame_channels(MODULE_ALL))
+
+/* Room of the biggest frame */
+typedef uint8_t frame_t[FRAME_MAX_BYTES];
+
+#define SENSOR_MODULE_BIT(name, channels, meta)	\
+	static_assert(MODULE_##name == bit(SENSOR_##name), "MODULE_" #name " doesn't match the registry");
+
+SENSOR_REGISTRY(SENSOR_MODULE_BIT)
+static_assert(MODULE_COUNT == SENSOR_COUNT, "MODULE_COUNT doesn't match the registry");
+
+#endif /* REGISTRY_H_ */
@@ -22,4 +22,17 @@
  */
 int rtc_init(void);
 
+/** @brief	Programs the next wake on the next multiple of the
+ *			sampling period. With ADAPTIVE_SAMPLING_EN, the period
+ *			depends on how fast the measurements changed since
+ *			the previous sample. Does nothing without a period.
+ *			If the alarm can't be programmed, the station wakes
+ *			every minute until it can.
+ *
+ *  @param	unix time of the sample, 0 if it couldn't be read
+ *  @param	pointer to the measurements of the frame
+ *  @param	MODULE_* bits of the modules in the frame
+ */
+void rtc_schedule_next(uint32_t timestamp, const uint8_t* meas, uint8_t modules);
+
 #endif /* RTC_H_ */
\ No newline at end of file
@@ -0,0 +1,80 @@
+/*
+ * sdstream.h
+ *
+ * Created: 2026-10-19 7:58:14 PM
+ *  Author: Alexis Laframboise
+ *
+ *	This module streams the frames to a contiguous file
+ *	(SD_STREAM_FILE_NAME) preallocated once, or to a raw
+ *	partition (SD_STREAM_RAW), without the FAT updates of a
+ *	file write. The first block of the region is a superblock
+ *	which tells where the data blocks are, the host finds the
+ *	log with it in a raw image of the card (stream_extract.py).
+ *
+ *	The region is erased when the superblock is written, then
+ *	its blocks are written in order
+ *	with a single multiple block write (CMD25) that stays
+ *	open across the wakes : a block costs one data transfer,
+ *	its programming happens while the station sleeps and
+ *	the whole region is worn evenly.
+ *
+ *	A block is built in the SD cache and written once full,
+ *	the frames of the block being built are lost on a reset.
+ *	Nothing else may use the SD cache once the stream is
+ *	started (no trace file).
+ *
+ *	Each block holds a sequence number and a CRC : the written
+ *	blocks are the valid ones numbered in order from the first
+ *	block of the region, an erased block, a block torn by a
+ *	reset or one left by an older log isn't. The tail of the
+ *	log is found again at boot by a binary search over the
+ *	region, in log2(SD_STREAM_BLOCKS) block reads.
+ */
+
+#ifndef SDSTREAM_H_
+#define SDSTREAM_H_
+
+#include "common.h"
+
+/* Block : tag, sequence number (32 bits, little endian), the
+   records padded with FRAME_PAD, then the CRC-16/XMODEM of
+   the rest of the block (big endian). */
+#define STREAM_BLOCK_TAG		(0xB5)
+#define STREAM_HEADER_BYTES		(5)
+#define STREAM_CRC_BYTES		(2)
+#define STREAM_PAYLOAD_END		(SD_BLOCK_BYTES - STREAM_CRC_BYTES)
+
+/* Superblock : magic, layout version, address and count of the
+   data blocks (32 bits, little endian), zeros, then the CRC as
+   for a data block. */
+#define STREAM_MAGIC			("TSLG")
+#define STREAM_LAYOUT_VERSION	(1)
+
+/** @brief	Finds the stream region, creates the file if needed,
+ *			formats the region if its superblock is blank or
+ *			describes another region, and finds the block after
+ *			the last valid one.
+ *
+ *  @return	error code, ERROR_SD if the superblock can't be
+ *			read or is damaged (the region is left as is)
+ */
+int sdstream_init(void);
+
+/** @brief	Reserves the room of a frame in the block being
+ *			built.
+ *
+ *  @return	the frame buffer, NULL if the stream isn't started
+ *			or the region is full
+ */
+uint8_t* sdstream_reserve(void);
+
+/** @brief	Adds the frame built in the reserved room to the
+ *			block. The block is padded (FRAME_PAD), numbered,
+ *			sealed with its CRC and written once it can't hold
+ *			one more frame.
+ *
+ *  @param	number of bytes of the frame
+ */
+void sdstream_commit(uint8_t len);
+
+#endif /* SDSTREAM_H_ */
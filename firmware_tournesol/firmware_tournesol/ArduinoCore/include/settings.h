@@ -0,0 +1,80 @@
+/*
+ * settings.h
+ *
+ * Created: 2026-10-19 4:52:18 PM
+ *  Author: Alexis Laframboise
+ *
+ *	This module holds the calibration and the station
+ *	configuration that used to be compile time only.
+ *	A settings block (SETTINGS_FILE_NAME) found on the SD
+ *	card at boot is validated and copied in EEPROM, then the
+ *	block in EEPROM is used. If none is valid, the defaults
+ *	of config.h and of the drivers are used.
+ *
+ *	The block is generated on the host from the calibration
+ *	captures of tests/ with Sertools/settings_generator.py.
+ *	Block : the fields of settings_t in little endian, the
+ *	last one being the CRC16 XMODEM of the others.
+ */
+
+#ifndef SETTINGS_H_
+#define SETTINGS_H_
+
+#include <Arduino.h>
+
+#include "config.h"
+#include "drivers/Adafruit_AS726x.h"
+
+#define SETTINGS_TAG			(0xC5)
+#define SETTINGS_VERSION		(3)
+
+typedef struct settings_t{
+	uint8_t tag;
+	uint8_t version;
+	uint8_t len;									/* CRC included */
+	uint8_t sensors;								/* Enabled modules, MODULE_* bits */
+	uint8_t alarm1_mask;
+	uint8_t alarm1_sec;
+	uint8_t alarm1_min;
+	uint8_t alarm1_hour;
+	uint8_t alarm2_mask;
+	uint8_t alarm2_min;
+	uint8_t alarm2_hour;
+	uint16_t period_s;								/* 0 : alarm match modes */
+	uint16_t period_max_s;							/* Adaptive sampling */
+	uint16_t module_period_s[MODULE_COUNT];
+	uint16_t module_phase_s[MODULE_COUNT];
+	float as7262_dark_offset[AS726x_NUM_CHANNELS];
+	float as7262_diffuser_multiplier[AS726x_NUM_CHANNELS];
+	float pt100_c1;
+	float pt100_c2;
+	float anemo_c1;
+	float anemo_c2;
+	uint16_t crc;
+} settings_t;
+
+union settings_bytes {
+	settings_t settings;
+	uint8_t bytes[sizeof(settings_t)];
+};
+
+#define SETTINGS_BYTES			(sizeof(settings_t))
+
+extern settings_t settings;
+
+/** @brief	Loads the settings block of the SD card in EEPROM,
+ *			then the one of EEPROM in settings. Must be called
+ *			after init_memory() and before the modules and the
+ *			RTC are initialized.
+ *
+ *			A corrupted block on the SD card falls back on the
+ *			one in EEPROM. Without a valid block in EEPROM, the
+ *			compiled defaults are kept.
+ *
+ *  @return	error code, ERROR_SETTINGS if the block of the SD
+ *			card is corrupted and EEPROM holds no valid one :
+ *			the station runs on the compiled defaults
+ */
+int settings_init(void);
+
+#endif /* SETTINGS_H_ */
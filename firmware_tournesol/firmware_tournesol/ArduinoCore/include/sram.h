@@ -0,0 +1,53 @@
+/*
+ * sram.h
+ *
+ * Created: 2026-10-19 8:41:27 PM
+ *  Author: Alexis Laframboise
+ *
+ *	This module reports the SRAM use of the station. The heap
+ *	must stay empty : nothing is allocated after the setup and
+ *	the SD files use static slots (SD_FILE_SLOTS), so a heap
+ *	that grows means a leak or a library allocating behind
+ *	our back.
+ *
+ *	The free SRAM, between the end of .bss and the top of the
+ *	stack, is painted with SRAM_PAINT at boot, before the C
+ *	runtime init. The stack high water mark is the lowest
+ *	byte no longer painted. The static part (.data, .bss) is
+ *	detailed per symbol on the host by Sertools/sram_map.py.
+ */
+
+#ifndef SRAM_H_
+#define SRAM_H_
+
+#include <Arduino.h>
+
+#define SRAM_PAINT		(0xC5)
+
+/** @brief	Heap high water mark since boot, sampled at each
+ *			call.
+ *
+ *  @return	bytes, 0 if the heap was never used
+ */
+uint16_t sram_heap_high(void);
+
+/** @brief	Stack high water mark since boot.
+ *
+ *  @return	bytes
+ */
+uint16_t sram_stack_high(void);
+
+/** @brief	Fewest free bytes left between the heap and the
+ *			stack since boot.
+ *
+ *  @return	bytes
+ */
+uint16_t sram_free_low(void);
+
+/** @brief	Prints the SRAM use on the serial port : static
+ *			data, heap, stack and free bytes.
+ *
+ */
+void sram_dump(void);
+
+#endif /* SRAM_H_ */
@@ -22,6 +22,14 @@
  */
 void signal_error(int err);
 
+/** @brief	Flashes the code of an error a few times
+ *			(SIGNAL_WARNING_REPEAT) and returns, for the
+ *			errors the station runs with.
+ *
+ *  @param	error code
+ */
+void signal_warning(int err);
+
 /** @brief	Will make the LED indicator flash repeatedly
  *			via an interrupt.
  *
@@ -0,0 +1,33 @@
+/*
+ * telemetry.h
+ *
+ * Created: 2026-10-19 1:47:05 PM
+ *  Author: Alexis Laframboise
+ *
+ *	This module streams the frames on the serial port
+ *	as binary packets for live monitoring of a station.
+ *
+ *	Packet : COBS(frame bytes + CRC16 XMODEM, MSB first) + 0x00.
+ *	The frame bytes are the same as the ones saved on the
+ *	SD card, so the host can decode both the same way
+ *	(see Interface_Python/live_stream.py).
+ */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <Arduino.h>
+
+#define TELEMETRY_CRC_BYTES		(2)
+#define TELEMETRY_DELIMITER		(0x00)
+
+/** @brief	Sends a frame as a COBS encoded packet. The bytes
+ *			are queued in the HardwareSerial TX buffer and
+ *			shifted out by the UDRE interrupt.
+ *
+ *  @param	pointer to the first frame byte
+ *  @param	number of bytes in the frame (max 252)
+ */
+void telemetry_send_frame(const uint8_t* data, uint8_t len);
+
+#endif /* TELEMETRY_H_ */
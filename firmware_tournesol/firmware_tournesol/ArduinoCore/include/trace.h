@@ -0,0 +1,133 @@
+/*
+ * trace.h
+ *
+ * Created: 2026-10-19 9:12:40 AM
+ *  Author: Alexis Laframboise
+ *
+ *	This module is a lightweight execution tracer. Each
+ *	traced function pushes an (event id, tick) pair in a
+ *	fixed ring buffer instead of printing its name on the
+ *	serial port. The buffer can be dumped on the serial port
+ *	or appended to a file on the SD card and decoded on the
+ *	host with Sertools/trace_decoder.py. The station only
+ *	appends the trace of a wake with a failed module, the
+ *	file doesn't grow with every wake.
+ *
+ *	Event ids are explicit so that a trace saved by an older
+ *	firmware can still be decoded. Never reuse an id, only
+ *	append new ones.
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <Arduino.h>
+
+#include "config.h"
+
+/* Record : magic, entry count, the entries oldest first, then
+ * the 16 bits sum of the count and entry bytes, little endian.
+ * A reader resyncs on the magic and checks the sum. */
+#define TRACE_RECORD_MAGIC		("TR")
+#define TRACE_MAGIC_BYTES		(2)
+#define TRACE_ENTRY_BYTES		(3)
+
+/* Tick source of the tracer, in ms. Wraps every ~65 s which
+ * is way longer than a wake cycle. */
+#define TRACE_TICKS()			((uint16_t)millis())
+
+typedef enum {
+	TRACE_EV_NONE					= 0,
+	TRACE_EV_MAIN_LOOP				= 1,
+	TRACE_EV_INIT_SETUP				= 2,
+	TRACE_EV_INIT_RELAY				= 3,
+	TRACE_EV_ACTIVATE_RELAY			= 4,
+	TRACE_EV_DEACTIVATE_RELAY		= 5,
+	TRACE_EV_INIT_INSTRUMENTS		= 6,
+	TRACE_EV_ACTIVATE_INSTRUMENTS	= 7,
+	TRACE_EV_DEACTIVATE_INSTRUMENTS	= 8,
+	TRACE_EV_CHECKSUM				= 9,
+	TRACE_EV_GOTO_SLEEP				= 10,
+	TRACE_EV_WAKE					= 11,
+	TRACE_EV_INIT_MODULES			= 12,
+	TRACE_EV_EXEC_MODULES			= 13,
+	TRACE_EV_AS7262_INIT			= 14,
+	TRACE_EV_HDC1080_INIT			= 15,
+	TRACE_EV_PT100_INIT				= 16,
+	TRACE_EV_ANEMOMETER_INIT		= 17,
+	TRACE_EV_AS7262_READ			= 18,
+	TRACE_EV_HDC1080_READ			= 19,
+	TRACE_EV_PT100_READ				= 20,
+	TRACE_EV_ANEMOMETER_READ		= 21,
+	TRACE_EV_DS3231_INIT			= 22,
+	TRACE_EV_INIT_MEMORY			= 23,
+	TRACE_EV_SD_INIT				= 24,
+	TRACE_EV_SAVE_FRAME				= 25,
+	TRACE_EV_SIGNAL_ERROR			= 26,
+	TRACE_EV_BLINKER_INIT			= 27,
+	TRACE_EV_BLINKER_DISABLE		= 28,
+	TRACE_EV_SETTINGS_INIT			= 29,
+	TRACE_EV_BUS_RECOVER			= 30,
+	TRACE_EV_MODULE_MISSING			= 31,
+	TRACE_EV_STREAM_INIT			= 32,
+	TRACE_EV_STREAM_WRITE			= 33,
+} trace_event_t;
+
+typedef struct trace_entry_t{
+	uint8_t event;
+	uint16_t ticks;
+} trace_entry_t;
+
+#if TRACE_EN
+
+#if (TRACE_BUFFER_LEN & (TRACE_BUFFER_LEN - 1)) || (TRACE_BUFFER_LEN > 128)
+#error "TRACE_BUFFER_LEN must be a power of 2 no greater than 128"
+#endif
+
+extern trace_entry_t trace_buffer[TRACE_BUFFER_LEN];
+extern uint8_t trace_head;
+extern uint8_t trace_count;
+
+/** @brief	Pushes an event in the trace ring buffer. The oldest
+ *			entry is overwritten when the buffer is full.
+ *			Not meant to be called from an interrupt.
+ *
+ *  @param	event id
+ */
+static inline void trace_event(uint8_t event){
+	trace_entry_t* e = &trace_buffer[trace_head];
+	e->event = event;
+	e->ticks = TRACE_TICKS();
+	trace_head = (trace_head + 1) & (TRACE_BUFFER_LEN - 1);
+	if (trace_count < TRACE_BUFFER_LEN){
+		trace_count++;
+	}
+}
+
+#define TRACE(ev)		trace_event(ev)
+
+#else
+
+#define TRACE(ev)
+
+#endif /* TRACE_EN */
+
+/** @brief	Empties the trace buffer.
+ *
+ */
+void trace_clear(void);
+
+/** @brief	Writes the trace record, oldest entry first, on the
+ *			serial port. The buffer is left untouched.
+ *
+ */
+void trace_dump(void);
+
+/** @brief	Appends the trace record to a file on the SD card
+ *			and empties the buffer.
+ *
+ *  @param	file name to append the record to
+ */
+void trace_save(const char* fname);
+
+#endif /* TRACE_H_ */
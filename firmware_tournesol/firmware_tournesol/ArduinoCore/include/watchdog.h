@@ -0,0 +1,41 @@
+/*
+ * watchdog.h
+ *
+ * Created: 2026-10-19 6:52:10 PM
+ *  Author: Alexis Laframboise
+ *
+ *	This module arms the hardware watchdog for each wake
+ *	cycle. A wake that hangs anyway resets the station,
+ *	which starts sampling again on its own. The watchdog
+ *	is off while sleeping, the RTC alarm wakes the station.
+ */
+
+#ifndef WATCHDOG_H_
+#define WATCHDOG_H_
+
+#include <Arduino.h>
+
+/** @brief	Arms the watchdog (WATCHDOG_TIMEOUT).
+ *
+ */
+void watchdog_begin_wake(void);
+
+/** @brief	Restarts the watchdog timeout, between the steps
+ *			of a wake.
+ *
+ */
+void watchdog_kick(void);
+
+/** @brief	Disarms the watchdog before sleeping.
+ *
+ */
+void watchdog_end_wake(void);
+
+/** @brief	Gets the reset flags (MCUSR) of the last reset,
+ *			WDRF tells a watchdog reset.
+ *
+ *  @return	MCUSR at boot
+ */
+uint8_t watchdog_reset_flags(void);
+
+#endif /* WATCHDOG_H_ */
@@ -0,0 +1,72 @@
+/*
+ * bus.cpp
+ *
+ * Created: 2026-10-19 6:47:32 PM
+ *  Author: Alexis Laframboise
+ */
+
+#include <Wire.h>
+
+#include "bus.h"
+#include "common.h"
+#include "diag.h"
+
+#define BUS_HALF_PERIOD_US	(5)		/* 100 kHz */
+
+/** @brief	Drives a bus line low, or releases it to its pull-up
+ *			(open drain).
+ *
+ *  @param	pin of the line
+ *  @param	0 to drive it low, 1 to release it
+ */
+static void _bus_line(uint8_t pin, uint8_t high){
+	if (high){
+		pinMode(pin, INPUT_PULLUP);
+	} else {
+		digitalWrite(pin, LOW);
+		pinMode(pin, OUTPUT);
+	}
+	delayMicroseconds(BUS_HALF_PERIOD_US);
+}
+
+void bus_init(void){
+	Wire.setWireTimeout(BUS_TWI_TIMEOUT_US, true);
+}
+
+uint8_t bus_recover(void){
+	TRACE(TRACE_EV_BUS_RECOVER);
+
+	Wire.end();
+
+	_bus_line(SDA, 1);
+	_bus_line(SCL, 1);
+
+	// A slave in the middle of a byte releases SDA within 9 clocks.
+	for (uint8_t i = 0; i < BUS_RECOVERY_CLOCKS && !digitalRead(SDA); i++){
+		_bus_line(SCL, 0);
+		_bus_line(SCL, 1);
+	}
+
+	// STOP : SDA rises while SCL is high.
+	_bus_line(SCL, 0);
+	_bus_line(SDA, 0);
+	_bus_line(SCL, 1);
+	_bus_line(SDA, 1);
+
+	uint8_t released = digitalRead(SDA);
+
+	Wire.begin();
+	Wire.clearWireTimeoutFlag();
+
+	diag_bus_recovered(released);
+
+	return released;
+}
+
+uint8_t bus_failed(void){
+	if (!Wire.getWireTimeoutFlag()){
+		return 0;
+	}
+	bus_recover();
+	return 1;
+}
@@ -0,0 +1,44 @@
+/*
+ * clock.cpp
+ *
+ * Created: 2026-10-19 5:26:47 PM
+ *  Author: Alexis Laframboise
+ */
+
+#include <avr/interrupt.h>
+
+#include "clock.h"
+#include "energy.h"
+#include "common.h"
+
+extern "C" void timer0_set_clock_shift(unsigned char shift);
+
+void clock_prescale(uint8_t shift){
+	uint8_t sreg = SREG;
+	cli();
+	timer0_set_clock_shift(shift);
+	energy_clock_shift(shift);
+
+	// CLKPS must be written within 4 cycles of CLKPCE.
+	CLKPR = bit(CLKPCE);
+	CLKPR = shift;
+	SREG = sreg;
+}
+
+void clock_wait_ms(uint16_t ms){
+#if CLOCK_WAIT_EN
+	if (ms >= CLOCK_WAIT_MIN_MS){
+#if SERIAL_EN
+		// The baud rate follows the clock.
+		if (!(PRR & bit(PRUSART0))){
+			Serial.flush();
+		}
+#endif
+		clock_prescale(CLOCK_WAIT_SHIFT);
+		delay(ms);
+		clock_prescale(0);
+		return;
+	}
+#endif
+	delay(ms);
+}
@@ -39,6 +39,12 @@ volatile unsigned long timer0_overflow_count = 0;
 volatile unsigned long timer0_millis = 0;
 static unsigned char timer0_fract = 0;
 
+// log2 of the system clock prescaler (CLKPR), timer0 ticks are
+// 2^shift times longer. The ticks counted before a change that
+// don't make a whole overflow are kept in timer0_partial.
+volatile unsigned char timer0_clock_shift = 0;
+static unsigned int timer0_partial = 0;
+
 #if defined(TIM0_OVF_vect)
 ISR(TIM0_OVF_vect)
 #else
@@ -49,17 +55,51 @@ ISR(TIMER0_OVF_vect)
 	// (volatile variables must be read from memory on every access)
 	unsigned long m = timer0_millis;
 	unsigned char f = timer0_fract;
+	unsigned char s = timer0_clock_shift;
 
-	m += MILLIS_INC;
-	f += FRACT_INC;
-	if (f >= FRACT_MAX) {
+	m += MILLIS_INC << s;
+	f += FRACT_INC << s;
+	while (f >= FRACT_MAX) {
 		f -= FRACT_MAX;
 		m += 1;
 	}
 
 	timer0_fract = f;
 	timer0_millis = m;
-	timer0_overflow_count++;
+	timer0_overflow_count += 1 << s;
+}
+
+/* Called with the interrupts disabled, right before the system clock
+ * prescaler is changed : the ticks of the current overflow period are
+ * counted at the old rate and timer0 restarts from 0. */
+void timer0_set_clock_shift(unsigned char shift)
+{
+	unsigned char s = timer0_clock_shift;
+	unsigned int ticks = (unsigned int)TCNT0 << s;	// Full clock ticks
+
+#ifdef TIFR0
+	if (TIFR0 & _BV(TOV0)) {
+		TIFR0 = _BV(TOV0);
+#else
+	if (TIFR & _BV(TOV0)) {
+		TIFR = _BV(TOV0);
+#endif
+		ticks += 256 << s;
+	}
+	TCNT0 = 0;
+
+	// micros() : whole overflows go to the overflow count
+	timer0_partial += ticks;
+	timer0_overflow_count += timer0_partial >> 8;
+	timer0_partial &= 0xFF;
+
+	// millis() : same as the overflow handler, for a part of a period
+	unsigned long us = (unsigned long)ticks * (64 / clockCyclesPerMicrosecond());
+	unsigned int f = timer0_fract + ((us % 1000) >> 3);
+	timer0_millis += us / 1000 + f / FRACT_MAX;
+	timer0_fract = f % FRACT_MAX;
+
+	timer0_clock_shift = shift;
 }
 
 unsigned long millis()
@@ -92,15 +132,17 @@ unsigned long micros() {
 
 #ifdef TIFR0
 	if ((TIFR0 & _BV(TOV0)) && (t < 255))
-		m++;
+		m += 1 << timer0_clock_shift;
 #else
 	if ((TIFR & _BV(TOV0)) && (t < 255))
-		m++;
+		m += 1 << timer0_clock_shift;
 #endif
 
+	m = (m << 8) + timer0_partial + ((unsigned long)t << timer0_clock_shift);
+
 	SREG = oldSREG;
 	
-	return ((m << 8) + t) * (64 / clockCyclesPerMicrosecond());
+	return m * (64 / clockCyclesPerMicrosecond());
 }
 
 void delay(unsigned long ms)
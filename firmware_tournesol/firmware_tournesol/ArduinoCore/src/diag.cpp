@@ -0,0 +1,100 @@
+/*
+ * diag.cpp
+ *
+ * Created: 2026-10-19 9:12:45 PM
+ *  Author: Alexis Laframboise
+ */
+
+#include "diag.h"
+#include "common.h"
+#include "energy.h"
+
+#define DIAG_ADC_BANDGAP	(0x0E)		/* MUX of the 1.1 V reference */
+#define DIAG_SETTLE_MS		(2)			/* Bandgap start-up once selected */
+
+static diag_record_t diag = {0};
+static uint32_t wake_total_ms = 0;
+static uint32_t sd_write_total_us = 0;
+
+/** @brief	Increments a 16 bits counter without wrapping around.
+ */
+static uint16_t _diag_inc(uint16_t counter){
+	return (counter < 0xFFFF) ? counter + 1 : counter;
+}
+
+void diag_bus_recovered(uint8_t released){
+	diag.bus_recoveries = _diag_inc(diag.bus_recoveries);
+	if (!released){
+		diag.bus_stuck = _diag_inc(diag.bus_stuck);
+	}
+}
+
+void diag_init_failed(uint8_t id){
+	if (diag.init_failures[id] < 0xFF){
+		diag.init_failures[id]++;
+	}
+}
+
+void diag_read_failed(uint8_t id){
+	if (diag.read_failures[id] < 0xFF){
+		diag.read_failures[id]++;
+	}
+}
+
+void diag_sd_write(uint32_t ticks){
+	uint32_t us = ticks * ENERGY_TICK_US;
+
+	if (diag.sd_writes < 0xFFFF){
+		diag.sd_writes++;
+		sd_write_total_us += us;
+	}
+	diag.sd_write_max_us = max(diag.sd_write_max_us, us);
+}
+
+void diag_sd_failed(void){
+	diag.sd_failures = _diag_inc(diag.sd_failures);
+}
+
+void diag_rtc_failed(void){
+	diag.rtc_failures = _diag_inc(diag.rtc_failures);
+}
+
+void diag_measure_supply(void){
+	ADMUX = bit(REFS0) | DIAG_ADC_BANDGAP;	// AVcc reference, analogRead() sets it back
+	delay(DIAG_SETTLE_MS);
+
+	ADCSRA |= bit(ADSC);
+	while (ADCSRA & bit(ADSC));
+
+	uint16_t adc = ADC;
+	diag.supply_mV = adc ? (uint16_t)((uint32_t)DIAG_BANDGAP_MV * 1024 / adc) : 0;
+}
+
+uint8_t diag_update(uint32_t timestamp){
+	uint32_t wake_ms = energy_rail_ms(ENERGY_RAIL_CPU);
+
+	diag.timestamp = timestamp;
+	diag.wake_max_ms = max(diag.wake_max_ms, (uint16_t)min(wake_ms, 0xFFFFUL));
+	wake_total_ms += wake_ms;
+
+	return (++diag.wakes >= DIAG_PERIOD_WAKES);
+}
+
+uint8_t diag_build_record(uint8_t* data){
+	diag_record_bytes dr;
+
+	dr.record = diag;
+	dr.record.tag = DIAG_RECORD_TAG;
+	dr.record.version = DIAG_RECORD_VERSION;
+	dr.record.len = DIAG_RECORD_BYTES + CHECKSUM_BYTES;
+	dr.record.wake_mean_ms = diag.wakes ? wake_total_ms / diag.wakes : 0;
+	dr.record.sd_write_mean_us = diag.sd_writes ? sd_write_total_us / diag.sd_writes : 0;
+
+	memcpy(data, dr.bytes, DIAG_RECORD_BYTES);
+
+	memset(&diag, 0, sizeof(diag));
+	wake_total_ms = 0;
+	sd_write_total_us = 0;
+
+	return DIAG_RECORD_BYTES;
+}
@@ -0,0 +1,162 @@
+/*
+ * energy.cpp
+ *
+ * Created: 2026-10-19 3:05:22 PM
+ *  Author: Alexis Laframboise
+ */
+
+#include <avr/interrupt.h>
+
+#include "energy.h"
+#include "common.h"
+
+ISR(TIMER1_OVF_vect);
+
+/* Rail currents, same order as energy_rail_t */
+const uint16_t ENERGY_RAIL_CURRENT_UA[ENERGY_RAIL_COUNT] = {
+	ENERGY_CURRENT_PT100_UA,
+	ENERGY_CURRENT_HDC1080_UA,
+	ENERGY_CURRENT_AS7262_UA,
+	ENERGY_CURRENT_RELAY_9V_UA,
+	ENERGY_CURRENT_SD_UA,
+	ENERGY_CURRENT_CPU_UA,
+	ENERGY_CURRENT_SLEEP_UA
+};
+
+volatile uint16_t energy_ovf_count = 0;
+
+// Timer1 runs from the prescaled system clock (see clock.h) : the
+// ticks are counted at full clock from the last prescaler change.
+static uint32_t tick_base = 0;
+static uint32_t raw_base = 0;
+static uint8_t tick_shift = 0;
+
+static uint8_t rail_state = 0;
+static uint32_t rail_start[ENERGY_RAIL_COUNT] = {0};
+static uint32_t rail_ticks[ENERGY_RAIL_COUNT] = {0};
+
+static uint32_t charge_uC[ENERGY_RAIL_COUNT] = {0};
+static uint32_t awake_ms = 0;
+
+/** @brief	Converts an on-time to a charge.
+ *
+ *  @param	on-time in ms
+ *  @param	current in uA
+ *  @return	charge in uC
+ */
+static uint32_t _charge_uC(uint32_t ms, uint16_t current_ua){
+	return (ms * current_ua) / 1000;
+}
+
+void energy_init(void){
+	cli();
+	TCCR1A = 0;                          // Normal mode
+	TCCR1B = bit(CS12) | bit(CS10);      // Prescaler 1024
+	TCNT1 = 0;
+	TIFR1 = bit(TOV1);                   // Clear pending overflow
+	TIMSK1 = bit(TOIE1);                 // Only the overflow interrupt
+	energy_ovf_count = 0;
+	tick_base = 0;
+	raw_base = 0;
+	sei();
+}
+
+/** @brief	Gets the raw Timer1 count, extended to 32 bits.
+ *
+ *  @return	ticks at the current clock
+ */
+static uint32_t _raw_ticks(void){
+	uint8_t sreg = SREG;
+	cli();
+	uint16_t ovf = energy_ovf_count;
+	uint16_t t = TCNT1;
+
+	// Overflow happened but its interrupt is still pending.
+	if ((TIFR1 & bit(TOV1)) && (t < 0x8000)){
+		ovf++;
+	}
+	SREG = sreg;
+
+	return ((uint32_t)ovf << 16) | t;
+}
+
+uint32_t energy_ticks(void){
+	return tick_base + ((_raw_ticks() - raw_base) << tick_shift);
+}
+
+void energy_clock_shift(uint8_t shift){
+	uint32_t raw = _raw_ticks();
+
+	tick_base += (raw - raw_base) << tick_shift;
+	raw_base = raw;
+	tick_shift = shift;
+}
+
+void energy_rail_on(uint8_t rail){
+	if (!(rail_state & bit(rail))){
+		rail_state |= bit(rail);
+		rail_start[rail] = energy_ticks();
+	}
+}
+
+void energy_rail_off(uint8_t rail){
+	if (rail_state & bit(rail)){
+		rail_state &= ~bit(rail);
+		rail_ticks[rail] += energy_ticks() - rail_start[rail];
+	}
+}
+
+uint32_t energy_rail_ms(uint8_t rail){
+	uint32_t ticks = rail_ticks[rail];
+
+	if (rail_state & bit(rail)){
+		ticks += energy_ticks() - rail_start[rail];
+	}
+	return (ticks * ENERGY_TICK_US) / 1000;
+}
+
+void energy_begin_wake(void){
+	for (uint8_t i = 0; i < ENERGY_RAIL_COUNT; i++){
+		rail_ticks[i] = 0;
+	}
+	energy_rail_on(ENERGY_RAIL_CPU);
+}
+
+uint32_t energy_end_wake(void){
+	uint32_t wake_uC = 0;
+	uint32_t q = 0;
+
+	energy_rail_off(ENERGY_RAIL_CPU);
+
+	for (uint8_t i = 0; i < ENERGY_RAIL_SLEEP; i++){
+		q = _charge_uC(energy_rail_ms(i), ENERGY_RAIL_CURRENT_UA[i]);
+		charge_uC[i] += q;
+		wake_uC += q;
+	}
+	awake_ms += energy_rail_ms(ENERGY_RAIL_CPU);
+
+	return wake_uC;
+}
+
+void energy_add_sleep(uint32_t sleep_s){
+	charge_uC[ENERGY_RAIL_SLEEP] += sleep_s * ENERGY_RAIL_CURRENT_UA[ENERGY_RAIL_SLEEP];
+}
+
+uint32_t energy_charge_uC(uint8_t rail){
+	return charge_uC[rail];
+}
+
+uint32_t energy_awake_ms(void){
+	return awake_ms;
+}
+
+void energy_clear(void){
+	for (uint8_t i = 0; i < ENERGY_RAIL_COUNT; i++){
+		charge_uC[i] = 0;
+	}
+	awake_ms = 0;
+}
+
+ISR(TIMER1_OVF_vect){
+	energy_ovf_count++;
+}
@@ -0,0 +1,55 @@
+/*
+ * health.cpp
+ *
+ * Created: 2026-10-19 3:41:10 PM
+ *  Author: Alexis Laframboise
+ */
+
+#include "health.h"
+#include "common.h"
+#include "sram.h"
+
+static uint16_t wakes = 0;
+static uint32_t period_start = 0;
+static uint32_t last_wake = 0;
+static uint32_t last_awake_s = 0;
+
+uint8_t health_update(uint32_t timestamp){
+	// The first wake only sets the time reference.
+	if (last_wake != 0 && timestamp - last_wake > last_awake_s){
+		energy_add_sleep(timestamp - last_wake - last_awake_s);
+	}
+	if (period_start == 0){
+		period_start = timestamp;
+	}
+	last_wake = timestamp;
+	last_awake_s = energy_rail_ms(ENERGY_RAIL_CPU) / 1000;
+
+	return (++wakes >= HEALTH_PERIOD_WAKES);
+}
+
+uint8_t health_build_record(uint8_t* data){
+	health_record_bytes hr;
+
+	hr.record.tag = HEALTH_RECORD_TAG;
+	hr.record.version = HEALTH_RECORD_VERSION;
+	hr.record.len = HEALTH_RECORD_BYTES + CHECKSUM_BYTES;
+	hr.record.timestamp = last_wake;
+	hr.record.wakes = wakes;
+	hr.record.period_s = last_wake - period_start;
+	hr.record.awake_ms = energy_awake_ms();
+
+	for (uint8_t i = 0; i < ENERGY_RAIL_COUNT; i++){
+		hr.record.charge_uC[i] = energy_charge_uC(i);
+	}
+	hr.record.stack_high = sram_stack_high();
+	hr.record.sram_free = sram_free_low();
+
+	memcpy(data, hr.bytes, HEALTH_RECORD_BYTES);
+
+	energy_clear();
+	wakes = 0;
+	period_start = last_wake;
+
+	return HEALTH_RECORD_BYTES;
+}
@@ -18,9 +18,20 @@
    uint8_t nfilecount=0;
 */
 
+// Statically allocated files, opening a file doesn't use the heap. Bit i
+// of slots_used tells that slots[i] is taken.
+static SdFile slots[SD_FILE_SLOTS];
+static uint8_t slots_used = 0;
+
 File::File(SdFile f, const char *n) {
-  // oh man you are kidding me, new() doesn't exist? Ok we do it by hand!
-  _file = (SdFile *)malloc(sizeof(SdFile));
+  _file = 0;
+  for (uint8_t i = 0; i < SD_FILE_SLOTS; i++) {
+    if (!(slots_used & (1 << i))) {
+      slots_used |= (1 << i);
+      _file = &slots[i];
+      break;
+    }
+  }
   if (_file) {
     memcpy(_file, &f, sizeof(SdFile));
 
@@ -73,6 +84,29 @@ size_t File::write(const uint8_t *buf, size_t size) {
   return t;
 }
 
+// reserves room in the block cache for data built in place, see SdFile
+uint8_t *File::writeReserve(uint16_t size, uint8_t pad) {
+  if (!_file) {
+    return 0;
+  }
+  return _file->writeReserve(size, pad);
+}
+
+boolean File::writeCommit(uint16_t size) {
+  if (!_file) {
+    return false;
+  }
+  return _file->writeCommit(size);
+}
+
+// first and last block of a contiguous file, see SdFile
+boolean File::contiguousRange(uint32_t *bgnBlock, uint32_t *endBlock) {
+  if (!_file) {
+    return false;
+  }
+  return _file->contiguousRange(bgnBlock, endBlock);
+}
+
 int File::availableForWrite() {
   if (_file) {
     return _file->availableForWrite();
@@ -148,7 +182,7 @@ uint32_t File::size() {
 void File::close() {
   if (_file) {
     _file->close();
-    free(_file);
+    slots_used &= ~(1 << (_file - slots));
     _file = 0;
 
     /* for debugging file open/close leaks
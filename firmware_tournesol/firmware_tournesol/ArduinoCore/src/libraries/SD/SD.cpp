@@ -486,6 +486,24 @@ namespace SDLib {
     return File(file, filepath);
   }
 
+  File SDClass::createContiguous(const char *filepath, uint32_t size) {
+    /*
+
+       Create a file of the given size whose blocks are contiguous
+       on the card, in the root directory. Its blocks can then be
+       written by address, see File::contiguousRange().
+
+       An attempt to create a file that already exists is an error.
+
+    */
+    SdFile file;
+
+    if (!file.createContiguous(&root, filepath, size)) {
+      return File();
+    }
+    return File(file, filepath);
+  }
+
 
   /*
     File SDClass::open(char *filepath, uint8_t mode) {
@@ -20,6 +20,7 @@
 #define USE_SPI_LIB
 #include <Arduino.h>
 #include "Sd2Card.h"
+#include "clock.h"
 //------------------------------------------------------------------------------
 #ifndef SOFTWARE_SPI
 #ifdef USE_SPI_LIB
@@ -577,6 +578,11 @@ uint8_t Sd2Card::waitNotBusy(unsigned int timeoutMillis) {
     if (spiRec() == 0XFF) {
       return true;
     }
+    // Polls tightly through a block program, then every ms with the
+    // clock divided in between (erase, card housekeeping).
+    if (millis() - t0 >= SD_BUSY_SPIN_MS) {
+      clock_wait_ms(1);
+    }
     d = millis() - t0;
   } while (d < timeoutMillis);
   return false;
@@ -652,15 +658,25 @@ fail:
   return false;
 }
 //------------------------------------------------------------------------------
-/** Write one data block in a multiple block write sequence */
+/** Write one data block in a multiple block write sequence.
+
+   The card is deselected between blocks, it keeps the sequence and
+   programs the block while the bus is free. A sequence can span
+   several sleeps this way.
+*/
 uint8_t Sd2Card::writeData(const uint8_t* src) {
+  chipSelectLow();
   // wait for previous write to finish
   if (!waitNotBusy(SD_WRITE_TIMEOUT)) {
     error(SD_CARD_ERROR_WRITE_MULTIPLE);
     chipSelectHigh();
     return false;
   }
-  return writeData(WRITE_MULTIPLE_TOKEN, src);
+  if (!writeData(WRITE_MULTIPLE_TOKEN, src)) {
+    return false;
+  }
+  chipSelectHigh();
+  return true;
 }
 //------------------------------------------------------------------------------
 // send one block of data for write block or write multiple blocks
@@ -734,6 +750,7 @@ uint8_t Sd2Card::writeStart(uint32_t blockNumber, uint32_t eraseCount) {
     error(SD_CARD_ERROR_CMD25);
     goto fail;
   }
+  chipSelectHigh();
   return true;
 
 fail:
@@ -747,6 +764,7 @@ fail:
    the value zero, false, is returned for failure.
 */
 uint8_t Sd2Card::writeStop(void) {
+  chipSelectLow();
   if (!waitNotBusy(SD_WRITE_TIMEOUT)) {
     goto fail;
   }
@@ -1311,6 +1311,148 @@ uint8_t SdFile::truncate(uint32_t length) {
   return seekSet(newPos);
 }
 //------------------------------------------------------------------------------
+// Move to the cluster of the current position, the cluster is added if the
+// position is past the end of the chain, and return the block of the
+// position. Must be called once per block, before writing to it.
+uint8_t SdFile::seekWriteBlock(uint32_t* block) {
+  uint8_t blockOfCluster = vol_->blockOfCluster(curPosition_);
+  uint16_t blockOffset = curPosition_ & 0X1FF;
+  if (blockOfCluster == 0 && blockOffset == 0) {
+    // start of new cluster
+    if (curCluster_ == 0) {
+      if (firstCluster_ == 0) {
+        // allocate first cluster of file
+        if (!addCluster()) {
+          return false;
+        }
+      } else {
+        curCluster_ = firstCluster_;
+      }
+    } else {
+      uint32_t next;
+      if (!vol_->fatGet(curCluster_, &next)) {
+        return false;
+      }
+      if (vol_->isEOC(next)) {
+        // add cluster if at end of chain
+        if (!addCluster()) {
+          return false;
+        }
+      } else {
+        curCluster_ = next;
+      }
+    }
+  }
+  *block = vol_->clusterStartBlock(curCluster_) + blockOfCluster;
+  return true;
+}
+//------------------------------------------------------------------------------
+// Load the block of the current position in the cache for a write, and
+// return the cache address of the position.
+uint8_t* SdFile::cacheWriteBlock(uint32_t block) {
+  uint16_t blockOffset = curPosition_ & 0X1FF;
+  if (blockOffset == 0 && curPosition_ >= fileSize_) {
+    // start of new block don't need to read into cache
+    if (SdVolume::cacheBlockNumber_ != block) {
+      if (!SdVolume::cacheFlush()) {
+        return 0;
+      }
+      SdVolume::cacheBlockNumber_ = block;
+    }
+    SdVolume::cacheSetDirty();
+  } else {
+    // rewrite part of block
+    if (!SdVolume::cacheRawBlock(block, SdVolume::CACHE_FOR_WRITE)) {
+      return 0;
+    }
+  }
+  return SdVolume::cacheBuffer_.data + blockOffset;
+}
+//------------------------------------------------------------------------------
+/**
+   Reserve room for a write in the block cache, for data built in place.
+
+   The reserved bytes are contiguous : if the current block can't hold them,
+   its end is filled with \a pad and they start the next block.
+   writeCommit() must follow before any other access to the volume, a single
+   reservation can be pending.
+
+   \param[in] nbyte Number of bytes to reserve, at most 512.
+
+   \param[in] pad Value of the bytes skipped at the end of the block.
+
+   \return The cache address of the reserved bytes, or null if an error occurs.
+*/
+uint8_t* SdFile::writeReserve(uint16_t nbyte, uint8_t pad) {
+  uint32_t block;
+  uint8_t* dst;
+
+  if (!isFile() || !(flags_ & O_WRITE) || nbyte > 512) {
+    return 0;
+  }
+
+  // seek to end of file if append flag
+  if ((flags_ & O_APPEND) && curPosition_ != fileSize_) {
+    if (!seekEnd()) {
+      return 0;
+    }
+  }
+
+  uint16_t blockOffset = curPosition_ & 0X1FF;
+  if (blockOffset != 0 && 512 - blockOffset < nbyte) {
+    // pad the end of the block, the reservation starts the next one
+    if (!seekWriteBlock(&block) || !(dst = cacheWriteBlock(block))) {
+      return 0;
+    }
+    memset(dst, pad, 512 - blockOffset);
+    curPosition_ += 512 - blockOffset;
+    if (curPosition_ > fileSize_) {
+      fileSize_ = curPosition_;
+      flags_ |= F_FILE_DIR_DIRTY;
+    }
+    if (!SdVolume::cacheFlush()) {
+      return 0;
+    }
+  }
+
+  if (!seekWriteBlock(&block)) {
+    return 0;
+  }
+  // the cluster is entered, commit from here
+  reserveBlock_ = block;
+  return cacheWriteBlock(block);
+}
+//------------------------------------------------------------------------------
+/**
+   Write the data built in the bytes reserved by writeReserve().
+
+   The block is written to the storage device, the directory entry is only
+   updated by sync().
+
+   \param[in] nbyte Number of bytes written in place, at most the reserved count.
+
+   \return The value one, true, is returned for success and
+   the value zero, false, is returned for failure.
+*/
+uint8_t SdFile::writeCommit(uint16_t nbyte) {
+  // the reserved block must still be in the cache
+  if (SdVolume::cacheBlockNumber_ != reserveBlock_ ||
+      (curPosition_ & 0X1FF) + nbyte > 512) {
+    return false;
+  }
+  SdVolume::cacheSetDirty();
+  curPosition_ += nbyte;
+  if (curPosition_ > fileSize_) {
+    fileSize_ = curPosition_;
+    flags_ |= F_FILE_DIR_DIRTY;
+  }
+
+  if (flags_ & O_SYNC) {
+    return sync();
+  }
+  return SdVolume::cacheFlush();
+}
+//------------------------------------------------------------------------------
 /**
    Write data to an open file.
 
@@ -1349,33 +1491,11 @@ size_t SdFile::write(const void* buf, uint16_t nbyte) {
   }
 
   while (nToWrite > 0) {
-    uint8_t blockOfCluster = vol_->blockOfCluster(curPosition_);
     uint16_t blockOffset = curPosition_ & 0X1FF;
-    if (blockOfCluster == 0 && blockOffset == 0) {
-      // start of new cluster
-      if (curCluster_ == 0) {
-        if (firstCluster_ == 0) {
-          // allocate first cluster of file
-          if (!addCluster()) {
-            goto writeErrorReturn;
-          }
-        } else {
-          curCluster_ = firstCluster_;
-        }
-      } else {
-        uint32_t next;
-        if (!vol_->fatGet(curCluster_, &next)) {
-          return false;
-        }
-        if (vol_->isEOC(next)) {
-          // add cluster if at end of chain
-          if (!addCluster()) {
-            goto writeErrorReturn;
-          }
-        } else {
-          curCluster_ = next;
-        }
-      }
+    // block for data write
+    uint32_t block;
+    if (!seekWriteBlock(&block)) {
+      goto writeErrorReturn;
     }
     // max space in block
     uint16_t n = 512 - blockOffset;
@@ -1385,8 +1505,6 @@ size_t SdFile::write(const void* buf, uint16_t nbyte) {
       n = nToWrite;
     }
 
-    // block for data write
-    uint32_t block = vol_->clusterStartBlock(curCluster_) + blockOfCluster;
     if (n == 512) {
       // full block - don't need to use cache
       // invalidate cache if block is in cache
@@ -1398,20 +1516,10 @@ size_t SdFile::write(const void* buf, uint16_t nbyte) {
       }
       src += 512;
     } else {
-      if (blockOffset == 0 && curPosition_ >= fileSize_) {
-        // start of new block don't need to read into cache
-        if (!SdVolume::cacheFlush()) {
-          goto writeErrorReturn;
-        }
-        SdVolume::cacheBlockNumber_ = block;
-        SdVolume::cacheSetDirty();
-      } else {
-        // rewrite part of block
-        if (!SdVolume::cacheRawBlock(block, SdVolume::CACHE_FOR_WRITE)) {
-          goto writeErrorReturn;
-        }
+      uint8_t* dst = cacheWriteBlock(block);
+      if (!dst) {
+        goto writeErrorReturn;
       }
-      uint8_t* dst = SdVolume::cacheBuffer_.data + blockOffset;
       uint8_t* end = dst + n;
       while (dst != end) {
         *dst++ = *src++;
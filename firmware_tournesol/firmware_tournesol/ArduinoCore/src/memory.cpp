@@ -5,45 +5,139 @@
  *  Author: Alexis Laframboise
  */
 
+#include "memory.h"
+#include "sdstream.h"
 #include "common.h"
+#include "energy.h"
+#include "diag.h"
 
 #include <SPI.h>
 #include <SD.h>
 
 int sd_init();
 
+static_assert(sizeof(frame_t) <= SD_BLOCK_BYTES, "A frame doesn't fit an SD block");
+
+// Kept open, its block cache is the frame buffer.
+static File log_file;
+static uint8_t* frame_slot = NULL;
+static uint8_t frame_reserved = 0;		/* frame_slot is in the log block */
+#if !SD_STREAM_EN
+static uint8_t sync_pending = 0;
+#endif
+
 int init_memory(){
-	PRINTFUNCT;
-	return sd_init();
+	TRACE(TRACE_EV_INIT_MEMORY);
+
+	int err = sd_init();
+
+#if !DEBUG_NO_SD
+	if (err == ERROR_OK){
+#if SD_STREAM_EN
+		err = sdstream_init();
+#else
+		log_file = SD.open(SAVE_FILE_NAME, FILE_WRITE);
+		if (!log_file){
+			err = ERROR_SD;
+		}
+#endif
+	}
+#endif
+	return err;
 }
 
-void save_frame(char* fname, uint8_t* data, uint8_t len){
-	PRINTFUNCT;
+frame_t& memory_frame_begin(void){
+	frame_slot = NULL;
+
 #if !DEBUG_NO_SD
-	File dataFile = SD.open(fname, FILE_WRITE);
-	dataFile.write(data, len);
-	dataFile.close();
+#if SD_STREAM_EN
+	frame_slot = sdstream_reserve();
+#else
+	energy_rail_on(ENERGY_RAIL_SD);
+	frame_slot = log_file.writeReserve(sizeof(frame_t), FRAME_PAD);
+	energy_rail_off(ENERGY_RAIL_SD);
 #endif
+#endif
+
+	frame_reserved = (frame_slot != NULL);
+	if (!frame_reserved){
+		// No card : the frame is still built for the telemetry.
+		frame_slot = SdVolume::cacheClear();
+	}
+	return *reinterpret_cast<frame_t*>(frame_slot);
+}
+
+void memory_frame_end(uint8_t len){
+	TRACE(TRACE_EV_SAVE_FRAME);
 
 #if DEBUG_SAVE_FRAME_SERIAL
-	Serial.print("File name : "); Serial.println(fname);
+	Serial.print("File name : "); Serial.println(SAVE_FILE_NAME);
 	Serial.print("Frame lenght : "); Serial.println(len);
 	for(int i = 0; i < len; i++){
-		Serial.print(data[i]);
+		Serial.print(frame_slot[i]);
 		Serial.print(",\t");
 	}
 	Serial.println();
 #endif
+
+	if (!frame_reserved){
+		return;
+	}
+	frame_reserved = 0;
+
+#if SD_STREAM_EN
+	sdstream_commit(len);
+#else
+	uint16_t room = SD_BLOCK_BYTES - (log_file.position() % SD_BLOCK_BYTES);
+	uint16_t count = len;
+
+	// Last frame of the block : the end is padded now, while the block
+	// is cached, the next frame starts a new block without reading it.
+	if ((uint16_t)(room - len) < sizeof(frame_t)){
+		memset(frame_slot + len, FRAME_PAD, room - len);
+		count = room;
+	}
+
+	uint32_t start = energy_ticks();
+
+	energy_rail_on(ENERGY_RAIL_SD);
+	uint8_t written = log_file.writeCommit(count);
+	energy_rail_off(ENERGY_RAIL_SD);
+
+	diag_sd_write(energy_ticks() - start);
+	if (!written){
+		diag_sd_failed();
+	}
+	sync_pending = 1;
+#endif
+}
+
+void memory_sync(void){
+#if !DEBUG_NO_SD && !SD_STREAM_EN
+	// The frames past the size of the directory entry are lost on
+	// a reset : the entry is a block write of its own, at every wake
+	// that saved a frame. The next frame reads its block back.
+	if (sync_pending){
+		uint32_t start = energy_ticks();
+
+		energy_rail_on(ENERGY_RAIL_SD);
+		log_file.flush();
+		energy_rail_off(ENERGY_RAIL_SD);
+
+		diag_sd_write(energy_ticks() - start);
+		sync_pending = 0;
+	}
+#endif
 }
 
 int sd_init(){
-	PRINTFUNCT;
+	TRACE(TRACE_EV_SD_INIT);
 
 #if !DEBUG_NO_SD
 	// see if the card is present and can be initialized:
 	if (!SD.begin(SD_CHIP_SELECT_PIN)) {
 
-		#if SERIAL_EN
+		#if SERIAL_DEBUG_EN
 		Serial.print("ERROR : "); Serial.print(__FUNCTION__); Serial.println(" : SD card unreachable.");
 		#endif
 
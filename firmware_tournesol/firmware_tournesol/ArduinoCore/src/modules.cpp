@@ -13,163 +13,216 @@
 #include <Wire.h>
 
 #include "modules.h"
+#include "settings.h"
+#include "power.h"
+#include "clock.h"
+#include "bus.h"
+#include "watchdog.h"
+#include "diag.h"
 
 
 /* Convenient types definitions */
-struct Sensor_t;
+typedef struct Schedule_t{
+	uint16_t period_s;		/* 0 : every wake */
+	uint16_t phase_s;
+	uint32_t next_s;		/* Unix time of the next reading */
+} Schedule_t;
 
-typedef int (*_sensor_init)(Sensor_t*);
+/* Each sensor of the registry specializes both, the id is known at
+ * compile time so every call is direct and inlined. */
 
-typedef uint8_t (*_sensor_read)(Sensor_t*, uint8_t*);
-
-typedef struct Sensor_t{
-	void* sensor_mod;
-	_sensor_init s_init;
-	_sensor_read s_read;
-} Sensor_t;
-
-/** @brief	This function initializes the AS7262 module.
+/** @brief	This function initializes the module of a sensor.
  *
- *  @param	sensor struct pointer
  *  @return	error code
  */
-int _as7262_init(Sensor_t* sens);
+template <uint8_t id> static int _sensor_init(void);
 
-/** @brief	This function initializes the HDC1080 module.
+/** @brief	This function reads the measurements of a sensor, it
+ *			fills exactly sensor_meas_bytes(id) bytes.
  *
- *  @param	sensor struct pointer
- *  @return	error code
+ *  @param	slot of the sensor in the frame
+ *  @return	error code, the slot isn't valid on error
  */
-int _hdc1080_init(Sensor_t* sens);
+template <uint8_t id> static int _sensor_read(uint8_t* data);
 
-/** @brief	This function initializes the pt100 module.
- *
- *  @param	sensor struct pointer
- *  @return	error code
- */
-int _pt100_init(Sensor_t* sens);
+// Driver class instantiation
+Adafruit_AS726x as7262_sensor;
+ClosedCube_HDC1080 hdc1080_sensor;
+PT100 pt100_sensor;
+Anemometer anemometer_sensor;
 
-/** @brief	This function initializes the anemometer module.
- *
- *  @param	sensor struct pointer
- *  @return	error code
- */
-int _anemometer_init(Sensor_t* sens);
+#define SENSOR_SCHEDULE(name, channels, meta)	{name##_PERIOD_S, name##_PHASE_S, 0},
 
-/** @brief	This function reads the measurements from the AS7262.
- *
- *
- *  @param	sensor struct pointer
- *  @param	byte array from main
- *  @return	number of bytes read
- */
-uint8_t _as7262_read(Sensor_t* sens, uint8_t* data);
+// Schedule of each sensor, in registry order
+static Schedule_t schedule[SENSOR_COUNT] = {
+	SENSOR_REGISTRY(SENSOR_SCHEDULE)
+};
 
-/** @brief	This function reads the measurements from the HDC1080.
- *
+static_assert(sensor_layout[SENSOR_AS7262].channels == AS726x_NUM_CHANNELS, "AS7262 channels don't match the registry");
+static_assert(sensor_layout[SENSOR_AS7262].meta_bytes == AS7262_RANGE_BYTES, "AS7262 range doesn't match the registry");
+
+#if AS7262_DARK_GATING_EN
+// Darkness detection state
+static uint32_t wake_timestamp = 0;
+static uint32_t as7262_read_s = 0;
+static uint8_t as7262_dark = 0;
+
+/** @brief	Tells if a time is in the night window, in local
+ *			hours.
  *
- *  @param	sensor struct pointer
- *  @param	byte array from main
- *  @return	number of bytes read
+ *  @param	unix time, UTC
+ *  @return	1 at night, 0 otherwise
  */
-uint8_t _hdc1080_read(Sensor_t* sens, uint8_t* data);
+static uint8_t _is_night(uint32_t timestamp){
+	uint32_t local = timestamp + (int32_t)STATION_UTC_OFFSET_H * (int32_t)SECONDS_IN_HOUR;
+	uint8_t hour = (local % SECONDS_IN_DAY) / SECONDS_IN_HOUR;
+#if AS7262_NIGHT_START_H > AS7262_NIGHT_END_H
+	return (hour >= AS7262_NIGHT_START_H || hour < AS7262_NIGHT_END_H);
+#else
+	return (hour >= AS7262_NIGHT_START_H && hour < AS7262_NIGHT_END_H);
+#endif
+}
+#endif
 
-/** @brief	This function reads the measurements from the pt100.
- *
+#define AS7262_CYCLE_US		(2800UL)	/* Integration time unit */
+
+/* Both integrations of a reading, in 32 bits : 255 cycles overflow an int */
+#define AS7262_CONVERSION_MS(cycles)	((uint32_t)(cycles) * AS7262_CYCLE_US * 2 / 1000)
+
+static_assert(AS7262_CONVERSION_MS(255) == 1428, "AS7262 conversion time overflows");
+static_assert(AS7262_CONVERSION_MS(255) + AS7262_READY_TIMEOUT_MS <= UINT16_MAX, "AS7262 deadline overflows");
+
+// Range of the next AS7262 reading, and the peak raw count of the last one
+static uint8_t as7262_gain = AS7262_DEFAULT_GAIN;
+static uint8_t as7262_int_cycles = AS7262_DEFAULT_INT_CYCLES;
+static uint16_t as7262_peak = 0;
+
+#if AS7262_AUTORANGE_EN
+#define AS7262_COUNTS_PER_CYCLE	(1024.0)	/* ADC full scale grows with the integration */
+#define AS7262_COUNTS_MAX		(65535.0)
+#define AS7262_COUNTS_SATURATED	(0.98)		/* Fraction of the full scale */
+#define AS7262_SATURATED_STEP	(4)			/* Assumed rate increase past saturation */
+#define AS7262_GAIN_COUNT		(4)
+
+/* Integration times tried, in 2.8 ms cycles, shortest first */
+static const uint8_t AS7262_INT_CYCLES[] PROGMEM = {4, 9, 18, 36, 71, 143, 255};
+
+/* Gain of each GAIN_* code, x10 */
+static const uint16_t AS7262_GAIN_X10[AS7262_GAIN_COUNT] PROGMEM = {10, 37, 160, 640};
+
+/** @brief	Returns the full scale raw count of an integration time.
  *
- *  @param	sensor struct pointer
- *  @param	byte array from main
- *  @return	number of bytes read
+ *  @param	integration time in 2.8 ms cycles
+ *  @return	full scale count
  */
-uint8_t _pt100_read(Sensor_t* sens, uint8_t* data);
+static float _as7262_full_scale(uint8_t cycles){
+	return min(AS7262_COUNTS_PER_CYCLE * cycles, AS7262_COUNTS_MAX);
+}
 
-/** @brief	This function reads the measurements from the anemometer.
- *
- *
- *  @param	sensor struct pointer
- *  @param	byte array from main
- *  @return	number of bytes read
+/** @brief	Picks the gain and integration time of the next AS7262
+ *			reading from the peak raw count of the last one. The counts
+ *			are assumed proportional to the gain times the integration.
+ *			A saturated peak only gives a lower bound of the light,
+ *			it is scaled up so the range drops faster.
  */
-uint8_t _anemometer_read(Sensor_t* sens, uint8_t* data);
+static void _as7262_autorange(void){
+	if (as7262_peak == 0){
+		return;		// No reading yet, keep the defaults
+	}
 
-// Driver class instantiation
-Adafruit_AS726x as7262_sensor;
-ClosedCube_HDC1080 hdc1080_sensor;
-PT100 pt100_sensor;
-Anemometer anemometer_sensor;
+	float full = _as7262_full_scale(as7262_int_cycles);
+	float rate = as7262_peak / ((float)pgm_read_word(&AS7262_GAIN_X10[as7262_gain]) * as7262_int_cycles);
+	if (as7262_peak >= full * AS7262_COUNTS_SATURATED){
+		rate *= AS7262_SATURATED_STEP;
+	}
 
-// Modules sensor struct
-Sensor_t as7262 = {(void*)&as7262_sensor, &_as7262_init, &_as7262_read};
-Sensor_t hdc1080 = {(void*)&hdc1080_sensor, &_hdc1080_init, &_hdc1080_read};
-Sensor_t pt100 = {(void*)&pt100_sensor, &_pt100_init, &_pt100_read};
-Sensor_t anemometer = {(void*)&anemometer_sensor, &_anemometer_init, &_anemometer_read};
-
-// Sensor struct list
-Sensor_t sensor_list[] = {
-	as7262,
-	hdc1080,
-	pt100,
-	anemometer,
-	{NULL, NULL, NULL}
-};
+	uint8_t gain = 0;
+	uint8_t cycles = pgm_read_byte(&AS7262_INT_CYCLES[0]);
+	float counts;
+
+	for (uint8_t i = 0; i < sizeof(AS7262_INT_CYCLES); i++){
+		uint8_t c = pgm_read_byte(&AS7262_INT_CYCLES[i]);
+		int8_t g = AS7262_GAIN_COUNT - 1;
+
+		// Most sensitive gain that doesn't go over the range
+		full = _as7262_full_scale(c);
+		for (; g >= 0; g--){
+			counts = rate * pgm_read_word(&AS7262_GAIN_X10[g]) * c;
+			if (counts <= full * AS7262_RANGE_HIGH){
+				break;
+			}
+		}
+		if (g < 0){
+			break;		// Too bright, longer integrations won't fit either
+		}
+
+		gain = g;
+		cycles = c;
+		if (counts >= full * AS7262_RANGE_LOW){
+			break;
+		}
+	}
+
+	as7262_gain = gain;
+	as7262_int_cycles = cycles;
+}
+#endif
 
 /************************************************************************/
 /*                    Sensor init functions                             */
 /************************************************************************/
 
-int _as7262_init(Sensor_t* sens){
+template <> int _sensor_init<SENSOR_AS7262>(void){
 
-	PRINTFUNCT;
+	TRACE(TRACE_EV_AS7262_INIT);
 
-	if(!as7262_sensor.begin()){
+	if(!as7262_sensor.begin() || bus_failed()){
 
-		#if SERIAL_EN
+		#if SERIAL_DEBUG_EN
 		Serial.print("ERROR : "); Serial.print(__FUNCTION__); Serial.println(" : Sensor unreachable.");
 		#endif
 
 		return ERROR_AS7262;
 	}
 
-	//sens->sensor_mod = (void*)&as7262_sensor;
-
 	return ERROR_OK;
 }
 
-int _hdc1080_init(Sensor_t* sens){
+template <> int _sensor_init<SENSOR_HDC1080>(void){
 
-	PRINTFUNCT;
+	TRACE(TRACE_EV_HDC1080_INIT);
 
 	hdc1080_sensor.begin(0x40);
 	hdc1080_sensor.setResolution(HDC1080_RESOLUTION_11BIT, HDC1080_RESOLUTION_11BIT);
 
-	if(hdc1080_sensor.readDeviceId() != 0x1050){
+	if(hdc1080_sensor.readDeviceId() != 0x1050 || bus_failed()){
+
+		#if SERIAL_DEBUG_EN
 		Serial.print("ERROR : "); Serial.print(__FUNCTION__); Serial.println(" : Sensor unreachable.");
+		#endif
+
 		return ERROR_HDC1080;
 	}
 
-	//sens->sensor_mod = (void*)&hdc1080_sensor;
-
 	return ERROR_OK;
 }
 
-int _pt100_init(Sensor_t* sens){
+template <> int _sensor_init<SENSOR_PT100>(void){
 
-	PRINTFUNCT;
+	TRACE(TRACE_EV_PT100_INIT);
 
 	pt100_sensor.setPin(PT100_ADC_PIN);
-
-	//sens->sensor_mod = (void*)&pt100_sensor;
+	pt100_sensor.setCalibration(settings.pt100_c1, settings.pt100_c2);
 
 	return 0;
 }
 
-int _anemometer_init(Sensor_t* sens) {
+template <> int _sensor_init<SENSOR_ANEMOMETER>(void){
 
-	PRINTFUNCT;
+	TRACE(TRACE_EV_ANEMOMETER_INIT);
 
 	anemometer_sensor.setPin(ANEMO_ADC_PIN);
-
-	//sens->sensor_mod = (void*)&anemometer_sensor;
+	anemometer_sensor.setCalibration(settings.anemo_c1, settings.anemo_c2);
 
 	return 0;
 }
@@ -178,127 +231,254 @@ int _anemometer_init(Sensor_t* sens) {
 /*                    Sensor read functions                             */
 /************************************************************************/
 
-uint8_t _as7262_read(Sensor_t* sens, uint8_t* data){
+template <> int _sensor_read<SENSOR_AS7262>(uint8_t* data){
 
-	PRINTFUNCT;
+	TRACE(TRACE_EV_AS7262_READ);
 
 	float measurements[AS726x_NUM_CHANNELS] = {0};
+	uint16_t raw[AS726x_NUM_CHANNELS] = {0};
+	float intensity = 0;
+	uint16_t conversion_ms = AS7262_CONVERSION_MS(as7262_int_cycles);
+	uint32_t start;
 	data_float_bytes fb;
 
-	Adafruit_AS726x* pAs7262 = (Adafruit_AS726x*)sens->sensor_mod;
+	// begin() resets the range, the conversion time follows the integration.
+	as7262_sensor.setGain(as7262_gain);
+	as7262_sensor.setIntegrationTime(as7262_int_cycles);
 
-	pAs7262->startMeasurement(); //begin a measurement
+	as7262_sensor.startMeasurement(); //begin a measurement
+	start = millis();
 
-	while(!pAs7262->dataReady());
+	// All the channels take two integrations, polled once done.
+	clock_wait_ms(conversion_ms);
+	while(!as7262_sensor.dataReady()){
+		if (as7262_sensor.timedOut() || millis() - start > (uint32_t)conversion_ms + AS7262_READY_TIMEOUT_MS){
+			return ERROR_AS7262;
+		}
+	}
 
-	pAs7262->readCalibratedValues(measurements);
+	as7262_sensor.readCalibratedValues(measurements);
+	as7262_sensor.readRawValues(raw);
+
+	// Keeps the range and the darkness state of the last good reading.
+	if (as7262_sensor.timedOut() || bus_failed()){
+		return ERROR_AS7262;
+	}
 
 	for (int i = 0; i < AS726x_NUM_CHANNELS; i++){
-		fb.value = (measurements[i] - AS7262_CALIBRATED_DARK_OFFSET[i]) * AS7262_CALIBRATED_DIFFUSER_MULTIPLIER[i];
+		fb.value = (measurements[i] - settings.as7262_dark_offset[i]) * settings.as7262_diffuser_multiplier[i];
+		intensity += fb.value;
 
 #if DEBUG_AS7262_SERIAL
 		Serial.print("CH: "); Serial.print(i);
 		Serial.print("\t"); Serial.print(measurements[i]); Serial.print("\t");
 #endif
 
-		for (int j = 0; j < sizeof(float); j++){
+		for (uint8_t j = 0; j < sizeof(float); j++){
 			data[i * sizeof(float) + j] = fb.bytes[j];
 		}
 	}
 
+	data[AS726x_NUM_CHANNELS * sizeof(float)] = as7262_gain;
+	data[AS726x_NUM_CHANNELS * sizeof(float) + 1] = as7262_int_cycles;
+
+	as7262_peak = 0;
+	for (int i = 0; i < AS726x_NUM_CHANNELS; i++){
+		as7262_peak = max(as7262_peak, raw[i]);
+	}
+
 #if DEBUG_AS7262_SERIAL
-	Serial.println();
+	Serial.print("Gain: "); Serial.print(as7262_gain);
+	Serial.print("\tInt: "); Serial.print(as7262_int_cycles);
+	Serial.print("\tPeak: "); Serial.println(as7262_peak);
+#endif
+
+#if AS7262_AUTORANGE_EN
+	_as7262_autorange();
 #endif
 
-	return AS7262_MEAS_BYTES;
+#if AS7262_DARK_GATING_EN
+	as7262_dark = (intensity < AS7262_DARK_THRESHOLD);
+	as7262_read_s = wake_timestamp;
+#endif
+
+	return ERROR_OK;
 }
 
-uint8_t _hdc1080_read(Sensor_t* sens, uint8_t* data){
+template <> int _sensor_read<SENSOR_HDC1080>(uint8_t* data){
 
-	PRINTFUNCT;
+	TRACE(TRACE_EV_HDC1080_READ);
 
-	ClosedCube_HDC1080* pHdc1080 = (ClosedCube_HDC1080*)sens->sensor_mod;
 	data_float_bytes temp;
 	data_float_bytes rh;
 
-	temp.value = (float)(pHdc1080->readTemperature());
-	rh.value = (float)(pHdc1080->readHumidity());
+	temp.value = (float)(hdc1080_sensor.readTemperature());
+	rh.value = (float)(hdc1080_sensor.readHumidity());
 
 #if DEBUG_HDC1080_SERIAL
 	Serial.print("Temp: "); Serial.print(temp.value);
 	Serial.print("\tRH: "); Serial.println(rh.value);
 #endif
 
-	for (int i = 0; i < sizeof(float); i++){
+	for (uint8_t i = 0; i < sizeof(float); i++){
 		data[i] = temp.bytes[i];
 		data[i + sizeof(float)] = rh.bytes[i];
 	}
-	return HDC1080_MEAS_BYTES;
-}
 
-uint8_t _pt100_read(Sensor_t* sens, uint8_t* data) {
+	return bus_failed() ? ERROR_HDC1080 : ERROR_OK;
+}
 
-	PRINTFUNCT;
+template <> int _sensor_read<SENSOR_PT100>(uint8_t* data){
 
-	PT100* pPt100 = (PT100*)sens->sensor_mod;
+	TRACE(TRACE_EV_PT100_READ);
 
 	data_float_bytes temp;
-	temp.value = (float)(pPt100->readTemperature());
+	temp.value = (float)(pt100_sensor.readTemperature());
 
 	#if DEBUG_PT100_SERIAL
 	Serial.print("Temp(PT100): "); Serial.print(temp.value); Serial.print("\n");
 	#endif
-	for (int i = 0; i < sizeof(float); i++){
+	for (uint8_t i = 0; i < sizeof(float); i++){
 		data[i] = temp.bytes[i];
 	}
-	return PT100_MEAS_BYTES;
-}
 
-uint8_t _anemometer_read(Sensor_t* sens, uint8_t* data) {
+	return ERROR_OK;
+}
 
-	PRINTFUNCT;
+template <> int _sensor_read<SENSOR_ANEMOMETER>(uint8_t* data){
 
-	Anemometer* pAnemometer = (Anemometer*)sens->sensor_mod;
+	TRACE(TRACE_EV_ANEMOMETER_READ);
 
 	data_float_bytes temp;
-	temp.value = (float)(pAnemometer->readWindSpeed());
+	temp.value = (float)(anemometer_sensor.readWindSpeed());
 
 #if DEBUG_ANEMOMETER_SERIAL
 	Serial.print("Vit. Vent: "); Serial.print(temp.value); Serial.print("\n");
 #endif
 
-	for (int i = 0; i < sizeof(float); i++){
+	for (uint8_t i = 0; i < sizeof(float); i++){
 		data[i] = temp.bytes[i];
 	}
-	return ANEMOMETER_MEAS_BYTES;
+
+	return ERROR_OK;
+}
+
+void modules_configure(void){
+	for (uint8_t i = 0; i < MODULE_COUNT; i++){
+		schedule[i].period_s = settings.module_period_s[i];
+		schedule[i].phase_s = settings.module_phase_s[i];
+		schedule[i].next_s = 0;
+	}
 }
 
-int init_modules(void){
+uint8_t modules_due(uint32_t timestamp, uint8_t* flags){
+	uint8_t due = 0;
+	Schedule_t* sched;
 
-	PRINTFUNCT;
+	*flags = 0;
 
-	int err = 0;
-	int i = 0;
+	for (uint8_t i = 0; i < MODULE_COUNT; i++){
+		sched = &schedule[i];
+		if (!(settings.sensors & (1 << i)) || timestamp < sched->next_s){
+			continue;
+		}
+		due |= (1 << i);
+		if (sched->period_s != 0){
+			sched->next_s = ((timestamp - sched->phase_s) / sched->period_s + 1) * sched->period_s + sched->phase_s;
+		}
+	}
 
-	while (sensor_list[i].sensor_mod != NULL){
-		err |= sensor_list[i].s_init((Sensor_t*)(&(sensor_list[i])));
-		i++;
+#if AS7262_DARK_GATING_EN
+	wake_timestamp = timestamp;
+	if ((due & MODULE_AS7262) && as7262_dark && _is_night(timestamp) &&
+		timestamp - as7262_read_s < AS7262_DARK_RECHECK_S){
+		due &= ~MODULE_AS7262;
+		*flags |= FRAME_FLAG_DARK;
 	}
+#endif
 
-	return err;
+	return due;
 }
 
-int exec_modules(uint8_t* data){
+/* Walks the registry from a sensor id to the end at compile time,
+ * the recursion is unrolled and every sensor call inlined. */
+template <uint8_t id>
+struct _sensors{
+	// Worst case : every sensor up to this one present.
+	static_assert(FRAME_MEAS_OFFSET + sensor_frame_bytes(bit(id + 1) - 1) + CHECKSUM_BYTES <= FRAME_MAX_BYTES,
+				  "Sensor slot overflows the frame buffer");
+
+	static int init(uint8_t modules){
+		int err = ERROR_OK;
+
+		if (modules & bit(id)){
+			power_ready(id);
+			if ((err = _sensor_init<id>()) != ERROR_OK){
+				diag_init_failed(id);
+			}
+		}
+		return err | _sensors<id + 1>::init(modules);
+	}
 
-	PRINTFUNCT;
+	static uint8_t exec(uint8_t* data, uint8_t* modules, int* err){
+		uint8_t len = 0;
+		int e;
+
+		if (*modules & bit(id)){
+			power_ready(id);
+			if ((e = _sensor_init<id>()) != ERROR_OK){
+				diag_init_failed(id);
+			} else if ((e = _sensor_read<id>(data)) != ERROR_OK){
+				diag_read_failed(id);
+			}
+			power_done(id);
+			watchdog_kick();
+
+			if (e == ERROR_OK){
+				len = sensor_meas_bytes(id);
+			} else {
+				// Saved as missing, the next sensors are still read.
+				TRACE(TRACE_EV_MODULE_MISSING);
+				*modules &= ~bit(id);
+				*err |= e;
+			}
+		}
+		return len + _sensors<id + 1>::exec(data + len, modules, err);
+	}
+};
 
-	int i = 0;
-	int ix = 0;
+template <>
+struct _sensors<SENSOR_COUNT>{
+	static int init(uint8_t modules){
+		return ERROR_OK;
+	}
 
-	while (sensor_list[i].sensor_mod != NULL){
-		ix += sensor_list[i].s_read((Sensor_t*)(&(sensor_list[i])), data + ix);
-		i++;
+	static uint8_t exec(uint8_t* data, uint8_t* modules, int* err){
+		return 0;
 	}
+};
+
+int init_modules(uint8_t modules){
+
+	TRACE(TRACE_EV_INIT_MODULES);
+
+	return _sensors<0>::init(modules);
+}
+
+uint8_t exec_modules(frame_t& frame, uint8_t* modules, int* err){
+
+	TRACE(TRACE_EV_EXEC_MODULES);
 
-	return ix;
-}
\ No newline at end of file
+	uint8_t len;
+
+	*err = ERROR_OK;
+
+	// Each rail is only on from its planned switch-on to the end of its read.
+	power_plan(*modules);
+
+	len = _sensors<0>::exec(frame + FRAME_MEAS_OFFSET, modules, err);
+
+	power_all_off();
+
+	return len;
+}
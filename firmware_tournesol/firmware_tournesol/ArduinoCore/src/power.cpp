@@ -0,0 +1,227 @@
+/*
+ * power.cpp
+ *
+ * Created: 2026-10-19 4:41:08 PM
+ *  Author: Alexis Laframboise
+ */
+
+#include <Wire.h>
+
+#include "power.h"
+#include "energy.h"
+#include "clock.h"
+#include "common.h"
+
+typedef struct power_domain_t{
+	uint8_t pin;
+	uint8_t on_level;
+	uint8_t energy_rail;
+} power_domain_t;
+
+/* Same order as power_rail_t */
+static const power_domain_t power_domains[POWER_RAIL_COUNT] = {
+	{AS7262_POWER_PIN, HIGH, ENERGY_RAIL_AS7262},
+	{HDC1080_POWER_PIN, HIGH, ENERGY_RAIL_HDC1080},
+	{PT100_POWER_PIN, HIGH, ENERGY_RAIL_PT100},
+	{RELAY_9V_PIN, LOW, ENERGY_RAIL_RELAY_9V}
+};
+
+static constexpr uint16_t power_warmup_ms[POWER_RAIL_COUNT] = POWER_WARMUP_MS;
+static constexpr uint16_t power_read_ms[POWER_RAIL_COUNT] = POWER_READ_MS;
+
+/* Longest plan, every module read : the plan times are 16 bits */
+static constexpr uint32_t _power_plan_ms(uint8_t rail){
+	return (rail == POWER_RAIL_COUNT) ? 0 :
+		(uint32_t)power_warmup_ms[rail] + power_read_ms[rail] + _power_plan_ms(rail + 1);
+}
+
+static_assert(POWER_RAIL_COUNT == MODULE_COUNT, "Power rails don't match the modules");
+static_assert(_power_plan_ms(0) <= UINT16_MAX, "Power plan overflows its 16 bits times");
+
+#define PRR_ALL		(bit(PRTWI) | bit(PRTIM2) | bit(PRTIM0) | bit(PRTIM1) |\
+					 bit(PRSPI) | bit(PRUSART0) | bit(PRADC))
+
+/* Peripherals gated in each phase, same order as power_phase_t.
+ * Timer0 (millis) and Timer1 (energy ticks) keep running while
+ * awake, Timer2 is never used. */
+static const uint8_t power_phase_prr[POWER_PHASE_COUNT] = {
+	PRR_ALL,
+	bit(PRTIM2) | bit(PRSPI) | bit(PRUSART0),
+	bit(PRTWI) | bit(PRTIM2) | bit(PRUSART0) | bit(PRADC),
+	bit(PRTWI) | bit(PRTIM2) | bit(PRSPI) | bit(PRADC)
+};
+
+#if SERIAL_DEBUG_EN
+#define PRR_KEEP_AWAKE	(bit(PRUSART0))		/* Debug prints happen anywhere */
+#else
+#define PRR_KEEP_AWAKE	(0)
+#endif
+
+static uint8_t saved_adcsra = 0;
+
+static uint8_t rail_state = 0;
+static uint8_t rail_planned = 0;			/* Planned rails not switched on yet */
+static uint32_t plan_start = 0;
+static uint32_t rail_since[POWER_RAIL_COUNT] = {0};
+static uint16_t rail_on_at[POWER_RAIL_COUNT] = {0};	/* ms after plan_start */
+static uint16_t rail_on_ms[POWER_RAIL_COUNT] = {0};
+
+/** @brief	Switches on the planned rails whose time has come.
+ *
+ *  @return	ms until the next planned switch-on, 0xFFFF if none
+ */
+static uint16_t _power_poll(void){
+	uint32_t elapsed = millis() - plan_start;
+	uint16_t next = 0xFFFF;
+
+	for (uint8_t i = 0; i < POWER_RAIL_COUNT; i++){
+		if (!(rail_planned & bit(i))){
+			continue;
+		}
+		if (rail_on_at[i] <= elapsed){
+			power_on(i);
+		} else {
+			next = min(next, rail_on_at[i] - elapsed);
+		}
+	}
+	return next;
+}
+
+void power_init(void){
+	TRACE(TRACE_EV_INIT_INSTRUMENTS);
+	for (uint8_t i = 0; i < POWER_RAIL_COUNT; i++){
+		digitalWrite(power_domains[i].pin, !power_domains[i].on_level);
+		pinMode(power_domains[i].pin, OUTPUT);
+	}
+	rail_state = 0;
+
+	// Never used, the analog pins are only read by the ADC.
+	ACSR = bit(ACD);
+	DIDR0 = bit(ANEMO_ADC_PIN - A0) | bit(PT100_ADC_PIN - A0);
+}
+
+void power_phase(uint8_t phase){
+	uint8_t gate = power_phase_prr[phase];
+
+	if (phase != POWER_PHASE_SLEEP){
+		gate &= ~PRR_KEEP_AWAKE;
+	}
+#if !SERIAL_EN
+	gate |= bit(PRUSART0);
+#endif
+
+	uint8_t off = gate & ~PRR;
+	uint8_t on = PRR & ~gate & PRR_ALL;
+
+	// Shut down before gating, a gated peripheral can't be stopped.
+	if (off & bit(PRUSART0)){
+		Serial.flush();
+		Serial.end();
+	}
+	if (off & bit(PRTWI)){
+		Wire.end();		// Also drops the SDA/SCL pull-ups
+	}
+	if (off & bit(PRADC)){
+		saved_adcsra = ADCSRA;
+		ADCSRA = 0;
+	}
+	if (off & bit(PRSPI)){
+		SPCR &= ~bit(SPE);	// Set again by each SPI transaction
+	}
+
+	PRR = gate;
+
+	// Peripherals clocked again must be initialized again.
+	if (on & bit(PRADC)){
+		ADCSRA = saved_adcsra;
+	}
+	if (on & bit(PRTWI)){
+		Wire.begin();
+	}
+#if SERIAL_EN
+	if (on & bit(PRUSART0)){
+		Serial.begin(SERIAL_BAUD_RATE);
+	}
+#endif
+}
+
+void power_on(uint8_t rail){
+	rail_planned &= ~bit(rail);
+	if (rail_state & bit(rail)){
+		return;
+	}
+	TRACE(rail == POWER_RAIL_RELAY_9V ? TRACE_EV_ACTIVATE_RELAY : TRACE_EV_ACTIVATE_INSTRUMENTS);
+	digitalWrite(power_domains[rail].pin, power_domains[rail].on_level);
+	energy_rail_on(power_domains[rail].energy_rail);
+	rail_state |= bit(rail);
+	rail_since[rail] = millis();
+}
+
+void power_off(uint8_t rail){
+	if (!(rail_state & bit(rail))){
+		return;
+	}
+	TRACE(rail == POWER_RAIL_RELAY_9V ? TRACE_EV_DEACTIVATE_RELAY : TRACE_EV_DEACTIVATE_INSTRUMENTS);
+	digitalWrite(power_domains[rail].pin, !power_domains[rail].on_level);
+	energy_rail_off(power_domains[rail].energy_rail);
+	rail_state &= ~bit(rail);
+	rail_on_ms[rail] += millis() - rail_since[rail];
+}
+
+void power_all_off(void){
+	rail_planned = 0;
+	for (uint8_t i = 0; i < POWER_RAIL_COUNT; i++){
+		power_off(i);
+	}
+}
+
+void power_plan(uint8_t modules){
+	uint16_t t = 0;		// Read start of the current module
+
+	// The modules are read in order : a rail is switched on its
+	// warm-up before its read, but not before the plan starts.
+	rail_planned = 0;
+	for (uint8_t i = 0; i < POWER_RAIL_COUNT; i++){
+		rail_on_ms[i] = 0;
+		if (modules & bit(i)){
+			t = max(t, power_warmup_ms[i]);
+			rail_on_at[i] = t - power_warmup_ms[i];
+			t += power_read_ms[i];
+			rail_planned |= bit(i);
+		}
+	}
+
+	plan_start = millis();
+	_power_poll();
+}
+
+void power_ready(uint8_t rail){
+	uint32_t elapsed;
+	uint16_t next;
+
+	next = _power_poll();
+	power_on(rail);
+
+	// Waits at the divided clock, waking up for the planned switch-ons.
+	while ((elapsed = millis() - rail_since[rail]) < power_warmup_ms[rail]){
+		clock_wait_ms(min(next, power_warmup_ms[rail] - elapsed));
+		next = _power_poll();
+	}
+}
+
+void power_done(uint8_t rail){
+	power_off(rail);
+	_power_poll();
+
+#if DEBUG_POWER_SERIAL
+	Serial.print("Rail "); Serial.print(rail);
+	Serial.print(" on (ms): "); Serial.println(rail_on_ms[rail]);
+#endif
+}
+
+uint16_t power_on_ms(uint8_t rail){
+	if (rail_state & bit(rail)){
+		return rail_on_ms[rail] + (millis() - rail_since[rail]);
+	}
+	return rail_on_ms[rail];
+}
@@ -6,9 +6,53 @@
  */
 #include "rtc.h"
 #include "common.h"
+#include "settings.h"
+#include "bus.h"
+#include "diag.h"
 
 int ds3231_init(uint8_t set_current_time);
 
+/** @brief	Programs the next alarm, once more after a bus
+ *			recovery if it failed. An alarm left on its past
+ *			date would only match next month : the station
+ *			falls back on a wake every minute, and the next
+ *			wake programs the period again.
+ *
+ *  @param	period in seconds
+ *  @return	1 if the period alarm or the fallback is set
+ */
+static uint8_t _rtc_set_alarm(uint16_t period_s);
+
+#if ADAPTIVE_SAMPLING_EN
+
+#define SAMPLING_CHANNELS	(TOTAL_MEAS_CHANNELS)
+
+/** @brief	Counts the thresholds of a sensor.
+ */
+template <typename... T>
+constexpr uint8_t _sampling_rate_count(T...){
+	return sizeof...(T);
+}
+
+#define SENSOR_SAMPLING_RATE(name, channels, meta)	name##_SAMPLING_RATES,
+#define SENSOR_SAMPLING_CHECK(name, channels, meta)	\
+	static_assert(_sampling_rate_count(name##_SAMPLING_RATES) == channels, \
+				  #name "_SAMPLING_RATES doesn't match the registry");
+
+/* Change threshold of each channel, in frame order */
+const float SAMPLING_RATE[SAMPLING_CHANNELS] PROGMEM = {
+	SENSOR_REGISTRY(SENSOR_SAMPLING_RATE)
+};
+
+SENSOR_REGISTRY(SENSOR_SAMPLING_CHECK)
+
+static float last_meas[SAMPLING_CHANNELS];
+static uint32_t last_timestamp[MODULE_COUNT] = {0};
+
+#endif
+
+static uint16_t sampling_period_s = 0;
+
 int rtc_init(){
 	return ds3231_init(UPDATE_TIMESTAMP);
 }
@@ -16,24 +60,30 @@ int rtc_init(){
 int ds3231_init(uint8_t set_current_time){
 
 	int err = 0;
-	PRINTFUNCT;
+	TRACE(TRACE_EV_DS3231_INIT);
 
 	DS3231_config_t ds3231_config = DS3231_CONFIG_DEFAULT;
 	DS3231_alm_config_t alm1_config;
 	DS3231_alm_config_t alm2_config;
 
-	alm1_config.mask = DS3231_ALARM1_MASK;
-	alm1_config.sec  = DS3231_ALARM1_SEC;
-	alm1_config.min  = DS3231_ALARM1_MIN;
-	alm1_config.hour = DS3231_ALARM1_HOUR;
+	alm1_config.mask = settings.alarm1_mask;
+	alm1_config.sec  = settings.alarm1_sec;
+	alm1_config.min  = settings.alarm1_min;
+	alm1_config.hour = settings.alarm1_hour;
 
-	alm2_config.mask = DS3231_ALARM2_MASK;
-	alm2_config.min  = DS3231_ALARM2_MIN;
-	alm2_config.hour = DS3231_ALARM2_HOUR;
+	alm2_config.mask = settings.alarm2_mask;
+	alm2_config.min  = settings.alarm2_min;
+	alm2_config.hour = settings.alarm2_hour;
 
 	ds3231_config.pAlarm_1 = &alm1_config;
 	ds3231_config.pAlarm_2 = &alm2_config;
 
+	// With a sampling period, alarm 1 is programmed below.
+	if (settings.period_s != 0){
+		ds3231_config.pAlarm_1 = NULL;
+		ds3231_config.pAlarm_2 = NULL;
+	}
+
 	#if DEBUG_DS3231_SERIAL
 	Serial.print("alm1 mask : "); Serial.println(ds3231_config.pAlarm_1->mask);
 	Serial.print("alm1 sec : "); Serial.println(ds3231_config.pAlarm_1->sec);
@@ -52,5 +102,67 @@ int ds3231_init(uint8_t set_current_time){
 		DS3231_set_datetime(UNIX_CURRENT_TIMESTAMP);
 	}
 
+	sampling_period_s = settings.period_s;
+	if (sampling_period_s != 0 && !_rtc_set_alarm(sampling_period_s)){
+		err |= ERROR_RTC;
+	}
+
 	return err;
-}
\ No newline at end of file
+}
+
+void rtc_schedule_next(uint32_t timestamp, const uint8_t* meas, uint8_t modules){
+	if (sampling_period_s == 0){
+		return;
+	}
+
+#if ADAPTIVE_SAMPLING_EN
+	// Without the time, the change rate is unknown : the period is kept.
+	if (settings.period_max_s > settings.period_s && timestamp != 0){
+		uint8_t changed = 0;
+		uint8_t ch = 0;
+		float elapsed_min;
+		data_float_bytes fb;
+
+		// The frame only holds the modules read at this wake,
+		// each one is compared with its own previous reading.
+		for (uint8_t m = 0; m < MODULE_COUNT; m++){
+			uint8_t n = sensor_layout[m].channels;
+			if (modules & (1 << m)){
+				elapsed_min = (timestamp - last_timestamp[m]) / (float)SECONDS_IN_MINUTE;
+				for (uint8_t i = ch; i < ch + n; i++){
+					memcpy(fb.bytes, meas, sizeof(float));
+					meas += sizeof(float);
+					if (last_timestamp[m] != 0 &&
+						fabs(fb.value - last_meas[i]) > pgm_read_float(&SAMPLING_RATE[i]) * elapsed_min){
+						changed = 1;
+					}
+					last_meas[i] = fb.value;
+				}
+				meas += sensor_layout[m].meta_bytes;
+				last_timestamp[m] = timestamp;
+			}
+			ch += n;
+		}
+
+		if (changed){
+			sampling_period_s = settings.period_s;
+		} else if (sampling_period_s < settings.period_max_s){
+			sampling_period_s = min(2 * (uint32_t)sampling_period_s, settings.period_max_s);
+		}
+	}
+#endif
+
+	_rtc_set_alarm(sampling_period_s);
+}
+
+static uint8_t _rtc_set_alarm(uint16_t period_s){
+	if (DS3231_set_next_alarm(period_s) != 0){
+		return 1;
+	}
+	bus_recover();
+	if (DS3231_set_next_alarm(period_s) != 0){
+		return 1;
+	}
+	diag_rtc_failed();
+	return DS3231_set_minute_alarm();
+}
@@ -0,0 +1,288 @@
+/*
+ * sdstream.cpp
+ *
+ * Created: 2026-10-19 7:58:14 PM
+ *  Author: Alexis Laframboise
+ */
+
+#include "sdstream.h"
+#include "energy.h"
+#include "diag.h"
+
+#include <util/crc16.h>
+#include <SPI.h>
+#include <SD.h>
+
+#if SD_STREAM_EN
+
+static_assert(STREAM_HEADER_BYTES + sizeof(frame_t) <= STREAM_PAYLOAD_END, "A frame doesn't fit a stream block");
+
+/* First block of the region, the data blocks follow it */
+typedef struct stream_super_t{
+	char magic[sizeof(STREAM_MAGIC) - 1];
+	uint8_t version;
+	uint32_t first;						/* Address of the first data block */
+	uint32_t count;						/* Data blocks */
+} stream_super_t;
+
+static Sd2Card* card = NULL;
+static uint8_t started = 0;
+static uint8_t* block = NULL;			/* Block being built, in the SD cache */
+static uint16_t block_fill = 0;			/* 0 until the block is started */
+static uint32_t block_seq = 0;			/* Sequence number of block_next */
+static uint32_t block_next = 0;			/* Next block of the region to write */
+static uint32_t region_bgn = 0;			/* First data block of the region */
+static uint32_t region_end = 0;			/* Last block of the region */
+static uint8_t writing = 0;				/* The CMD25 sequence is open */
+
+static uint16_t _stream_crc(const uint8_t* buf){
+	uint16_t crc = 0;
+
+	for (uint16_t i = 0; i < STREAM_PAYLOAD_END; i++){
+		crc = _crc_xmodem_update(crc, buf[i]);
+	}
+	return crc;
+}
+
+/** @brief	Writes the CRC at the end of a block.
+ */
+static void _stream_seal(uint8_t* buf){
+	uint16_t crc = _stream_crc(buf);
+
+	buf[STREAM_PAYLOAD_END] = (uint8_t)(crc >> 8);
+	buf[STREAM_PAYLOAD_END + 1] = (uint8_t)(crc & 0xFF);
+}
+
+static uint8_t _stream_sealed(const uint8_t* buf){
+	return (_stream_crc(buf) == ((uint16_t)buf[STREAM_PAYLOAD_END] << 8 | buf[STREAM_PAYLOAD_END + 1]));
+}
+
+/** @brief	Checks a block read from the region.
+ *
+ *  @param	block, SD_BLOCK_BYTES
+ *  @param	sequence number the block must hold
+ *  @return	1 if the block is valid, 0 otherwise
+ */
+static uint8_t _stream_block_valid(const uint8_t* buf, uint32_t seq){
+	uint32_t held;
+
+	memcpy(&held, buf + 1, sizeof(held));
+	return (buf[0] == STREAM_BLOCK_TAG && held == seq && _stream_sealed(buf));
+}
+
+/** @brief	Finds the blocks of the region, superblock included.
+ *
+ *  @param	first block of the region
+ *  @param	last block of the region
+ *  @return	error code
+ */
+static int _stream_region(uint32_t* bgn, uint32_t* end){
+#if SD_STREAM_RAW
+	// The first partition stays FAT, the settings are read from it.
+	const mbr_t* mbr = reinterpret_cast<const mbr_t*>(SdVolume::cacheClear());
+
+	if (!card->readBlock(0, (uint8_t*)mbr) || mbr->mbrSig0 != BOOTSIG0 || mbr->mbrSig1 != BOOTSIG1){
+		return ERROR_SD;
+	}
+	for (uint8_t i = 0; i < 4; i++){
+		if (mbr->part[i].type == SD_STREAM_PART_TYPE && mbr->part[i].totalSectors > 1){
+			*bgn = mbr->part[i].firstSector;
+			*end = *bgn + mbr->part[i].totalSectors - 1;
+			return ERROR_OK;
+		}
+	}
+	return ERROR_SD;
+#else
+	int err = ERROR_OK;
+
+	File file = SD.open(SD_STREAM_FILE_NAME, FILE_READ);
+	if (!file){
+		file = SD.createContiguous(SD_STREAM_FILE_NAME, SD_STREAM_BLOCKS * SD_BLOCK_BYTES);
+	}
+
+	// A copied file may be fragmented, it can't be streamed.
+	if (file && file.contiguousRange(bgn, end) && file.size() >= 2 * SD_BLOCK_BYTES){
+		*end = min(*end, *bgn + file.size() / SD_BLOCK_BYTES - 1);
+	} else {
+		err = ERROR_SD;
+	}
+	file.close();
+	return err;
+#endif
+}
+
+/** @brief	Tells if a block is in the erased state of the card.
+ */
+static uint8_t _stream_blank(const uint8_t* buf){
+	for (uint16_t i = 1; i < SD_BLOCK_BYTES; i++){
+		if (buf[i] != buf[0]){
+			return 0;
+		}
+	}
+	return (buf[0] == 0x00 || buf[0] == 0xFF);
+}
+
+/** @brief	Checks the superblock, writes it if it doesn't match
+ *			the region. The data blocks are erased first : they
+ *			are only programmed afterwards, and cards without
+ *			single block erase still get the ACMD23 pre-erase.
+ *			The region is only erased when the superblock is
+ *			blank or sealed for another layout : a failed read
+ *			or a damaged superblock leaves the frames in place.
+ *
+ *  @param	address of the superblock
+ *  @return	error code
+ */
+static int _stream_format(uint32_t super){
+	uint8_t* buf = SdVolume::cacheClear();
+	stream_super_t* sb = reinterpret_cast<stream_super_t*>(buf);
+
+	if (!card->readBlock(super, buf)){
+		return ERROR_SD;
+	}
+	if (!_stream_blank(buf)){
+		if (!_stream_sealed(buf)){
+			return ERROR_SD;
+		}
+		if (memcmp(sb->magic, STREAM_MAGIC, sizeof(sb->magic)) == 0 &&
+			sb->version == STREAM_LAYOUT_VERSION &&
+			sb->first == region_bgn && sb->count == region_end - region_bgn + 1){
+			return ERROR_OK;
+		}
+	}
+
+	card->erase(region_bgn, region_end);
+
+	memset(buf, 0, SD_BLOCK_BYTES);
+	memcpy(sb->magic, STREAM_MAGIC, sizeof(sb->magic));
+	sb->version = STREAM_LAYOUT_VERSION;
+	sb->first = region_bgn;
+	sb->count = region_end - region_bgn + 1;
+	_stream_seal(buf);
+	return card->writeBlock(super, buf) ? ERROR_OK : ERROR_SD;
+}
+
+/** @brief	Finds the block after the last valid one. The valid
+ *			blocks are a prefix of the region, numbered from
+ *			the sequence number of the first one.
+ */
+static void _stream_find_tail(void){
+	uint8_t* buf = SdVolume::cacheClear();
+	uint32_t seq0;
+	uint32_t lo = 0;							/* Valid */
+	uint32_t hi = region_end - region_bgn + 1;	/* Not valid */
+
+	block_next = region_bgn;
+	block_seq = 0;
+	if (!card->readBlock(region_bgn, buf)){
+		return;
+	}
+	memcpy(&seq0, buf + 1, sizeof(seq0));
+	if (!_stream_block_valid(buf, seq0)){
+		return;
+	}
+
+	while (hi - lo > 1){
+		uint32_t mid = lo + (hi - lo) / 2;
+		if (card->readBlock(region_bgn + mid, buf) && _stream_block_valid(buf, seq0 + mid)){
+			lo = mid;
+		} else {
+			hi = mid;
+		}
+	}
+	block_next = region_bgn + hi;
+	block_seq = seq0 + hi;
+}
+
+int sdstream_init(void){
+	TRACE(TRACE_EV_STREAM_INIT);
+
+	uint32_t super = 0;
+	int err = ERROR_SD;
+
+	card = SdVolume::sdCard();
+	if (card == NULL){
+		return err;
+	}
+
+	energy_rail_on(ENERGY_RAIL_SD);
+
+	err = _stream_region(&super, &region_end);
+	if (err == ERROR_OK){
+		region_bgn = super + 1;
+		err = _stream_format(super);
+	}
+	if (err == ERROR_OK){
+		_stream_find_tail();
+		started = 1;
+	}
+
+	energy_rail_off(ENERGY_RAIL_SD);
+
+#if SERIAL_DEBUG_EN
+	if (err != ERROR_OK){
+		Serial.print("ERROR : "); Serial.print(__FUNCTION__); Serial.println(" : No stream region.");
+	}
+#endif
+	return err;
+}
+
+uint8_t* sdstream_reserve(void){
+	if (!started || block_next > region_end){
+		return NULL;
+	}
+	if (block_fill == 0){
+		block = SdVolume::cacheClear();
+		block_fill = STREAM_HEADER_BYTES;
+	}
+	return block + block_fill;
+}
+
+void sdstream_commit(uint8_t len){
+	block_fill += len;
+	if ((uint16_t)(STREAM_PAYLOAD_END - block_fill) >= sizeof(frame_t)){
+		return;
+	}
+
+	TRACE(TRACE_EV_STREAM_WRITE);
+
+	memset(block + block_fill, FRAME_PAD, STREAM_PAYLOAD_END - block_fill);
+	block_fill = 0;
+
+	block[0] = STREAM_BLOCK_TAG;
+	memcpy(block + 1, &block_seq, sizeof(block_seq));
+	_stream_seal(block);
+
+	energy_rail_on(ENERGY_RAIL_SD);
+
+	if (!writing){
+		writing = card->writeStart(block_next, region_end - block_next + 1);
+		if (!writing){
+			diag_sd_failed();
+		}
+	}
+	if (writing){
+		uint32_t start = energy_ticks();
+		uint8_t written = card->writeData(block);
+
+		diag_sd_write(energy_ticks() - start);
+
+		if (written){
+			block_next++;
+			block_seq++;
+		} else {
+			// The block is lost, the next one starts a new sequence here.
+			diag_sd_failed();
+			card->writeStop();
+			writing = 0;
+		}
+	}
+	if (writing && block_next > region_end){
+		card->writeStop();
+		writing = 0;
+	}
+
+	energy_rail_off(ENERGY_RAIL_SD);
+}
+
+#endif /* SD_STREAM_EN */
@@ -0,0 +1,102 @@
+/*
+ * settings.cpp
+ *
+ * Created: 2026-10-19 4:52:18 PM
+ *  Author: Alexis Laframboise
+ */
+
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+
+#include "settings.h"
+#include "common.h"
+
+#include "drivers/PT100.h"
+#include "drivers/anemometer.h"
+
+#include <SPI.h>
+#include <SD.h>
+
+settings_t settings = {
+	SETTINGS_TAG,
+	SETTINGS_VERSION,
+	SETTINGS_BYTES,
+	MODULE_ALL,
+	DS3231_ALARM1_MASK,
+	DS3231_ALARM1_SEC,
+	DS3231_ALARM1_MIN,
+	DS3231_ALARM1_HOUR,
+	DS3231_ALARM2_MASK,
+	DS3231_ALARM2_MIN,
+	DS3231_ALARM2_HOUR,
+	SAMPLING_PERIOD_S,
+	SAMPLING_PERIOD_MAX_S,
+	{AS7262_PERIOD_S, HDC1080_PERIOD_S, PT100_PERIOD_S, ANEMOMETER_PERIOD_S},
+	{AS7262_PHASE_S, HDC1080_PHASE_S, PT100_PHASE_S, ANEMOMETER_PHASE_S},
+	{AS7262_CALIBRATED_DARK_OFFSET_CH1, AS7262_CALIBRATED_DARK_OFFSET_CH2,
+	 AS7262_CALIBRATED_DARK_OFFSET_CH3, AS7262_CALIBRATED_DARK_OFFSET_CH4,
+	 AS7262_CALIBRATED_DARK_OFFSET_CH5, AS7262_CALIBRATED_DARK_OFFSET_CH6},
+	{AS7262_CALIBRATED_DIFFUSER_MULTIPLIER_CH1, AS7262_CALIBRATED_DIFFUSER_MULTIPLIER_CH2,
+	 AS7262_CALIBRATED_DIFFUSER_MULTIPLIER_CH3, AS7262_CALIBRATED_DIFFUSER_MULTIPLIER_CH4,
+	 AS7262_CALIBRATED_DIFFUSER_MULTIPLIER_CH5, AS7262_CALIBRATED_DIFFUSER_MULTIPLIER_CH6},
+	PT100_C1,
+	PT100_C2,
+	ANEMO_C1,
+	ANEMO_C2,
+	0
+};
+
+static_assert(SETTINGS_BYTES < 256, "settings_t length doesn't fit its len field");
+static_assert(SETTINGS_EEPROM_ADDR + SETTINGS_BYTES <= E2END + 1, "settings_t doesn't fit the EEPROM");
+
+/** @brief	Checks the header and the CRC of a settings block.
+ *
+ *  @param	settings block
+ *  @return	1 if the block can be used, 0 otherwise
+ */
+static uint8_t _settings_valid(const settings_bytes* sb){
+	uint16_t crc = 0;
+
+	if (sb->settings.tag != SETTINGS_TAG ||
+		sb->settings.version != SETTINGS_VERSION ||
+		sb->settings.len != SETTINGS_BYTES){
+		return 0;
+	}
+	for (uint8_t i = 0; i < SETTINGS_BYTES - sizeof(sb->settings.crc); i++){
+		crc = _crc_xmodem_update(crc, sb->bytes[i]);
+	}
+	return (crc == sb->settings.crc);
+}
+
+int settings_init(void){
+	uint8_t file_bad = 0;
+	settings_bytes sb;
+
+	TRACE(TRACE_EV_SETTINGS_INIT);
+
+#if !DEBUG_NO_SD
+	File file = SD.open(SETTINGS_FILE_NAME, FILE_READ);
+	if (file){
+		// eeprom_update_block only writes the bytes that changed,
+		// so leaving the file on the card costs no EEPROM wear.
+		if (file.read(sb.bytes, SETTINGS_BYTES) == SETTINGS_BYTES && _settings_valid(&sb)){
+			eeprom_update_block(sb.bytes, (void*)SETTINGS_EEPROM_ADDR, SETTINGS_BYTES);
+		} else {
+			#if SERIAL_DEBUG_EN
+			Serial.print("ERROR : "); Serial.print(__FUNCTION__); Serial.println(" : Invalid settings file.");
+			#endif
+			file_bad = 1;
+		}
+		file.close();
+	}
+#endif
+
+	// A corrupted file falls back on the block already in EEPROM.
+	eeprom_read_block(sb.bytes, (const void*)SETTINGS_EEPROM_ADDR, SETTINGS_BYTES);
+	if (_settings_valid(&sb)){
+		settings = sb.settings;
+		return ERROR_OK;
+	}
+
+	return file_bad ? ERROR_SETTINGS : ERROR_OK;
+}
@@ -8,6 +8,7 @@
 #include <avr/interrupt.h>
 
 #include "sleep.h"
+#include "power.h"
 #include "common.h"
 
 void sleepISR();
@@ -16,15 +17,15 @@ volatile uint8_t wake_flag = 0;
 
 void goto_sleep(void){
 
-	PRINTFUNCT;
+	TRACE(TRACE_EV_GOTO_SLEEP);
 
 	/*
 	* Borrowed from :
 	* https://github.com/RalphBacon/192-DS3231-Wake-Up-Arduino/blob/master/YouTube%20Sketch2%20Sleep/Arduino_Sleep_DS3231_Wakeup.cpp
 	*/
-	// Disable the ADC (Analog to digital converter, pins A0 [14] to A5 [19])
-	static byte prevADCSRA = ADCSRA;
-	ADCSRA = 0;
+	// Disable the ADC and gate every peripheral clock, this also
+	// flushes the serial port and drops the TWI pull-ups.
+	power_phase(POWER_PHASE_SLEEP);
 
 	/* Set the type of sleep mode we want. Can be one of (in order of power saving):
 	SLEEP_MODE_IDLE (Timer 0 will wake up every millisecond to keep millis running)
@@ -59,13 +60,13 @@ void goto_sleep(void){
 	// Allow interrupts now
 	interrupts();
 
-	Serial.flush();
-
 	// And enter sleep mode as set above
 	sleep_cpu();
 
-	// Re-enable ADC if it was previously running
-	ADCSRA = prevADCSRA;
+	TRACE(TRACE_EV_WAKE);
+
+	// A wake starts by reading the RTC
+	power_phase(POWER_PHASE_SENSORS);
 }
 
 void sleepISR(){
@@ -0,0 +1,74 @@
+/*
+ * sram.cpp
+ *
+ * Created: 2026-10-19 8:41:27 PM
+ *  Author: Alexis Laframboise
+ */
+
+#include "sram.h"
+#include "common.h"
+
+extern char __data_start;
+extern char __data_end;
+extern char __bss_start;
+extern char __heap_start;		/* End of .bss and .noinit */
+extern char* __brkval;			/* Top of the heap, NULL until malloc() is used */
+
+static uint16_t heap_high = 0;
+
+/* Runs before the stack pointer is set, no call nor stack use. */
+void _sram_paint(void) __attribute__((naked, used, section(".init1")));
+
+void _sram_paint(void){
+	__asm__ volatile (
+		"	ldi r30, lo8(__heap_start)	\n"
+		"	ldi r31, hi8(__heap_start)	\n"
+		"	ldi r24, %0					\n"
+		"	ldi r25, hi8(%1)			\n"
+		"1:	st Z+, r24					\n"
+		"	cpi r30, lo8(%1)			\n"
+		"	cpc r31, r25				\n"
+		"	brlo 1b						\n"
+		:
+		: "i" (SRAM_PAINT), "i" (RAMEND + 1)
+	);
+}
+
+uint16_t sram_heap_high(void){
+	if (__brkval != NULL){
+		heap_high = max(heap_high, (uint16_t)(__brkval - &__heap_start));
+	}
+	return heap_high;
+}
+
+/** @brief	Finds the lowest byte reached by the stack, from
+ *			the highest top of the heap.
+ *
+ *  @return	its address
+ */
+static const char* _sram_stack_low(void){
+	const char* p = &__heap_start + sram_heap_high();
+
+	while (p <= (const char*)RAMEND && *p == (char)SRAM_PAINT){
+		p++;
+	}
+	return p;
+}
+
+uint16_t sram_stack_high(void){
+	return (const char*)RAMEND + 1 - _sram_stack_low();
+}
+
+uint16_t sram_free_low(void){
+	return _sram_stack_low() - (&__heap_start + sram_heap_high());
+}
+
+void sram_dump(void){
+#if SERIAL_EN
+	Serial.print("SRAM (B) data: "); Serial.print(&__data_end - &__data_start);
+	Serial.print(", bss: "); Serial.print(&__heap_start - &__bss_start);
+	Serial.print(", heap: "); Serial.print(sram_heap_high());
+	Serial.print(", stack: "); Serial.print(sram_stack_high());
+	Serial.print(", free: "); Serial.println(sram_free_low());
+#endif
+}
@@ -15,40 +15,79 @@ ISR(TIMER1_COMPA_vect);
 volatile int ledState = 0;
 volatile int initStatus = 0;
 
-void signal_error(int err){
-	PRINTFUNCT;
-	uint8_t blink_cnt = 0;
+/** @brief	Gets the number of flashes of an error code.
+ *
+ *  @param	error code
+ *  @return	number of flashes
+ */
+static uint8_t _blink_count(int err){
 	if((err & ERROR_SD) != 0){
-		blink_cnt = 1;
+		return 1;
 		} else if((err & ERROR_RTD) != 0){
-		blink_cnt = 2;
+		return 2;
 		} else if((err & ERROR_ANEMOMETER) != 0){
-		blink_cnt = 3;
+		return 3;
 		} else if((err & ERROR_HDC1080) != 0){
-		blink_cnt = 4;
+		return 4;
 		} else if((err & ERROR_AS7262) != 0){
-		blink_cnt = 5;
+		return 5;
+		} else if((err & ERROR_SETTINGS) != 0){
+		return 6;
+		} else if((err & ERROR_RTC) != 0){
+		return 7;
 	}
+	return 0;
+}
+
+/** @brief	Flashes an error code once.
+ *
+ *  @param	number of flashes
+ */
+static void _blink(uint8_t blink_cnt){
+	for (int i = 0; i < blink_cnt; i++){
+		digitalWrite(ERROR_LED_PIN, HIGH);
+		delay(ERROR_BLINK_MS);
+		digitalWrite(ERROR_LED_PIN, LOW);
+		delay(ERROR_BLINK_MS);
+	}
+	delay(ERROR_BLINK_MS * 2);
+}
+
+void signal_error(int err){
+	TRACE(TRACE_EV_SIGNAL_ERROR);
+	uint8_t blink_cnt = _blink_count(err);
 
 	#if DEBUG_SIGNAL_ERROR_SERIAL
 	Serial.print("Error value : ");Serial.print(err);
 	Serial.print("\tBlink count : ");Serial.println(blink_cnt);
 	#endif
 
+	#if DEBUG_TRACE_SERIAL
+	trace_dump();
+	#endif
+
 	while(1){
-		for (int i = 0; i < blink_cnt; i++){
-			digitalWrite(ERROR_LED_PIN, HIGH);
-			delay(ERROR_BLINK_MS);
-			digitalWrite(ERROR_LED_PIN, LOW);
-			delay(ERROR_BLINK_MS);
-		}
-		delay(ERROR_BLINK_MS * 2);
+		_blink(blink_cnt);
+	}
+}
+
+void signal_warning(int err){
+	TRACE(TRACE_EV_SIGNAL_ERROR);
+	uint8_t blink_cnt = _blink_count(err);
+
+	#if DEBUG_SIGNAL_ERROR_SERIAL
+	Serial.print("Warning value : ");Serial.print(err);
+	Serial.print("\tBlink count : ");Serial.println(blink_cnt);
+	#endif
+
+	for (uint8_t i = 0; i < SIGNAL_WARNING_REPEAT; i++){
+		_blink(blink_cnt);
 	}
 }
 
 
 void status_blinker_init(void){
-	PRINTFUNCT;
+	TRACE(TRACE_EV_BLINKER_INIT);
 	pinMode(ERROR_LED_PIN, OUTPUT);
 
 	cli();
@@ -71,7 +110,7 @@ void status_blinker_init(void){
 }
 
 void status_blinker_disable(void){
-	PRINTFUNCT;
+	TRACE(TRACE_EV_BLINKER_DISABLE);
 	TIMSK1 &= ~(1 << OCIE1A); // turn off the timer interrupt
 	digitalWrite(ERROR_LED_PIN, LOW);
 	initStatus = 1;
@@ -0,0 +1,54 @@
+/*
+ * telemetry.cpp
+ *
+ * Created: 2026-10-19 1:47:05 PM
+ *  Author: Alexis Laframboise
+ */
+
+#include <util/crc16.h>
+
+#include "telemetry.h"
+#include "common.h"
+
+/* COBS code bytes can't announce more than 254 data bytes,
+ * frames are kept under that so there's a single block max. */
+#define TELEMETRY_MAX_PACKET	(254)
+
+void telemetry_send_frame(const uint8_t* data, uint8_t len){
+#if TELEMETRY_EN
+	uint16_t crc = 0;
+	uint8_t packet_len = len + TELEMETRY_CRC_BYTES;
+	uint8_t crc_bytes[TELEMETRY_CRC_BYTES];
+
+	if (len > TELEMETRY_MAX_PACKET - TELEMETRY_CRC_BYTES){
+		return;
+	}
+
+	for (uint8_t i = 0; i < len; i++){
+		crc = _crc_xmodem_update(crc, data[i]);
+	}
+	crc_bytes[0] = (uint8_t)(crc >> 8);
+	crc_bytes[1] = (uint8_t)(crc & 0xFF);
+
+	// Encodes on the fly, the packet is never copied.
+	uint8_t i = 0;
+	uint8_t j = 0;
+	uint8_t b = 0;
+	do {
+		j = i;
+		while (j < packet_len && (j < len ? data[j] : crc_bytes[j - len]) != 0){
+			j++;
+		}
+
+		Serial.write((uint8_t)(j - i + 1));
+		while (i < j){
+			b = (i < len) ? data[i] : crc_bytes[i - len];
+			Serial.write(b);
+			i++;
+		}
+		i++;
+	} while (i <= packet_len);
+
+	Serial.write((uint8_t)TELEMETRY_DELIMITER);
+#endif
+}
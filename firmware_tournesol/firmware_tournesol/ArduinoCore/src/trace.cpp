@@ -0,0 +1,71 @@
+/*
+ * trace.cpp
+ *
+ * Created: 2026-10-19 9:12:40 AM
+ *  Author: Alexis Laframboise
+ */
+
+#include "trace.h"
+#include "common.h"
+
+#include <SD.h>
+
+#if TRACE_EN
+
+trace_entry_t trace_buffer[TRACE_BUFFER_LEN];
+uint8_t trace_head = 0;
+uint8_t trace_count = 0;
+
+/** @brief	Writes the record header followed by every entry,
+ *			oldest first, then the sum.
+ *
+ *  @param	serial port or file to write the record to
+ */
+static void _trace_write(Print& out){
+	uint8_t ix = (trace_head - trace_count) & (TRACE_BUFFER_LEN - 1);
+	uint16_t sum = trace_count;
+
+	out.write((const uint8_t*)TRACE_RECORD_MAGIC, TRACE_MAGIC_BYTES);
+	out.write(trace_count);
+
+	for (uint8_t i = 0; i < trace_count; i++){
+		const uint8_t* entry = (const uint8_t*)&trace_buffer[ix];
+		for (uint8_t b = 0; b < TRACE_ENTRY_BYTES; b++){
+			sum += entry[b];
+		}
+		out.write(entry, TRACE_ENTRY_BYTES);
+		ix = (ix + 1) & (TRACE_BUFFER_LEN - 1);
+	}
+
+	out.write((uint8_t)(sum & 0x00FF));
+	out.write((uint8_t)((sum & 0xFF00) >> 8));
+}
+
+void trace_clear(void){
+	trace_head = 0;
+	trace_count = 0;
+}
+
+void trace_dump(void){
+#if SERIAL_EN
+	_trace_write(Serial);
+	Serial.flush();
+#endif
+}
+
+void trace_save(const char* fname){
+#if !DEBUG_NO_SD
+	File traceFile = SD.open(fname, FILE_WRITE);
+	_trace_write(traceFile);
+	traceFile.close();
+#endif
+	trace_clear();
+}
+
+#else
+
+void trace_clear(void){}
+void trace_dump(void){}
+void trace_save(const char* fname){}
+
+#endif /* TRACE_EN */
@@ -0,0 +1,45 @@
+/*
+ * watchdog.cpp
+ *
+ * Created: 2026-10-19 6:52:10 PM
+ *  Author: Alexis Laframboise
+ */
+
+#include <avr/wdt.h>
+
+#include "watchdog.h"
+#include "common.h"
+
+static uint8_t reset_flags __attribute__((section(".noinit")));
+
+/* The watchdog stays enabled, at its shortest timeout, after a
+ * watchdog reset : it must be stopped before the C runtime init. */
+void _watchdog_boot(void) __attribute__((naked, used, section(".init3")));
+
+void _watchdog_boot(void){
+	reset_flags = MCUSR;
+	MCUSR = 0;
+	wdt_disable();
+}
+
+void watchdog_begin_wake(void){
+#if WATCHDOG_EN
+	wdt_enable(WATCHDOG_TIMEOUT);
+#endif
+}
+
+void watchdog_kick(void){
+#if WATCHDOG_EN
+	wdt_reset();
+#endif
+}
+
+void watchdog_end_wake(void){
+#if WATCHDOG_EN
+	wdt_disable();
+#endif
+}
+
+uint8_t watchdog_reset_flags(void){
+	return reset_flags;
+}
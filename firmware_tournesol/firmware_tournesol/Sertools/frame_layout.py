@@ -0,0 +1,80 @@
+"""Generates the frame layout of the host decoder from the sensor registry.
+
+The registry (SENSOR_REGISTRY in config.h) is the single definition of the
+frame : the firmware computes the slot of each sensor and the frame size from
+it at compile time (registry.h), this script writes the same layout for
+Interface_Python/utils.py. Run it after every change of the registry.
+
+Usage :
+    python frame_layout.py
+    python frame_layout.py --check
+"""
+import argparse
+import os
+import re
+import sys
+
+from settings_generator import load_defines
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..')
+DEFAULT_CONFIG = os.path.join(ROOT, 'ArduinoCore', 'include', 'config.h')
+DEFAULT_OUTPUT = os.path.normpath(os.path.join(ROOT, '..', '..', 'Interface_Python', 'frame_layout.py'))
+
+BYTE_COUNT_FLOAT = 4
+
+TEMPLATE = '''# Generated by Sertools/frame_layout.py from SENSOR_REGISTRY (config.h), do not edit.
+FRAME_VERSION = {version}
+FRAME_HEADER_BYTES = {header}
+FRAME_MAX_BYTES = {max_bytes}
+
+# (name, float channels, metadata bytes) of each sensor, in frame order
+SENSOR_LAYOUT = [
+{entries}]
+'''
+
+
+def load_registry(config=DEFAULT_CONFIG):
+    """Returns the (name, channels, metadata bytes) of the registry, in order."""
+    with open(config, 'r') as f:
+        text = f.read()
+    body = re.search(r'#define\s+SENSOR_REGISTRY\(X\)((?:[^\n]*\\\n)*[^\n]*)', text).group(1)
+    defines = load_defines(config)
+
+    def value(token):
+        token = token.strip()
+        return int(token, 0) if token[0].isdigit() else defines[token]
+
+    return [(name.lower(), value(channels), value(meta))
+            for name, channels, meta in re.findall(r'X\((\w+),([^,]+),([^)]+)\)', body)]
+
+
+def render(config=DEFAULT_CONFIG):
+    defines = load_defines(config)
+    registry = load_registry(config)
+    meas_bytes = sum(channels * BYTE_COUNT_FLOAT + meta for _, channels, meta in registry)
+    max_bytes = defines['FRAME_HEADER_BYTES'] + 8 + meas_bytes + defines['CHECKSUM_BYTES']
+    entries = ''.join(f'    ({name!r}, {channels}, {meta}),\n' for name, channels, meta in registry)
+    return TEMPLATE.format(version=defines['FRAME_VERSION'], header=defines['FRAME_HEADER_BYTES'],
+                           max_bytes=max_bytes, entries=entries)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate the host frame layout from the sensor registry.')
+    parser.add_argument('--config', default=DEFAULT_CONFIG)
+    parser.add_argument('-o', '--output', default=DEFAULT_OUTPUT)
+    parser.add_argument('--check', action='store_true', help='fail if the output is out of date')
+    args = parser.parse_args()
+
+    text = render(args.config)
+    if args.check:
+        with open(args.output, 'r') as f:
+            if f.read() != text:
+                sys.exit(f'{args.output} is out of date, run frame_layout.py')
+        return
+    with open(args.output, 'w') as f:
+        f.write(text)
+    print(f'Wrote {args.output}')
+
+
+if __name__ == '__main__':
+    main()
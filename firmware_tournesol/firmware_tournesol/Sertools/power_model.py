@@ -0,0 +1,132 @@
+"""Estimates the MCU current of each power phase of the firmware (power.h).
+
+The peripherals gated in each phase are read from the power_phase_prr table of
+power.cpp, so the estimates follow the firmware. The active current of config.h
+(ENERGY_CURRENT_CPU_UA) is taken as the current with every peripheral clocked,
+the share of each peripheral is the typical one of the ATmega328P datasheet
+(supply current of the I/O modules). The figures are estimates until bench
+measurements replace them.
+
+The sleep current is split the same way : in power down every clock is already
+stopped, what the phase changes is the TWI pull-ups, which were left on and
+leak into the rails of the powered off sensors.
+
+Usage :
+    python power_model.py
+    python power_model.py --wake sensors=1500,sd=40,serial=5
+"""
+import argparse
+import os
+import re
+
+from settings_generator import load_defines
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..')
+DEFAULT_POWER_H = os.path.join(ROOT, 'ArduinoCore', 'include', 'power.h')
+DEFAULT_POWER_CPP = os.path.join(ROOT, 'ArduinoCore', 'src', 'power.cpp')
+DEFAULT_CONFIG = os.path.join(ROOT, 'ArduinoCore', 'include', 'config.h')
+
+# Share of the active current drawn by each clocked peripheral, in %.
+PERIPHERALS = {
+    'PRTWI': 12.8,
+    'PRTIM2': 8.8,
+    'PRTIM0': 1.6,
+    'PRTIM1': 6.1,
+    'PRSPI': 7.5,
+    'PRUSART0': 3.3,
+    'PRADC': 14.5,
+}
+
+# Sleep current of the MCU core in power down, WDT and BOD off, in uA.
+SLEEP_CORE_UA = 0.2
+# Internal pull-up (20 to 50 kOhm) held low by an unpowered sensor, worst case, in uA.
+TWI_PULLUP_UA = 5.0 / 35e3 * 1e6
+TWI_PINS = 2
+
+
+def load_phases(power_h=DEFAULT_POWER_H):
+    """Returns the phase names of power_phase_t, in order."""
+    with open(power_h, 'r') as f:
+        text = f.read()
+    body = re.search(r'typedef enum \{([^}]*)\} power_phase_t;', text).group(1)
+    names = re.findall(r'POWER_PHASE_(\w+)', body)
+    return [name.lower() for name in names if name != 'COUNT']
+
+
+def load_gated(power_cpp=DEFAULT_POWER_CPP):
+    """Returns the set of PRR bits gated in each phase, in power_phase_t order."""
+    with open(power_cpp, 'r') as f:
+        text = f.read()
+    # Comments would hide entries, the macros are expanded by hand.
+    text = re.sub(r'/\*.*?\*/|//[^\n]*', '', text, flags=re.S)
+    macros = dict(re.findall(r'#define\s+(\w+)\s+\(((?:[^()\n]|\([^()]*\)|\\\n)*)\)', text))
+    body = re.search(r'power_phase_prr\[\w+\]\s*=\s*\{(.*?)\};', text, re.S).group(1)
+
+    def bits(expr):
+        found = set(re.findall(r'bit\((\w+)\)', expr))
+        for name, value in macros.items():
+            if re.search(r'\b' + name + r'\b', expr):
+                found |= bits(value)
+        return found
+
+    return [bits(entry) for entry in body.split(',')]
+
+
+def active_current_ua(gated, all_on_ua):
+    """Active current with the gated peripherals off, all_on_ua with all of them on."""
+    core = all_on_ua / (1 + sum(PERIPHERALS.values()) / 100)
+    return core * (1 + sum(share for name, share in PERIPHERALS.items() if name not in gated) / 100)
+
+
+def sleep_current_ua(twi_pullups):
+    return SLEEP_CORE_UA + (TWI_PINS * TWI_PULLUP_UA if twi_pullups else 0)
+
+
+def parse_wake(text):
+    wake = {}
+    for item in filter(None, text.split(',')):
+        name, ms = item.split('=')
+        wake[name] = float(ms)
+    return wake
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Estimate the MCU current of each power phase.')
+    parser.add_argument('--config', default=DEFAULT_CONFIG)
+    parser.add_argument('--wake', type=parse_wake, default={},
+                        help='time spent in each awake phase, name=ms, to estimate the charge of a wake')
+    args = parser.parse_args()
+
+    defines = load_defines(args.config)
+    all_on_ua = defines['ENERGY_CURRENT_CPU_UA']
+    phases = load_phases()
+    gated = load_gated()
+    if len(phases) != len(gated):
+        raise SystemExit('power_phase_prr doesn\'t match power_phase_t')
+
+    print(f'{"phase":<10}{"clocked":<40}{"current [uA]":>14}')
+    currents = {}
+    for name, off in zip(phases, gated):
+        clocked = [p[2:] for p in PERIPHERALS if p not in off]
+        if name == 'sleep':
+            currents[name] = sleep_current_ua(twi_pullups=False)
+        else:
+            currents[name] = active_current_ua(off, all_on_ua)
+        print(f'{name:<10}{",".join(clocked) or "-":<40}{currents[name]:>14.1f}')
+    print(f'{"all on":<10}{"":<40}{all_on_ua:>14.1f}')
+
+    before = sleep_current_ua(twi_pullups=True)
+    station = defines['ENERGY_CURRENT_SLEEP_UA']
+    print()
+    print(f'MCU sleep current        : {currents["sleep"]:.1f} uA (was up to {before:.1f} uA with the TWI pull-ups)')
+    print(f'Station sleep current    : {station - (before - currents["sleep"]):.1f} to {station} uA '
+          f'(ENERGY_CURRENT_SLEEP_UA, less the pull-ups leak if there was one)')
+
+    if args.wake:
+        charge = sum(currents[name] * ms / 1000 for name, ms in args.wake.items())
+        charge_all_on = sum(all_on_ua * ms / 1000 for ms in args.wake.values())
+        print(f'Wake charge              : {charge:.0f} uC (all on : {charge_all_on:.0f} uC)')
+
+
+if __name__ == '__main__':
+    main()
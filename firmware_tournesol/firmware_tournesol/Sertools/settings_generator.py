@@ -0,0 +1,228 @@
+"""Generates the settings block loaded by the firmware at boot (settings.h).
+
+The calibration is computed from the captures of the tests directory :
+    rtd_calib.txt          : stabilized raw counts at known temperatures
+    Anemometre_calib.txt   : raw counts at rest and at a counted rotation speed
+    Spectro_calib_*.txt    : dark, candle without and with the diffuser
+
+The station config (alarms, sampling periods, enabled sensors and their own
+periods) defaults to the values of config.h.
+Copy the output file at the root of the SD card under SETTINGS_FILE_NAME.
+
+Usage :
+    python settings_generator.py -o config.bin
+    python settings_generator.py -o config.bin --sensors hdc1080,pt100 --period 900
+    python settings_generator.py -o config.bin --module pt100=3600:300 --module as7262=600
+    python settings_generator.py -o config.bin --period 0 --alarm1 0xC,0,0,0
+    python settings_generator.py --dump config.bin
+"""
+import argparse
+import binascii
+import os
+import re
+import struct
+
+SETTINGS_TAG = 0xC5
+SETTINGS_VERSION = 3
+SETTINGS_FORMAT = '<BBBBBBBBBBBHH4H4H6f6f4fH'
+SETTINGS_BYTES = struct.calcsize(SETTINGS_FORMAT)
+
+# Same order as SENSOR_REGISTRY in config.h (MODULE_* bits)
+SENSORS = ['as7262', 'hdc1080', 'pt100', 'anemometer']
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..')
+DEFAULT_CONFIG = os.path.join(ROOT, 'ArduinoCore', 'include', 'config.h')
+DEFAULT_TESTS = os.path.join(ROOT, 'tests')
+
+NUMBER = r'[-+]?\d+(?:\.\d+)?'
+
+
+def load_defines(header=DEFAULT_CONFIG):
+    """Returns the integer #define of a header."""
+    with open(header, 'r') as f:
+        text = f.read()
+    return {name: int(value, 0) for name, value in re.findall(r'#define\s+(\w+)\s+\((0x[0-9a-fA-F]+|\d+)\)', text)}
+
+
+def mean(values):
+    return sum(values) / len(values)
+
+
+def fit_line(points):
+    """Least squares fit of y = a * x + b, returns (a, b)."""
+    xs, ys = zip(*points)
+    mx, my = mean(xs), mean(ys)
+    a = sum((x - mx) * (y - my) for x, y in points) / sum((x - mx) ** 2 for x in xs)
+    return a, my - a * mx
+
+
+def rtd_calibration(path):
+    """Returns (PT100_C1, PT100_C2) : T = C1 * (raw - C2)."""
+    points = []
+    temperature = None
+    with open(path, 'r') as f:
+        for line in f.read().replace('raw count', 'raw count\n').splitlines():
+            m = re.match(r'test a (' + NUMBER + r') degC', line)
+            if m:
+                temperature = float(m.group(1))
+                continue
+            m = re.match(r'Temp\(PT100\) stabilized : (' + NUMBER + ')', line)
+            if m and temperature is not None:
+                points.append((float(m.group(1)), temperature))
+                temperature = None
+    a, b = fit_line(points)
+    return a, -b / a
+
+
+def anemometer_calibration(path):
+    """Returns (ANEMO_C1, ANEMO_C2) : speed = C1 * raw - C2.
+
+    The captures hold several sessions (split on init_setup), the last
+    complete one is used since the offset drifts between sessions.
+    """
+    with open(path, 'r') as f:
+        text = f.read()
+    circumference = float(re.search(r'circonference.*=\s*(' + NUMBER + r')m', text).group(1))
+
+    calibration = None
+    for session in text.split('init_setup')[1:]:
+        rest = re.search(r'0 m/s(.*?)constant speed', session, re.S)
+        moving = re.search(r'constant speed(.*?)(\d+) tours en (\d+) secondes', session, re.S)
+        if not rest or not moving:
+            continue
+        raw0 = mean([float(v) for v in re.findall(r'raw data : (' + NUMBER + ')', rest.group(1))])
+        raw1 = mean([float(v) for v in re.findall(r'raw data : (' + NUMBER + ')', moving.group(1))])
+        speed = int(moving.group(2)) / int(moving.group(3)) * circumference
+        c1 = speed / (raw1 - raw0)
+        calibration = (c1, c1 * raw0)
+    return calibration
+
+
+def spectro_calibration(path):
+    """Returns (dark offsets, diffuser multipliers) of the 6 channels.
+
+    Same rule as the constants of Adafruit_AS726x.h : the offset is the dark
+    measurement, the multiplier is the candle measurement without the
+    diffuser minus the one with it.
+    """
+    sections = {}
+    name = None
+    with open(path, 'r') as f:
+        for line in f:
+            if line.startswith('Prepare for'):
+                name = line.lower()
+                sections[name] = []
+                continue
+            m = re.match(r'CH (\d) : (' + NUMBER + ')', line)
+            if m and name is not None:
+                sections[name].append(float(m.group(2)))
+
+    def find(word, exclude=None):
+        return next(v for k, v in sections.items() if word in k and (exclude is None or exclude not in k))
+
+    dark = find('dark')
+    without = find('without diffuser')
+    with_diffuser = find('with diffuser', exclude='without')
+    return dark, [a - b for a, b in zip(without, with_diffuser)]
+
+
+def pack_settings(sensors, alarm1, alarm2, periods, module_periods, module_phases, dark, multiplier, pt100, anemo):
+    body = struct.pack(SETTINGS_FORMAT[:-1], SETTINGS_TAG, SETTINGS_VERSION, SETTINGS_BYTES, sensors,
+                       *alarm1, *alarm2, *periods, *module_periods, *module_phases,
+                       *dark, *multiplier, *pt100, *anemo)
+    return body + struct.pack('<H', binascii.crc_hqx(body, 0))
+
+
+def unpack_settings(data: bytes):
+    """Returns the fields of a settings block, or None if it is corrupted."""
+    if len(data) < SETTINGS_BYTES:
+        return None
+    fields = struct.unpack_from(SETTINGS_FORMAT, data)
+    if fields[0] != SETTINGS_TAG or fields[1] != SETTINGS_VERSION or fields[2] != SETTINGS_BYTES:
+        return None
+    if binascii.crc_hqx(data[:SETTINGS_BYTES - 2], 0) != fields[-1]:
+        return None
+    return {
+        'sensors': [name for i, name in enumerate(SENSORS) if fields[3] & (1 << i)],
+        'alarm1 (mask, sec, min, hour)': fields[4:8],
+        'alarm2 (mask, min, hour)': fields[8:11],
+        'period (min, max) [s]': fields[11:13],
+        'module (period, phase) [s]': dict(zip(SENSORS, zip(fields[13:17], fields[17:21]))),
+        'as7262 dark offset': fields[21:27],
+        'as7262 diffuser multiplier': fields[27:33],
+        'pt100 (c1, c2)': fields[33:35],
+        'anemometer (c1, c2)': fields[35:37],
+    }
+
+
+def int_list(text):
+    return [int(v, 0) for v in text.split(',')]
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate the settings block of a station.')
+    parser.add_argument('-o', '--output', default='config.bin')
+    parser.add_argument('--dump', help='decode an existing settings block instead')
+    parser.add_argument('--tests', default=DEFAULT_TESTS, help='directory holding the *_calib.txt captures')
+    parser.add_argument('--spectro', default='Spectro_calib_chandelle.txt')
+    parser.add_argument('--config', default=DEFAULT_CONFIG, help='config.h holding the default station config')
+    parser.add_argument('--sensors', default=','.join(SENSORS), help='enabled sensors, among ' + ','.join(SENSORS))
+    parser.add_argument('--alarm1', type=int_list, help='mask,sec,min,hour')
+    parser.add_argument('--alarm2', type=int_list, help='mask,min,hour')
+    parser.add_argument('--period', type=int, help='sampling period in s, 0 to use the alarms')
+    parser.add_argument('--period-max', type=int, help='longest adaptive sampling period in s')
+    parser.add_argument('--module', action='append', default=[],
+                        help='period of a sensor, name=period[:phase] in s, 0 for every wake')
+    args = parser.parse_args()
+
+    if args.dump:
+        with open(args.dump, 'rb') as f:
+            settings = unpack_settings(f.read())
+        if settings is None:
+            raise SystemExit('Invalid settings block')
+        for key, value in settings.items():
+            print(f'{key:<28}: {value}')
+        return
+
+    defines = load_defines(args.config)
+    alarm1 = args.alarm1 or [defines['DS3231_ALARM1_' + k] for k in ('MASK', 'SEC', 'MIN', 'HOUR')]
+    alarm2 = args.alarm2 or [defines['DS3231_ALARM2_' + k] for k in ('MASK', 'MIN', 'HOUR')]
+    if len(alarm1) != 4 or len(alarm2) != 3:
+        raise SystemExit('--alarm1 takes 4 values and --alarm2 takes 3')
+    period = defines['SAMPLING_PERIOD_S'] if args.period is None else args.period
+    period_max = defines['SAMPLING_PERIOD_MAX_S'] if args.period_max is None else args.period_max
+    if not 0 <= period <= 0xFFFF or not 0 <= period_max <= 0xFFFF:
+        raise SystemExit('The periods range from 0 to 65535 s')
+
+    module_periods = [defines[f'{name.upper()}_PERIOD_S'] for name in SENSORS]
+    module_phases = [defines[f'{name.upper()}_PHASE_S'] for name in SENSORS]
+    for option in args.module:
+        m = re.fullmatch(r'(\w+)=(\d+)(?::(\d+))?', option)
+        if not m or m.group(1) not in SENSORS:
+            raise SystemExit(f'Invalid --module {option}')
+        module_periods[SENSORS.index(m.group(1))] = int(m.group(2))
+        module_phases[SENSORS.index(m.group(1))] = int(m.group(3) or 0)
+    if not all(0 <= v <= 0xFFFF for v in module_periods + module_phases):
+        raise SystemExit('The module periods and phases range from 0 to 65535 s')
+
+    sensors = 0
+    for name in filter(None, args.sensors.split(',')):
+        if name not in SENSORS:
+            raise SystemExit(f'Unknown sensor {name}')
+        sensors |= 1 << SENSORS.index(name)
+
+    dark, multiplier = spectro_calibration(os.path.join(args.tests, args.spectro))
+    pt100 = rtd_calibration(os.path.join(args.tests, 'rtd_calib.txt'))
+    anemo = anemometer_calibration(os.path.join(args.tests, 'Anemometre_calib.txt'))
+
+    data = pack_settings(sensors, alarm1, alarm2, (period, period_max), module_periods, module_phases,
+                         dark, multiplier, pt100, anemo)
+    with open(args.output, 'wb') as f:
+        f.write(data)
+
+    for key, value in unpack_settings(data).items():
+        print(f'{key:<28}: {value}')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,173 @@
+"""Charts a soak run of the host simulator (sim/, tournesol_sim --soak).
+
+The simulator writes one line per wake : virtual awake time, host CPU time of
+the wake, SD operations, longest SD busy period, merges and wear, and stack
+depth. The wakes are grouped by day, the mean and the maximum of each day are
+charted (SVG, no plotting package needed) and the first and last tenths of the
+run are compared : a cost that grows with the
+age of the station (a file re-opened and seeked to its end at every wake, a
+calendar computed from 2000, a counter about to wrap) shows as a growth well
+above 1.
+
+The host time follows the load of the machine and the wear of the card only
+grows, their growth is only reported.
+
+Usage :
+    python soak_report.py soak.csv
+    python soak_report.py soak.csv --svg soak.svg --limit 1.2
+"""
+import argparse
+import csv
+import datetime
+import os
+import sys
+
+# (column, unit, scale, checked) of the charted metrics
+METRICS = [
+    ('wakes', 'per day', 1, True),
+    ('awake_us', 'ms', 1e-3, True),
+    ('host_us', 'us', 1, False),
+    ('sd_commands', '', 1, True),
+    ('sd_read', 'blocks', 1, True),
+    ('sd_written', 'blocks', 1, True),
+    ('sd_erases', '', 1, True),
+    ('sd_busy_us', 'ms', 1e-3, True),
+    ('sd_peak_us', 'ms', 1e-3, True),
+    ('sd_merges', '', 1, True),
+    ('sd_wear_max', 'erases', 1, False),
+    ('stack_bytes', 'B (host)', 1, True),
+]
+
+DAY_S = 86400
+PANEL_W = 900
+PANEL_H = 120
+MARGIN_L = 170
+MARGIN_R = 20
+MARGIN_V = 18
+
+
+def load_wakes(path):
+    """Returns the wakes of the CSV as dicts of ints."""
+    with open(path, 'r', newline='') as f:
+        return [{k: int(v) for k, v in row.items()} for row in csv.DictReader(f)]
+
+
+def group_days(wakes):
+    """Returns [(day start, {metric: (mean, max)})], in order."""
+    days = {}
+    for wake in wakes:
+        days.setdefault(wake['rtc'] // DAY_S * DAY_S, []).append(wake)
+    grouped = []
+    for start in sorted(days):
+        rows = days[start]
+        stats = {'wakes': (len(rows), len(rows))}
+        for name, _, scale, _ in METRICS[1:]:
+            values = [row[name] * scale for row in rows]
+            stats[name] = (sum(values) / len(values), max(values))
+        grouped.append((start, stats))
+    return grouped
+
+
+def trend(grouped, name):
+    """Returns the daily means of the first and the last tenth of the days."""
+    # The first and last days are partial, they are left out when there are enough.
+    inner = grouped[1:-1] if len(grouped) > 2 else grouped
+    tenth = max(1, len(inner) // 10)
+    first = sum(stats[name][0] for _, stats in inner[:tenth]) / tenth
+    last = sum(stats[name][0] for _, stats in inner[-tenth:]) / tenth
+    return first, last
+
+
+def growth(first, last):
+    if first == 0:
+        return 1.0 if last == 0 else float('inf')
+    return last / first
+
+
+def _polyline(points, color, width):
+    coords = ' '.join(f'{x:.1f},{y:.1f}' for x, y in points)
+    return f'<polyline fill="none" stroke="{color}" stroke-width="{width}" points="{coords}"/>'
+
+
+def write_svg(path, grouped):
+    """One panel per metric, daily mean in blue and maximum in grey."""
+    height = len(METRICS) * (PANEL_H + 2 * MARGIN_V)
+    days = len(grouped)
+    span = max(days - 1, 1)
+    plot_w = PANEL_W - MARGIN_L - MARGIN_R
+    out = [f'<svg xmlns="http://www.w3.org/2000/svg" width="{PANEL_W}" height="{height}" '
+           f'font-family="sans-serif" font-size="11">',
+           f'<rect width="{PANEL_W}" height="{height}" fill="white"/>']
+
+    for i, (name, unit, _, _) in enumerate(METRICS):
+        top = i * (PANEL_H + 2 * MARGIN_V) + MARGIN_V
+        low = min(stats[name][0] for _, stats in grouped)
+        high = max(stats[name][1] for _, stats in grouped)
+        if high == low:
+            high = low + 1
+
+        def xy(day, value):
+            return (MARGIN_L + plot_w * day / span,
+                    top + PANEL_H - PANEL_H * (value - low) / (high - low))
+
+        out.append(f'<rect x="{MARGIN_L}" y="{top}" width="{plot_w}" height="{PANEL_H}" '
+                   f'fill="none" stroke="#ccc"/>')
+        out.append(f'<text x="8" y="{top + 14}" font-weight="bold">{name}</text>')
+        out.append(f'<text x="8" y="{top + 30}">{unit}</text>')
+        out.append(f'<text x="{MARGIN_L - 6}" y="{top + 10}" text-anchor="end">{high:.6g}</text>')
+        out.append(f'<text x="{MARGIN_L - 6}" y="{top + PANEL_H}" text-anchor="end">{low:.6g}</text>')
+        out.append(_polyline([xy(d, stats[name][1]) for d, (_, stats) in enumerate(grouped)], '#aaa', 1))
+        out.append(_polyline([xy(d, stats[name][0]) for d, (_, stats) in enumerate(grouped)], '#1f5fbf', 1.5))
+
+        # Month ticks under the panel
+        for d, (start, _) in enumerate(grouped):
+            date = datetime.datetime.fromtimestamp(start, datetime.timezone.utc)
+            if date.day == 1 or d == 0:
+                x, _ = xy(d, low)
+                out.append(f'<text x="{x:.1f}" y="{top + PANEL_H + 13}" text-anchor="middle" '
+                           f'fill="#666">{date:%Y-%m}</text>')
+
+    out.append('</svg>')
+    with open(path, 'w') as f:
+        f.write('\n'.join(out) + '\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Chart a soak run of the simulator.')
+    parser.add_argument('csv', help='soak file of tournesol_sim --soak')
+    parser.add_argument('--svg', help='chart, next to the CSV by default')
+    parser.add_argument('--limit', type=float, default=1.25,
+                        help='growth of a checked metric reported as a failure')
+    args = parser.parse_args()
+
+    wakes = load_wakes(args.csv)
+    if not wakes:
+        raise SystemExit(f'{args.csv}: no wake recorded')
+    grouped = group_days(wakes)
+    svg = args.svg or os.path.splitext(args.csv)[0] + '.svg'
+    write_svg(svg, grouped)
+
+    first = datetime.datetime.fromtimestamp(wakes[0]['rtc'], datetime.timezone.utc)
+    last = datetime.datetime.fromtimestamp(wakes[-1]['rtc'], datetime.timezone.utc)
+    print(f'{len(wakes)} wakes, {first:%Y-%m-%d} to {last:%Y-%m-%d}, {len(grouped)} days, chart in {svg}')
+    print()
+    print(f'{"metric":<14}{"unit":<10}{"first":>12}{"last":>12}{"max":>12}{"growth":>9}')
+    failed = []
+    for name, unit, _, checked in METRICS:
+        first_mean, last_mean = trend(grouped, name)
+        g = growth(first_mean, last_mean)
+        peak = max(stats[name][1] for _, stats in grouped)
+        mark = ''
+        if checked and g > args.limit:
+            mark = '  <- grows'
+            failed.append(name)
+        print(f'{name:<14}{unit:<10}{first_mean:>12.6g}{last_mean:>12.6g}{peak:>12.6g}{g:>9.2f}{mark}')
+
+    if failed:
+        print()
+        print(f'grows over the run : {", ".join(failed)}')
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,137 @@
+"""Reports the static SRAM use of the firmware per symbol, from the linker map.
+
+The map is written by the linker next to main.elf (main/Debug/main.map). The
+input sections of .data (the strings and constant tables left in .rodata are
+copied there too), .bss and .noinit are listed by size, with the object they
+come from. What is left of the 2 KB is shared by the heap and the stack : the
+stack high water reported by the station (sram.h, health records from version
+2) gives the headroom left.
+
+Usage :
+    python sram_map.py
+    python sram_map.py --top 20 --stack 612
+    python sram_map.py ../main/Release/main.map
+"""
+import argparse
+import os
+import re
+import shutil
+import subprocess
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..')
+DEFAULT_MAP = os.path.join(ROOT, 'main', 'Debug', 'main.map')
+
+# ATmega328P data memory : the registers and I/O space end at 0x100.
+SRAM_START = 0x800100
+SRAM_BYTES = 2048
+SRAM_OUTPUTS = ('.data', '.bss', '.noinit')
+
+OUTPUT_RE = re.compile(r'^(\.\w+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)')
+INPUT_RE = re.compile(r'^ (\.(?:data|rodata|bss|noinit)\S*|COMMON)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.*))?$')
+PLACE_RE = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.*)$')
+SYMBOL_RE = re.compile(r'^\s+0x[0-9a-fA-F]+\s+([A-Za-z_.$][\w.$]*)\s*$')
+OBJECT_RE = re.compile(r'([^\\/()]+)\)?$')
+
+
+def object_name(path):
+    """Shortens the path of an object, libArduinoCore.a(modules.o) -> modules.o."""
+    match = OBJECT_RE.search(path.strip())
+    return match.group(1) if match else path.strip()
+
+
+def parse_map(path):
+    """Returns the SRAM output sections of a map, {name: (address, size)}, and
+    their input sections, [output, symbol, object, address, size]. A section
+    without a symbol in its name (.data, COMMON) is named after the symbols the
+    map lists under it."""
+    outputs = {}
+    inputs = []
+    output = None
+    pending = None
+    with open(path, errors='replace') as f:
+        for line in f:
+            line = line.rstrip('\n')
+            match = OUTPUT_RE.match(line)
+            if match:
+                name, addr, size = match.group(1), int(match.group(2), 16), int(match.group(3), 16)
+                output = name if name in SRAM_OUTPUTS and addr >= SRAM_START else None
+                if output:
+                    outputs[output] = (addr, size)
+                continue
+            if output is None:
+                continue
+            match = INPUT_RE.match(line)
+            if match:
+                pending = match.group(1)
+                if match.group(2) is None:
+                    # The name is too long, the placement is on the next line.
+                    continue
+                place = match.group(2), match.group(3), match.group(4)
+            elif pending is not None and PLACE_RE.match(line):
+                place = PLACE_RE.match(line).groups()
+            else:
+                match = SYMBOL_RE.match(line)
+                if match and inputs and inputs[-1][1] is None:
+                    inputs[-1][1] = match.group(1)
+                continue
+            addr, size = int(place[0], 16), int(place[1], 16)
+            section, pending = pending, None
+            if size == 0:
+                continue
+            if section.startswith('.rodata.str'):
+                symbol = '(string literals)'
+            else:
+                symbol = section.split('.', 2)[2] if section.count('.') >= 2 else None
+            inputs.append([output, symbol, object_name(place[2]), addr, size])
+    for item in inputs:
+        if item[1] is None:
+            item[1] = '(' + item[2] + ')'
+    return outputs, inputs
+
+
+def demangle(names):
+    """Demangles the C++ names with c++filt when it is installed."""
+    tool = shutil.which('avr-c++filt') or shutil.which('c++filt')
+    if tool is None:
+        return names
+    result = subprocess.run([tool], input='\n'.join(names), capture_output=True, text=True)
+    demangled = result.stdout.splitlines()
+    return demangled if len(demangled) == len(names) else names
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Report the static SRAM use per symbol.')
+    parser.add_argument('map', nargs='?', default=DEFAULT_MAP, help='linker map (main.map)')
+    parser.add_argument('--top', type=int, default=0, help='largest symbols listed, 0 for all')
+    parser.add_argument('--stack', type=int, help='stack high water measured on the station, in bytes')
+    args = parser.parse_args()
+
+    outputs, inputs = parse_map(args.map)
+    if not outputs:
+        raise SystemExit('No SRAM section in ' + args.map)
+
+    inputs.sort(key=lambda item: item[4], reverse=True)
+    shown = inputs[:args.top] if args.top > 0 else inputs
+    names = demangle([item[1] for item in shown])
+
+    print(f'{"Size":>6}  {"Section":<8} {"Object":<24} Symbol')
+    for (output, _, obj, _, size), name in zip(shown, names):
+        print(f'{size:6d}  {output:<8} {obj:<24} {name}')
+    if len(shown) < len(inputs):
+        print(f'{sum(item[4] for item in inputs[len(shown):]):6d}  ({len(inputs) - len(shown)} more)')
+
+    print()
+    static = 0
+    for output in SRAM_OUTPUTS:
+        _, size = outputs.get(output, (0, 0))
+        static += size
+        print(f'{output:<8} {size:6d} B')
+    free = SRAM_BYTES - static
+    print(f'{"static":<8} {static:6d} B ({100 * static / SRAM_BYTES:.1f} %)')
+    print(f'{"free":<8} {free:6d} B for the heap and the stack')
+    if args.stack is not None:
+        print(f'{"headroom":<8} {free - args.stack:6d} B with a {args.stack} B stack')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,105 @@
+"""Decodes the execution trace records written by the firmware tracer (trace.h).
+
+A record is : magic 'TR', entry count, then `count` entries of
+(event id : uint8, ticks : uint16 little endian), oldest entry first, then the
+16 bits sum of the count and entry bytes, little endian. A record is only
+accepted if its sum matches : an entry or a frame of serial output can hold
+the magic, the scan then resumes at the next byte.
+
+Usage :
+    python trace_decoder.py TRACE.BIN
+    python trace_decoder.py --port COM4
+"""
+import argparse
+import os
+import re
+import struct
+
+TRACE_RECORD_MAGIC = b'TR'
+TRACE_ENTRY_BYTES = 3
+TRACE_BUFFER_MAX = 128  # TRACE_BUFFER_LEN bound of trace.h
+TRACE_SUM_BYTES = 2
+TICKS_WRAP = 1 << 16
+
+DEFAULT_HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'ArduinoCore', 'include', 'trace.h')
+
+
+def load_event_names(header=DEFAULT_HEADER):
+    """Builds the event id -> name table from the enum of trace.h."""
+    with open(header, 'r') as f:
+        text = f.read()
+    return {int(value): name for name, value in re.findall(r'TRACE_EV_(\w+)\s*=\s*(\d+)', text)}
+
+
+def parse_records(data: bytes):
+    """Yields every trace record found in data as a list of (event id, ticks)."""
+    for record, _ in scan_records(data):
+        yield record
+
+
+def scan_records(data: bytes):
+    """Same as parse_records, but also yields the offset following each record."""
+    header = len(TRACE_RECORD_MAGIC) + 1
+    i = data.find(TRACE_RECORD_MAGIC)
+    while 0 <= i and i + header <= len(data):
+        count = data[i + header - 1]
+        body = i + header
+        end = body + count * TRACE_ENTRY_BYTES + TRACE_SUM_BYTES
+        # A false magic may announce more bytes than left : the next one is
+        # tried. The offset only moves past accepted records, a record still
+        # being received on the serial port is scanned again with its end.
+        if count > TRACE_BUFFER_MAX or end > len(data) or \
+                (count + sum(data[body:end - TRACE_SUM_BYTES])) & 0xFFFF != \
+                struct.unpack_from('<H', data, end - TRACE_SUM_BYTES)[0]:
+            i = data.find(TRACE_RECORD_MAGIC, i + 1)
+            continue
+        yield [struct.unpack_from('<BH', data, body + n * TRACE_ENTRY_BYTES) for n in range(count)], end
+        i = data.find(TRACE_RECORD_MAGIC, end)
+
+
+def format_record(record, names):
+    lines = []
+    previous = None
+    for event, ticks in record:
+        delta = 0 if previous is None else (ticks - previous) % TICKS_WRAP
+        previous = ticks
+        lines.append(f'{ticks:>6} ms  +{delta:<6} {names.get(event, f"UNKNOWN_{event}")}')
+    return '\n'.join(lines)
+
+
+def read_serial(port, baudrate):
+    import serial
+
+    s = serial.Serial(port, baudrate=baudrate, bytesize=8, stopbits=serial.STOPBITS_ONE)
+    buffer = b''
+    while 1:
+        buffer += s.read(s.in_waiting or 1)
+        consumed = 0
+        for record, consumed in scan_records(buffer):
+            yield record
+        buffer = buffer[consumed:]
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode firmware execution traces.')
+    parser.add_argument('file', nargs='?', help='trace file copied from the SD card')
+    parser.add_argument('--port', help='serial port to read live dumps from')
+    parser.add_argument('--baudrate', type=int, default=9600)
+    parser.add_argument('--header', default=DEFAULT_HEADER, help='trace.h holding the event ids')
+    args = parser.parse_args()
+
+    names = load_event_names(args.header)
+
+    if args.port:
+        records = read_serial(args.port, args.baudrate)
+    else:
+        with open(args.file, 'rb') as f:
+            records = parse_records(f.read())
+
+    for n, record in enumerate(records):
+        print(f'--- record {n} ({len(record)} events)')
+        print(format_record(record, names))
+
+
+if __name__ == '__main__':
+    main()
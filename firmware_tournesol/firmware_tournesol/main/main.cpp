@@ -17,12 +17,20 @@
 #include "sleep.h"
 #include "status.h"
 #include "memory.h"
+#include "telemetry.h"
+#include "energy.h"
+#include "health.h"
+#include "diag.h"
+#include "settings.h"
+#include "power.h"
+#include "clock.h"
+#include "bus.h"
+#include "watchdog.h"
+#include "sram.h"
 
 #include "modules.h"
 #include "common.h"
 
-#define CHECKSUM_BYTES	(2)
-
 
 int main();
 
@@ -33,21 +41,6 @@ int main();
  */
 int init_setup(void);
 
-/** @brief Initialization, activation and deactivation of a relay.
- *
- */
-void init_relay();
-void activate_relay();
-void deactivate_relay();
-
-/** @brief Initialisation, activation and deactivation of the supply to 
- *	   the measurement devices.
- *
- */
-void init_instruments();
-void activate_instruments();
-void deactivate_instruments();
-
 /** @brief This function calculates the checksum of a byte array
  *
  *
@@ -68,55 +61,174 @@ int main(){
 		signal_error(err);
 	}
 
-	// Buffer to be saved on SD
-	uint8_t data[TOTAL_MEAS_BYTES + CHECKSUM_BYTES] = {0};
+	// Frame being built, in the SD block cache (memory.h)
+	uint8_t* data = NULL;
+
+	static_assert(HEALTH_RECORD_BYTES + CHECKSUM_BYTES <= sizeof(frame_t), "Health record doesn't fit the frame buffer");
+	static_assert(DIAG_RECORD_BYTES + CHECKSUM_BYTES <= sizeof(frame_t), "Diagnostics record doesn't fit the frame buffer");
+	static_assert(FRAME_MAX_BYTES <= 0xFF, "Frame length doesn't fit its length field");
 
 	// Index of data in buffer
 	uint8_t ix = 0;
 
 	uint16_t crc = 0;
 	data_uint64_bytes dt;
+	uint32_t now = 0;		// Time of the last wake the RTC was read
+	uint8_t due = 0;
+	uint8_t flags = 0;
 
 	// Program loop
 	while(true){
-		PRINTFUNCT;
+		TRACE(TRACE_EV_MAIN_LOOP);
 		if (wake_flag){
 			wake_flag = 0;
 			err = 0;
 
-			activate_instruments();
-			delay(1000);
-			
-			if((err = init_modules()) != ERROR_OK){
-				signal_error(err);
-			}
-		
-			
+			// A wake that hangs resets the station.
+			watchdog_begin_wake();
+
+			energy_begin_wake();
+
 			dt.value = DS3231_get_datetime();
+			if (dt.value == 0){
+				bus_recover();
+				dt.value = DS3231_get_datetime();
+			}
 
-			for (int i = sizeof(uint64_t) - 1; i >= 0; i--){
-				data[ix++] = dt.bytes[i];
+			if (dt.value != 0){
+				now = (uint32_t)dt.value;
+				// Only the modules due at this wake are powered and read.
+				due = modules_due(now, &flags);
+			} else {
+				// Nothing is scheduled from epoch 0 : every enabled module
+				// is read, the frame is flagged and the accounting keeps
+				// the time of the last wake.
+				diag_rtc_failed();
+				due = settings.sensors;
+				flags = FRAME_FLAG_NO_TIME;
 			}
 
-			// Relay for the anemometer + delay for its activation time.
-			activate_relay();
-			delay(1000);
+			if (due || flags){
+				power_phase(POWER_PHASE_SD);
+				frame_t& frame = memory_frame_begin();
+				power_phase(POWER_PHASE_SENSORS);
+				data = frame;
+
+				data[ix++] = FRAME_TAG;
+				data[ix++] = FRAME_VERSION;
+				ix++;	// Length, set below
+				data[ix++] = due;
+				data[ix++] = flags;
+
+				for (int i = sizeof(uint64_t) - 1; i >= 0; i--){
+					data[ix++] = dt.bytes[i];
+				}
+
+				// Powers and reads the modules data, each rail (the relay
+				// included) is switched off as soon as its module is read.
+				ix += exec_modules(frame, &due, &err);
+
+				// A failed module is saved as missing, the station keeps sampling.
+				if (err != ERROR_OK){
+					flags |= FRAME_FLAG_MISSING;
+				}
+				data[3] = due;
+				data[4] = flags;
+			}
+
+			// Last access to the RTC and the sensors of this wake
+			rtc_schedule_next((uint32_t)dt.value, due ? data + FRAME_MEAS_OFFSET : NULL, due);
+
+			watchdog_kick();
+			power_phase(POWER_PHASE_SD);
 
-			// Reads all the modules data
-			ix += exec_modules(data + ix);
+			if (ix != 0){
+				data[2] = ix + CHECKSUM_BYTES;
 
-			// Deactivating the relay asap because its the main power consumption element.
-			deactivate_relay();
-			deactivate_instruments();
+				crc = checksum(data, ix);
 
-			crc = checksum(data, ix);
+				data[ix++] = (uint8_t)((crc & 0xFF00) >> 8);
+				data[ix++] = (uint8_t)(crc & 0x00FF);
 
-			data[ix++] = (uint8_t)((crc & 0xFF00) >> 8);
-			data[ix++] = (uint8_t)(crc & 0x00FF);
+				memory_frame_end(ix);
 
-			save_frame(SAVE_FILE_NAME, data, ix);
+#if TELEMETRY_EN
+				power_phase(POWER_PHASE_SERIAL);
+				telemetry_send_frame(data, ix);
+				power_phase(POWER_PHASE_SD);
+#endif
+			}
+
+#if DEBUG_TRACE_SERIAL
+			trace_dump();
+#endif
+#if TRACE_SAVE_EN
+			// Only the trace of a wake with a failed module is kept.
+			if (err != ERROR_OK){
+				trace_save(TRACE_FILE_NAME);
+			} else {
+				trace_clear();
+			}
+#endif
 
 			ix = 0;
+
+			if (health_update(now)){
+				power_phase(POWER_PHASE_SD);
+				data = memory_frame_begin();
+				ix = health_build_record(data);
+
+				crc = checksum(data, ix);
+
+				data[ix++] = (uint8_t)((crc & 0xFF00) >> 8);
+				data[ix++] = (uint8_t)(crc & 0x00FF);
+
+				memory_frame_end(ix);
+
+#if TELEMETRY_EN
+				power_phase(POWER_PHASE_SERIAL);
+				telemetry_send_frame(data, ix);
+#endif
+
+				ix = 0;
+			}
+
+			if (diag_update(now)){
+				power_phase(POWER_PHASE_SENSORS);
+				diag_measure_supply();
+
+				power_phase(POWER_PHASE_SD);
+				data = memory_frame_begin();
+				ix = diag_build_record(data);
+
+				crc = checksum(data, ix);
+
+				data[ix++] = (uint8_t)((crc & 0xFF00) >> 8);
+				data[ix++] = (uint8_t)(crc & 0x00FF);
+
+				memory_frame_end(ix);
+
+#if TELEMETRY_EN
+				power_phase(POWER_PHASE_SERIAL);
+				telemetry_send_frame(data, ix);
+#endif
+
+				ix = 0;
+			}
+
+			// The frames of this wake are sent, the block cache is free.
+			power_phase(POWER_PHASE_SD);
+			memory_sync();
+
+#if DEBUG_SRAM_SERIAL
+			power_phase(POWER_PHASE_SERIAL);
+			sram_dump();
+#endif
+
+			// The record writes and the sync are accounted in this wake.
+			energy_end_wake();
+
+			watchdog_end_wake();
 		}
 
 	goto_sleep();
@@ -127,74 +239,53 @@ int main(){
 int init_setup(void){
 
 	int err = 0;
+	int settings_err = 0;
+	int modules_err = 0;
 
 #if SERIAL_EN
 	Serial.begin(SERIAL_BAUD_RATE);
 #endif
 
-	PRINTFUNCT;
+	TRACE(TRACE_EV_INIT_SETUP);
 
 	status_blinker_init();
-	init_relay();
-	init_instruments();
-	activate_instruments();
+	power_init();
 
 	Wire.begin();
-
-	err |= rtc_init();
+	bus_init();
 
 	err |= init_memory();
 
-	err |= init_modules();
+	// The settings are needed by the RTC and the modules. Corrupted
+	// ones fall back on the previous or the default settings.
+	settings_err = settings_init();
 
-	/* delay to ensure proper initialisation */
-	delay(500);
+	err |= rtc_init();
 
-	status_blinker_disable();
-	return err;
-}
+	modules_configure();
 
+	// A failed module is only reported, it is saved as missing.
+	modules_err = init_modules(settings.sensors);
 
-void init_relay(){
-	PRINTFUNCT;
-	pinMode(RELAY_9V_PIN, OUTPUT);
-}
+	/* delay to ensure proper initialisation */
+	clock_wait_ms(500);
 
-void activate_relay(){
-	PRINTFUNCT;
-	digitalWrite(RELAY_9V_PIN, LOW);
-}
+	power_all_off();
 
-void deactivate_relay(){
-	PRINTFUNCT;
-	digitalWrite(RELAY_9V_PIN, HIGH);
-}
+	status_blinker_disable();
 
-void init_instruments(){
-	PRINTFUNCT;
-	pinMode(PT100_POWER_PIN, OUTPUT);
-	pinMode(HDC1080_POWER_PIN, OUTPUT);
-	pinMode(AS7262_POWER_PIN, OUTPUT);
-}
+	if ((settings_err | modules_err) != ERROR_OK){
+		signal_warning(settings_err | modules_err);
+	}
 
-void activate_instruments(){
-	PRINTFUNCT;
-	digitalWrite(PT100_POWER_PIN, HIGH);
-	digitalWrite(HDC1080_POWER_PIN, HIGH);
-	digitalWrite(AS7262_POWER_PIN, HIGH);
-	delay(1000);
-}
+	energy_init();
 
-void deactivate_instruments(){
-	PRINTFUNCT;
-	digitalWrite(PT100_POWER_PIN, LOW);
-	digitalWrite(HDC1080_POWER_PIN, LOW);
-	digitalWrite(AS7262_POWER_PIN, LOW);
+	return err;
 }
 
 
 uint16_t checksum(const uint8_t *c_ptr, size_t len){
-	PRINTFUNCT;
+	TRACE(TRACE_EV_CHECKSUM);
 	uint16_t xsum = 0;
 	while(len--){
 		xsum += *(c_ptr++);
@@ -0,0 +1,70 @@
+/*
+ * interrupt.h
+ *
+ * Created: 2026-10-19 9:42:30 PM
+ *  Author: Alexis Laframboise
+ *
+ *	Interrupts of the simulator. An ISR is a C function named
+ *	after its vector, the HAL calls it when its flag and its
+ *	enable bit are set and SREG_I is set. sei() runs the
+ *	interrupts that are pending.
+ */
+
+
+#ifndef SIM_AVR_INTERRUPT_H_
+#define SIM_AVR_INTERRUPT_H_
+
+#include <avr/io.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void sim_sei(void);
+void sim_cli(void);
+#ifdef __cplusplus
+}
+#endif
+
+#define sei()		sim_sei()
+#define cli()		sim_cli()
+
+#define _VECTOR(N)	__vector_ ## N
+
+#define INT0_vect			_VECTOR(1)
+#define INT1_vect			_VECTOR(2)
+#define PCINT0_vect			_VECTOR(3)
+#define PCINT1_vect			_VECTOR(4)
+#define PCINT2_vect			_VECTOR(5)
+#define WDT_vect			_VECTOR(6)
+#define TIMER2_COMPA_vect	_VECTOR(7)
+#define TIMER2_COMPB_vect	_VECTOR(8)
+#define TIMER2_OVF_vect		_VECTOR(9)
+#define TIMER1_CAPT_vect	_VECTOR(10)
+#define TIMER1_COMPA_vect	_VECTOR(11)
+#define TIMER1_COMPB_vect	_VECTOR(12)
+#define TIMER1_OVF_vect		_VECTOR(13)
+#define TIMER0_COMPA_vect	_VECTOR(14)
+#define TIMER0_COMPB_vect	_VECTOR(15)
+#define TIMER0_OVF_vect		_VECTOR(16)
+#define SPI_STC_vect		_VECTOR(17)
+#define USART_RX_vect		_VECTOR(18)
+#define USART_UDRE_vect		_VECTOR(19)
+#define USART_TX_vect		_VECTOR(20)
+#define ADC_vect			_VECTOR(21)
+#define EE_READY_vect		_VECTOR(22)
+#define ANALOG_COMP_vect	_VECTOR(23)
+#define TWI_vect			_VECTOR(24)
+#define SPM_READY_vect		_VECTOR(25)
+
+#ifdef __cplusplus
+#define ISR(vector, ...)	extern "C" void vector(void); extern "C" void vector(void)
+#else
+#define ISR(vector, ...)	void vector(void); void vector(void)
+#endif
+
+#define ISR_BLOCK
+#define ISR_NOBLOCK
+#define ISR_NAKED
+#define EMPTY_INTERRUPT(vector)	ISR(vector) {}
+
+#endif /* SIM_AVR_INTERRUPT_H_ */
@@ -0,0 +1,634 @@
+/*
+ * io.h
+ *
+ * Created: 2026-10-19 9:41:07 PM
+ *  Author: Alexis Laframboise
+ *
+ *	ATmega328P registers for the host simulator. Each register
+ *	is a variable of the HAL (sim/src/hal_core.cpp), the timer 1,
+ *	the sleep and the watchdog models read them. SPDR and ADCSRA
+ *	are objects : writing them exchanges a byte with the SD card
+ *	model or runs an ADC conversion.
+ */
+
+
+#ifndef SIM_AVR_IO_H_
+#define SIM_AVR_IO_H_
+
+#include <stdint.h>
+#include <avr/sfr_defs.h>
+
+#define RAMSTART	(0x100)
+#define RAMEND		(0x8FF)
+#define XRAMEND		RAMEND
+#define E2END		(0x3FF)
+#define E2PAGESIZE	(4)
+#define FLASHEND	(0x7FFF)
+#define SPM_PAGESIZE (128)
+
+/* Registers, a variable each. */
+extern volatile uint8_t PINB;
+extern volatile uint8_t DDRB;
+extern volatile uint8_t PORTB;
+extern volatile uint8_t PINC;
+extern volatile uint8_t DDRC;
+extern volatile uint8_t PORTC;
+extern volatile uint8_t PIND;
+extern volatile uint8_t DDRD;
+extern volatile uint8_t PORTD;
+extern volatile uint8_t PCIFR;
+extern volatile uint8_t EIFR;
+extern volatile uint8_t EIMSK;
+extern volatile uint8_t GPIOR0;
+extern volatile uint8_t EECR;
+extern volatile uint8_t EEDR;
+extern volatile uint8_t GTCCR;
+extern volatile uint8_t TCCR0A;
+extern volatile uint8_t TCCR0B;
+extern volatile uint8_t TCNT0;
+extern volatile uint8_t OCR0A;
+extern volatile uint8_t OCR0B;
+extern volatile uint8_t GPIOR1;
+extern volatile uint8_t GPIOR2;
+extern volatile uint8_t SPCR;
+extern volatile uint8_t SPSR;
+extern volatile uint8_t ACSR;
+extern volatile uint8_t SMCR;
+extern volatile uint8_t MCUSR;
+extern volatile uint8_t MCUCR;
+extern volatile uint8_t SPMCSR;
+extern volatile uint8_t SREG;
+extern volatile uint8_t WDTCSR;
+extern volatile uint8_t CLKPR;
+extern volatile uint8_t PRR;
+extern volatile uint8_t OSCCAL;
+extern volatile uint8_t PCICR;
+extern volatile uint8_t EICRA;
+extern volatile uint8_t PCMSK0;
+extern volatile uint8_t PCMSK1;
+extern volatile uint8_t PCMSK2;
+extern volatile uint8_t TIMSK0;
+extern volatile uint8_t TIMSK1;
+extern volatile uint8_t TIMSK2;
+extern volatile uint8_t ADCSRB;
+extern volatile uint8_t ADMUX;
+extern volatile uint8_t DIDR0;
+extern volatile uint8_t DIDR1;
+extern volatile uint8_t TCCR1A;
+extern volatile uint8_t TCCR1B;
+extern volatile uint8_t TCCR1C;
+extern volatile uint8_t TCCR2A;
+extern volatile uint8_t TCCR2B;
+extern volatile uint8_t TCNT2;
+extern volatile uint8_t OCR2A;
+extern volatile uint8_t OCR2B;
+extern volatile uint8_t ASSR;
+extern volatile uint8_t TWBR;
+extern volatile uint8_t TWSR;
+extern volatile uint8_t TWAR;
+extern volatile uint8_t TWDR;
+extern volatile uint8_t TWCR;
+extern volatile uint8_t TWAMR;
+extern volatile uint8_t UCSR0A;
+extern volatile uint8_t UCSR0B;
+extern volatile uint8_t UCSR0C;
+extern volatile uint8_t UBRR0L;
+extern volatile uint8_t UBRR0H;
+extern volatile uint8_t UDR0;
+extern volatile uint16_t EEAR;
+extern volatile uint16_t SP;
+extern volatile uint16_t TCNT1;
+extern volatile uint16_t ICR1;
+extern volatile uint16_t OCR1A;
+extern volatile uint16_t OCR1B;
+extern volatile uint16_t ADC;
+
+/* Defined as themselves, for the #ifdef of the libraries. */
+#define PINB     PINB
+#define DDRB     DDRB
+#define PORTB    PORTB
+#define PINC     PINC
+#define DDRC     DDRC
+#define PORTC    PORTC
+#define PIND     PIND
+#define DDRD     DDRD
+#define PORTD    PORTD
+#define PCIFR    PCIFR
+#define EIFR     EIFR
+#define EIMSK    EIMSK
+#define GPIOR0   GPIOR0
+#define EECR     EECR
+#define EEDR     EEDR
+#define GTCCR    GTCCR
+#define TCCR0A   TCCR0A
+#define TCCR0B   TCCR0B
+#define TCNT0    TCNT0
+#define OCR0A    OCR0A
+#define OCR0B    OCR0B
+#define GPIOR1   GPIOR1
+#define GPIOR2   GPIOR2
+#define SPCR     SPCR
+#define SPSR     SPSR
+#define ACSR     ACSR
+#define SMCR     SMCR
+#define MCUSR    MCUSR
+#define MCUCR    MCUCR
+#define SPMCSR   SPMCSR
+#define SREG     SREG
+#define WDTCSR   WDTCSR
+#define CLKPR    CLKPR
+#define PRR      PRR
+#define OSCCAL   OSCCAL
+#define PCICR    PCICR
+#define EICRA    EICRA
+#define PCMSK0   PCMSK0
+#define PCMSK1   PCMSK1
+#define PCMSK2   PCMSK2
+#define TIMSK0   TIMSK0
+#define TIMSK1   TIMSK1
+#define TIMSK2   TIMSK2
+#define ADCSRB   ADCSRB
+#define ADMUX    ADMUX
+#define DIDR0    DIDR0
+#define DIDR1    DIDR1
+#define TCCR1A   TCCR1A
+#define TCCR1B   TCCR1B
+#define TCCR1C   TCCR1C
+#define TCCR2A   TCCR2A
+#define TCCR2B   TCCR2B
+#define TCNT2    TCNT2
+#define OCR2A    OCR2A
+#define OCR2B    OCR2B
+#define ASSR     ASSR
+#define TWBR     TWBR
+#define TWSR     TWSR
+#define TWAR     TWAR
+#define TWDR     TWDR
+#define TWCR     TWCR
+#define TWAMR    TWAMR
+#define UCSR0A   UCSR0A
+#define UCSR0B   UCSR0B
+#define UCSR0C   UCSR0C
+#define UBRR0L   UBRR0L
+#define UBRR0H   UBRR0H
+#define UDR0     UDR0
+#define EEAR     EEAR
+#define SP       SP
+#define TCNT1    TCNT1
+#define ICR1     ICR1
+#define OCR1A    OCR1A
+#define OCR1B    OCR1B
+#define ADC      ADC
+
+/* PORTB */
+#define PORTB0     0
+#define PORTB1     1
+#define PORTB2     2
+#define PORTB3     3
+#define PORTB4     4
+#define PORTB5     5
+#define PORTB6     6
+#define PORTB7     7
+
+/* DDRB */
+#define DDB0       0
+#define DDB1       1
+#define DDB2       2
+#define DDB3       3
+#define DDB4       4
+#define DDB5       5
+#define DDB6       6
+#define DDB7       7
+
+/* PINB */
+#define PINB0      0
+#define PINB1      1
+#define PINB2      2
+#define PINB3      3
+#define PINB4      4
+#define PINB5      5
+#define PINB6      6
+#define PINB7      7
+
+/* PORTC */
+#define PORTC0     0
+#define PORTC1     1
+#define PORTC2     2
+#define PORTC3     3
+#define PORTC4     4
+#define PORTC5     5
+#define PORTC6     6
+
+/* DDRC */
+#define DDC0       0
+#define DDC1       1
+#define DDC2       2
+#define DDC3       3
+#define DDC4       4
+#define DDC5       5
+#define DDC6       6
+
+/* PINC */
+#define PINC0      0
+#define PINC1      1
+#define PINC2      2
+#define PINC3      3
+#define PINC4      4
+#define PINC5      5
+#define PINC6      6
+
+/* PORTD */
+#define PORTD0     0
+#define PORTD1     1
+#define PORTD2     2
+#define PORTD3     3
+#define PORTD4     4
+#define PORTD5     5
+#define PORTD6     6
+#define PORTD7     7
+
+/* DDRD */
+#define DDD0       0
+#define DDD1       1
+#define DDD2       2
+#define DDD3       3
+#define DDD4       4
+#define DDD5       5
+#define DDD6       6
+#define DDD7       7
+
+/* PIND */
+#define PIND0      0
+#define PIND1      1
+#define PIND2      2
+#define PIND3      3
+#define PIND4      4
+#define PIND5      5
+#define PIND6      6
+#define PIND7      7
+
+/* TIFR0 */
+#define OCF0B      2
+#define OCF0A      1
+#define TOV0       0
+
+/* TIFR1 */
+#define ICF1       5
+#define OCF1B      2
+#define OCF1A      1
+#define TOV1       0
+
+/* TIFR2 */
+#define OCF2B      2
+#define OCF2A      1
+#define TOV2       0
+
+/* PCIFR */
+#define PCIF2      2
+#define PCIF1      1
+#define PCIF0      0
+
+/* EIFR */
+#define INTF1      1
+#define INTF0      0
+
+/* EIMSK */
+#define INT1       1
+#define INT0       0
+
+/* EECR */
+#define EEPM1      5
+#define EEPM0      4
+#define EERIE      3
+#define EEMPE      2
+#define EEPE       1
+#define EERE       0
+
+/* GTCCR */
+#define TSM        7
+#define PSRASY     1
+#define PSRSYNC    0
+
+/* TCCR0A */
+#define COM0A1     7
+#define COM0A0     6
+#define COM0B1     5
+#define COM0B0     4
+#define WGM01      1
+#define WGM00      0
+
+/* TCCR0B */
+#define FOC0A      7
+#define FOC0B      6
+#define WGM02      3
+#define CS02       2
+#define CS01       1
+#define CS00       0
+
+/* SPCR */
+#define SPIE       7
+#define SPE        6
+#define DORD       5
+#define MSTR       4
+#define CPOL       3
+#define CPHA       2
+#define SPR1       1
+#define SPR0       0
+
+/* SPSR */
+#define SPIF       7
+#define WCOL       6
+#define SPI2X      0
+
+/* ACSR */
+#define ACD        7
+#define ACBG       6
+#define ACO        5
+#define ACI        4
+#define ACIE       3
+#define ACIC       2
+#define ACIS1      1
+#define ACIS0      0
+
+/* SMCR */
+#define SM2        3
+#define SM1        2
+#define SM0        1
+#define SE         0
+
+/* MCUSR */
+#define WDRF       3
+#define BORF       2
+#define EXTRF      1
+#define PORF       0
+
+/* MCUCR */
+#define BODS       6
+#define BODSE      5
+#define PUD        4
+#define IVSEL      1
+#define IVCE       0
+
+/* SPMCSR */
+#define SPMIE      7
+#define RWWSB      6
+#define SIGRD      5
+#define RWWSRE     4
+#define BLBSET     3
+#define PGWRT      2
+#define PGERS      1
+#define SPMEN      0
+
+/* WDTCSR */
+#define WDIF       7
+#define WDIE       6
+#define WDP3       5
+#define WDCE       4
+#define WDE        3
+#define WDP2       2
+#define WDP1       1
+#define WDP0       0
+
+/* CLKPR */
+#define CLKPCE     7
+#define CLKPS3     3
+#define CLKPS2     2
+#define CLKPS1     1
+#define CLKPS0     0
+
+/* PRR */
+#define PRTWI      7
+#define PRTIM2     6
+#define PRTIM0     5
+#define PRTIM1     3
+#define PRSPI      2
+#define PRUSART0   1
+#define PRADC      0
+
+/* PCICR */
+#define PCIE2      2
+#define PCIE1      1
+#define PCIE0      0
+
+/* EICRA */
+#define ISC11      3
+#define ISC10      2
+#define ISC01      1
+#define ISC00      0
+
+/* TIMSK0 */
+#define OCIE0B     2
+#define OCIE0A     1
+#define TOIE0      0
+
+/* TIMSK1 */
+#define ICIE1      5
+#define OCIE1B     2
+#define OCIE1A     1
+#define TOIE1      0
+
+/* TIMSK2 */
+#define OCIE2B     2
+#define OCIE2A     1
+#define TOIE2      0
+
+/* ADCSRA */
+#define ADEN       7
+#define ADSC       6
+#define ADATE      5
+#define ADIF       4
+#define ADIE       3
+#define ADPS2      2
+#define ADPS1      1
+#define ADPS0      0
+
+/* ADCSRB */
+#define ACME       6
+#define ADTS2      2
+#define ADTS1      1
+#define ADTS0      0
+
+/* ADMUX */
+#define REFS1      7
+#define REFS0      6
+#define ADLAR      5
+#define MUX3       3
+#define MUX2       2
+#define MUX1       1
+#define MUX0       0
+
+/* DIDR0 */
+#define ADC5D      5
+#define ADC4D      4
+#define ADC3D      3
+#define ADC2D      2
+#define ADC1D      1
+#define ADC0D      0
+
+/* DIDR1 */
+#define AIN1D      1
+#define AIN0D      0
+
+/* TCCR1A */
+#define COM1A1     7
+#define COM1A0     6
+#define COM1B1     5
+#define COM1B0     4
+#define WGM11      1
+#define WGM10      0
+
+/* TCCR1B */
+#define ICNC1      7
+#define ICES1      6
+#define WGM13      4
+#define WGM12      3
+#define CS12       2
+#define CS11       1
+#define CS10       0
+
+/* TCCR1C */
+#define FOC1A      7
+#define FOC1B      6
+
+/* TCCR2A */
+#define COM2A1     7
+#define COM2A0     6
+#define COM2B1     5
+#define COM2B0     4
+#define WGM21      1
+#define WGM20      0
+
+/* TCCR2B */
+#define FOC2A      7
+#define FOC2B      6
+#define WGM22      3
+#define CS22       2
+#define CS21       1
+#define CS20       0
+
+/* ASSR */
+#define EXCLK      6
+#define AS2        5
+#define TCN2UB     4
+#define OCR2AUB    3
+#define OCR2BUB    2
+#define TCR2AUB    1
+#define TCR2BUB    0
+
+/* TWSR */
+#define TWS7       7
+#define TWS6       6
+#define TWS5       5
+#define TWS4       4
+#define TWS3       3
+#define TWPS1      1
+#define TWPS0      0
+
+/* TWAR */
+#define TWGCE      0
+
+/* TWCR */
+#define TWINT      7
+#define TWEA       6
+#define TWSTA      5
+#define TWSTO      4
+#define TWWC       3
+#define TWEN       2
+#define TWIE       0
+
+/* UCSR0A */
+#define RXC0       7
+#define TXC0       6
+#define UDRE0      5
+#define FE0        4
+#define DOR0       3
+#define UPE0       2
+#define U2X0       1
+#define MPCM0      0
+
+/* UCSR0B */
+#define RXCIE0     7
+#define TXCIE0     6
+#define UDRIE0     5
+#define RXEN0      4
+#define TXEN0      3
+#define UCSZ02     2
+#define RXB80      1
+#define TXB80      0
+
+/* UCSR0C */
+#define UMSEL01    7
+#define UMSEL00    6
+#define UPM01      5
+#define UPM00      4
+#define USBS0      3
+#define UCSZ01     2
+#define UCSZ00     1
+#define UCPOL0     0
+
+/* SREG */
+#define SREG_I     7
+#define SREG_T     6
+#define SREG_H     5
+#define SREG_S     4
+#define SREG_V     3
+#define SREG_N     2
+#define SREG_Z     1
+#define SREG_C     0
+/* 16 bit registers, low and high bytes (little endian host) */
+#define TCNT1L		(((volatile uint8_t*)&TCNT1)[0])
+#define TCNT1H		(((volatile uint8_t*)&TCNT1)[1])
+#define OCR1AL		(((volatile uint8_t*)&OCR1A)[0])
+#define OCR1AH		(((volatile uint8_t*)&OCR1A)[1])
+#define ADCL		(((volatile uint8_t*)&ADC)[0])
+#define ADCH		(((volatile uint8_t*)&ADC)[1])
+#define ADCW		ADC
+
+#ifdef __cplusplus
+
+/** SPI data register : a write shifts the byte out to the
+ *	selected device and sets SPIF, a read returns the byte
+ *	shifted in. */
+class sim_spdr_t {
+public:
+	sim_spdr_t& operator=(uint8_t mosi);
+	operator uint8_t() const;
+};
+
+/** ADC control register : setting ADSC runs the conversion
+ *	of the ADMUX channel at once, ADC holds the result. */
+class sim_adcsra_t {
+	uint8_t value;
+public:
+	sim_adcsra_t& operator=(uint8_t v);
+	sim_adcsra_t& operator|=(uint8_t v) { return *this = value | v; }
+	sim_adcsra_t& operator&=(uint8_t v) { return *this = value & v; }
+	operator uint8_t() const { return value; }
+};
+
+/** Interrupt flag register : a flag is cleared by writing a
+ *	one to it, the timer models raise them. */
+class sim_flags_t {
+	volatile uint8_t value;
+public:
+	sim_flags_t& operator=(uint8_t v) { value &= ~v; return *this; }
+	sim_flags_t& operator|=(uint8_t v) { value &= ~(value | v); return *this; }
+	sim_flags_t& operator&=(uint8_t v) { value &= ~(value & v); return *this; }
+	operator uint8_t() const { return value; }
+	void raise(uint8_t v) { value |= v; }
+};
+
+extern sim_spdr_t SPDR;
+extern sim_adcsra_t ADCSRA;
+extern sim_flags_t TIFR0;
+extern sim_flags_t TIFR1;
+extern sim_flags_t TIFR2;
+#define SPDR		SPDR
+#define ADCSRA		ADCSRA
+#define TIFR0		TIFR0
+#define TIFR1		TIFR1
+#define TIFR2		TIFR2
+
+#endif /* __cplusplus */
+
+#endif /* SIM_AVR_IO_H_ */
@@ -0,0 +1,24 @@
+/*
+ * sfr_defs.h
+ *
+ * Created: 2026-10-19 9:41:52 PM
+ *  Author: Alexis Laframboise
+ *
+ *	Register bit helpers of avr-libc, on the register variables
+ *	of the simulator.
+ */
+
+
+#ifndef SIM_AVR_SFR_DEFS_H_
+#define SIM_AVR_SFR_DEFS_H_
+
+#define _BV(bit)					(1 << (bit))
+#define _SFR_BYTE(sfr)				(sfr)
+#define _SFR_WORD(sfr)				(sfr)
+
+#define bit_is_set(sfr, bit)		(_SFR_BYTE(sfr) & _BV(bit))
+#define bit_is_clear(sfr, bit)		(!(_SFR_BYTE(sfr) & _BV(bit)))
+#define loop_until_bit_is_set(sfr, bit)		do { } while (bit_is_clear(sfr, bit))
+#define loop_until_bit_is_clear(sfr, bit)	do { } while (bit_is_set(sfr, bit))
+
+#endif /* SIM_AVR_SFR_DEFS_H_ */
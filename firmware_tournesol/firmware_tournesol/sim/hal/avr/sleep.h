@@ -0,0 +1,39 @@
+/*
+ * sleep.h
+ *
+ * Created: 2026-10-19 9:43:31 PM
+ *  Author: Alexis Laframboise
+ *
+ *	Sleep of the simulator : sleep_cpu() fast-forwards the
+ *	virtual clock to the next wake-up source, the RTC alarm.
+ */
+
+
+#ifndef SIM_AVR_SLEEP_H_
+#define SIM_AVR_SLEEP_H_
+
+#include <avr/io.h>
+
+#define SLEEP_MODE_IDLE			(0x00 << 1)
+#define SLEEP_MODE_ADC			(0x01 << 1)
+#define SLEEP_MODE_PWR_DOWN		(0x02 << 1)
+#define SLEEP_MODE_PWR_SAVE		(0x03 << 1)
+#define SLEEP_MODE_STANDBY		(0x06 << 1)
+#define SLEEP_MODE_EXT_STANDBY	(0x07 << 1)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void sim_sleep_cpu(void);
+#ifdef __cplusplus
+}
+#endif
+
+#define set_sleep_mode(mode)	(SMCR = (SMCR & ~(_BV(SM0) | _BV(SM1) | _BV(SM2))) | (mode))
+#define sleep_enable()			(SMCR |= _BV(SE))
+#define sleep_disable()			(SMCR &= (uint8_t)~_BV(SE))
+#define sleep_cpu()				sim_sleep_cpu()
+#define sleep_mode()			do { sleep_enable(); sleep_cpu(); sleep_disable(); } while (0)
+#define sleep_bod_disable()		(MCUCR = _BV(BODS))
+
+#endif /* SIM_AVR_SLEEP_H_ */
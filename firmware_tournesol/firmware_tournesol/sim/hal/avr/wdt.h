@@ -0,0 +1,43 @@
+/*
+ * wdt.h
+ *
+ * Created: 2026-10-19 9:43:58 PM
+ *  Author: Alexis Laframboise
+ *
+ *	Watchdog of the simulator. It counts the virtual time, the
+ *	run stops with an error when it expires : on the station,
+ *	it would reset the MCU.
+ */
+
+
+#ifndef SIM_AVR_WDT_H_
+#define SIM_AVR_WDT_H_
+
+#include <avr/io.h>
+
+#define WDTO_15MS	(0)
+#define WDTO_30MS	(1)
+#define WDTO_60MS	(2)
+#define WDTO_120MS	(3)
+#define WDTO_250MS	(4)
+#define WDTO_500MS	(5)
+#define WDTO_1S		(6)
+#define WDTO_2S		(7)
+#define WDTO_4S		(8)
+#define WDTO_8S		(9)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void sim_wdt_enable(uint8_t timeout);
+void sim_wdt_reset(void);
+void sim_wdt_disable(void);
+#ifdef __cplusplus
+}
+#endif
+
+#define wdt_enable(timeout)		sim_wdt_enable(timeout)
+#define wdt_reset()				sim_wdt_reset()
+#define wdt_disable()			sim_wdt_disable()
+
+#endif /* SIM_AVR_WDT_H_ */
@@ -0,0 +1,27 @@
+/*
+ * avr_libc.h
+ *
+ * Created: 2026-10-19 9:45:40 PM
+ *  Author: Alexis Laframboise
+ *
+ *	What avr-libc adds to the standard headers, included
+ *	ahead of every firmware source of the simulator (-include).
+ */
+
+
+#ifndef SIM_AVR_LIBC_H_
+#define SIM_AVR_LIBC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+char* itoa(int value, char* s, int radix);
+char* utoa(unsigned int value, char* s, int radix);
+char* ltoa(long value, char* s, int radix);
+char* ultoa(unsigned long value, char* s, int radix);
+char* dtostrf(double value, signed char width, unsigned char prec, char* s);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_AVR_LIBC_H_ */
@@ -0,0 +1,55 @@
+/*
+ * crc16.h
+ *
+ * Created: 2026-10-19 9:44:49 PM
+ *  Author: Alexis Laframboise
+ *
+ *	CRC updates of avr-libc, the C equivalents given in its
+ *	documentation.
+ */
+
+
+#ifndef SIM_UTIL_CRC16_H_
+#define SIM_UTIL_CRC16_H_
+
+#include <stdint.h>
+
+static inline uint16_t _crc16_update(uint16_t crc, uint8_t a){
+	crc ^= a;
+	for (uint8_t i = 0; i < 8; i++){
+		crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : (crc >> 1);
+	}
+	return crc;
+}
+
+static inline uint16_t _crc_xmodem_update(uint16_t crc, uint8_t data){
+	crc ^= (uint16_t)data << 8;
+	for (uint8_t i = 0; i < 8; i++){
+		crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+	}
+	return crc;
+}
+
+static inline uint16_t _crc_ccitt_update(uint16_t crc, uint8_t data){
+	data ^= (uint8_t)(crc & 0xFF);
+	data ^= data << 4;
+	return ((((uint16_t)data << 8) | (crc >> 8)) ^ (uint8_t)(data >> 4) ^ ((uint16_t)data << 3));
+}
+
+static inline uint8_t _crc_ibutton_update(uint8_t crc, uint8_t data){
+	crc ^= data;
+	for (uint8_t i = 0; i < 8; i++){
+		crc = (crc & 0x01) ? (crc >> 1) ^ 0x8C : (crc >> 1);
+	}
+	return crc;
+}
+
+static inline uint8_t _crc8_ccitt_update(uint8_t crc, uint8_t data){
+	data ^= crc;
+	for (uint8_t i = 0; i < 8; i++){
+		data = (data & 0x80) ? (data << 1) ^ 0x07 : (data << 1);
+	}
+	return data;
+}
+
+#endif /* SIM_UTIL_CRC16_H_ */
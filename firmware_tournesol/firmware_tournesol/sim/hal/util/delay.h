@@ -0,0 +1,28 @@
+/*
+ * delay.h
+ *
+ * Created: 2026-10-19 9:45:13 PM
+ *  Author: Alexis Laframboise
+ *
+ *	Busy waits of avr-libc : they count CPU cycles, they last
+ *	longer when the system clock is divided.
+ */
+
+
+#ifndef SIM_UTIL_DELAY_H_
+#define SIM_UTIL_DELAY_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void sim_delay_cycles(uint32_t cycles);
+#ifdef __cplusplus
+}
+#endif
+
+#define _delay_us(us)	sim_delay_cycles((uint32_t)((us) * (F_CPU / 1000000.0)))
+#define _delay_ms(ms)	sim_delay_cycles((uint32_t)((ms) * (F_CPU / 1000.0)))
+
+#endif /* SIM_UTIL_DELAY_H_ */
@@ -0,0 +1,226 @@
+/*
+ * models.h
+ *
+ * Created: 2026-10-19 10:21:30 PM
+ *  Author: Alexis Laframboise
+ *
+ *	Device models of the simulator and the run they share,
+ *	built with the host flags. The HAL reaches them through the
+ *	C interface of sim.h only.
+ */
+
+
+#ifndef SIM_MODELS_H_
+#define SIM_MODELS_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "sim.h"
+
+/* I2C addresses */
+#define DS3231_MODEL_ADDR	(0x68)
+#define HDC1080_MODEL_ADDR	(0x40)
+#define AS7262_MODEL_ADDR	(0x49)
+
+/* Epoch of the firmware timestamps, 2000-01-01 (DS3231.cpp) */
+#define MODEL_YEAR_2000_S	(946702800UL)
+
+#define AS7262_CHANNELS		(6)
+
+/* ---- sim_main.cpp ---- */
+
+/** @brief	Log of the run (sim.log) : the wakes, the warnings
+ *			and the model events, stamped with the wall clock.
+ *
+ *  @param	printf format and arguments
+ */
+void sim_log(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+
+/** @brief	Time of a powered device since its rail was
+ *			switched on.
+ *
+ *  @param	power pin and level that switches it on
+ *  @return	cycles, SIM_NEVER while the rail is off
+ */
+uint64_t sim_powered_for(uint8_t pin, uint8_t on_level);
+
+/** @brief	Notes the depth of the stack, for the soak records.
+ *			Called by the models at each transfer.
+ *
+ */
+void sim_stack_mark(void);
+
+/* ---- replay.cpp ---- */
+
+/** @brief	Loads the captures of tests/ : Spectro_calib.txt,
+ *			Anemometre_calib.txt and rtd_calib.txt.
+ *
+ *  @param	directory
+ *  @return	true if the three are read
+ */
+bool replay_load(const char* dir);
+
+/** @brief	Next reading of the AS7262 capture, looped.
+ *
+ *  @return	calibrated channels, violet to red
+ */
+const float* replay_spectro_next(void);
+
+/** @brief	Next raw count of the anemometer capture, looped.
+ *
+ */
+uint16_t replay_anemometer_next(void);
+
+/** @brief	Next raw count of the PT100 capture, looped.
+ *
+ */
+uint16_t replay_pt100_next(void);
+
+/* ---- model_analog.cpp ---- */
+
+/** @brief	Sets the supply of the station, read by the bandgap.
+ *
+ *  @param	AVcc in mV
+ */
+void analog_model_init(uint16_t supply_mv);
+
+/* ---- model_ds3231.cpp ---- */
+
+/** @brief	Sets the RTC, as it was set before the deployment.
+ *
+ *  @param	unix time read by the firmware at power up
+ */
+void ds3231_model_init(uint32_t unix_time);
+
+uint8_t ds3231_model_write(const uint8_t* data, uint8_t len);
+uint8_t ds3231_model_read(uint8_t* data, uint8_t len);
+
+/** @brief	Time of the RTC now, in seconds since 2000-01-01.
+ *
+ */
+uint32_t ds3231_model_now(void);
+
+/* ---- model_hdc1080.cpp ---- */
+
+uint8_t hdc1080_model_write(const uint8_t* data, uint8_t len);
+uint8_t hdc1080_model_read(uint8_t* data, uint8_t len);
+
+/* ---- model_as7262.cpp ---- */
+
+uint8_t as7262_model_write(const uint8_t* data, uint8_t len);
+uint8_t as7262_model_read(uint8_t* data, uint8_t len);
+
+/* ---- model_sd.cpp ---- */
+
+/* Latency histogram : bucket 0 under 1 ms, bucket i from 2^(i-1)
+   to 2^i ms, the last one above */
+#define SD_LATENCY_BUCKETS	(12)
+
+/* Operations of the card since the power up */
+struct sd_stats_t {
+	uint32_t commands;
+	uint32_t blocks_read;
+	uint32_t blocks_written;
+	uint32_t erases;			/* CMD38 */
+	uint32_t merges;			/* Full logs erased by the card, the spikes */
+	uint32_t block_erases;		/* Erase blocks erased, merges included */
+	uint32_t wear_max;			/* Erases of the most worn erase block */
+	uint32_t failures;			/* Injected errors and stalls */
+	uint64_t busy_cycles;		/* Card busy, the MCU polls */
+	uint64_t busy_max;			/* Longest busy period */
+	uint32_t latency[SD_LATENCY_BUCKETS];	/* Busy periods */
+};
+
+/** @brief	Sets the profile of the card : latency distributions
+ *			(fixed:us, uniform:min:max, exp:min:mean) of read,
+ *			write, multi, stop, erase and merge, erase_kib, log
+ *			(rewrites before a merge), wear_limit, fail_write,
+ *			fail_read, stall, stall_ms and seed. The entries not
+ *			given keep the typical class 4 card.
+ *
+ *  @param	key=value list separated by commas, NULL for the
+ *			typical card
+ *  @return	false if an entry is invalid
+ */
+bool sd_model_configure(const char* spec);
+
+/** @brief	Inserts a card, blank or the one of an image.
+ *
+ *  @param	capacity in 512 bytes blocks, image file or NULL to
+ *			keep it in memory; an image keeps its own size
+ *  @return	false if the image can't be mapped
+ */
+bool sd_model_init(uint32_t blocks, const char* image);
+
+/** @brief	Writes the image back and removes the card.
+ *
+ */
+void sd_model_close(void);
+
+/** @brief	Capacity of the card.
+ *
+ *  @return	blocks
+ */
+uint32_t sd_model_blocks(void);
+
+/** @brief	Block of the card, for the formatter and the
+ *			extraction of the files.
+ *
+ *  @param	block number
+ *  @return	512 bytes, zeros if never written
+ */
+const uint8_t* sd_model_block(uint32_t lba);
+
+/** @brief	Writes a block out of the SPI protocol, without
+ *			latency nor wear.
+ *
+ *  @param	block number and 512 bytes
+ */
+void sd_model_put(uint32_t lba, const uint8_t* data);
+
+/** @brief	Operations of the card.
+ *
+ */
+const sd_stats_t* sd_model_stats(void);
+
+/** @brief	Longest busy period since the last call.
+ *
+ *  @return	cycles
+ */
+uint64_t sd_model_peak(void);
+
+/** @brief	Writes the erase count of each worn erase block, CSV.
+ *
+ *  @param	file
+ *  @return	false if it can't be written
+ */
+bool sd_model_write_wear(const char* path);
+
+/* ---- model_fat.cpp ---- */
+
+/** @brief	Partitions and formats the card, one FAT16
+ *			partition, followed by a raw one of type 0xDA
+ *			(SD_STREAM_RAW) if asked.
+ *
+ *  @param	blocks of the raw partition, 0 for none
+ */
+void fat_model_format(uint32_t raw_blocks);
+
+/** @brief	Adds a file in the root directory.
+ *
+ *  @param	8.3 name, content and size
+ *  @return	true if it fits
+ */
+bool fat_model_add(const char* name, const uint8_t* data, uint32_t size);
+
+/** @brief	Copies the files of the root directory out of the
+ *			card, names in lower case, and the raw partition
+ *			as raw.bin.
+ *
+ *  @param	directory
+ *  @return	files copied, -1 if the card isn't readable
+ */
+int fat_model_extract(const char* dir);
+
+#endif /* SIM_MODELS_H_ */
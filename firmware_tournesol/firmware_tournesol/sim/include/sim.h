@@ -0,0 +1,186 @@
+/*
+ * sim.h
+ *
+ * Created: 2026-10-19 9:47:02 PM
+ *  Author: Alexis Laframboise
+ *
+ *	Interface between the HAL of the simulator, built with the
+ *	firmware flags (-fpack-struct, -fshort-enums), and the
+ *	device models, built with the host flags. Only scalars and
+ *	byte buffers cross it, no structure nor enum.
+ *
+ *	The time is counted in CPU cycles at F_CPU, from the power
+ *	up of the station. The wall clock runs all along, the awake
+ *	clock only while the MCU isn't sleeping (timer 0 and timer 1
+ *	are stopped in power-down). The virtual time only advances
+ *	in the HAL : delays, bus transfers, conversions, serial
+ *	output. The firmware code itself takes no time.
+ */
+
+
+#ifndef SIM_H_
+#define SIM_H_
+
+#include <stdint.h>
+
+#define SIM_F_CPU			(16000000UL)
+#define SIM_CYCLES_US		(SIM_F_CPU / 1000000UL)
+#define SIM_CYCLES_MS		(SIM_F_CPU / 1000UL)
+#define SIM_CYCLES_S		(SIM_F_CPU)
+#define SIM_NEVER			(UINT64_MAX)
+
+/* Pins of the station, connections.h and pins_arduino.h */
+#define SIM_PIN_ERROR_LED	(2)
+#define SIM_PIN_RTC_INT		(3)
+#define SIM_PIN_RELAY_9V	(5)
+#define SIM_PIN_PT100_POWER	(7)
+#define SIM_PIN_HDC1080_POWER (8)
+#define SIM_PIN_AS7262_POWER (9)
+#define SIM_PIN_SD_CS		(10)
+#define SIM_PIN_SDA			(18)
+#define SIM_PIN_SCL			(19)
+
+/* ADC channels */
+#define SIM_ADC_ANEMOMETER	(0)
+#define SIM_ADC_PT100		(1)
+#define SIM_ADC_BANDGAP		(14)
+
+/* twi_writeTo() results */
+#define SIM_I2C_OK			(0)
+#define SIM_I2C_NACK_ADDR	(2)
+#define SIM_I2C_NACK_DATA	(3)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ---- HAL, sim/src/hal_*.cpp ---- */
+
+/** @brief	Wall clock.
+ *
+ *  @return	cycles since the power up
+ */
+uint64_t sim_cycles(void);
+
+/** @brief	Awake clock, the wall clock without the sleeps.
+ *
+ *  @return	cycles
+ */
+uint64_t sim_awake_cycles(void);
+
+/** @brief	Level driven on a pin by the firmware.
+ *
+ *  @param	Arduino pin number
+ *  @return	0 or 1, -1 if the pin is an input
+ */
+int sim_pin_output(uint8_t pin);
+
+/** @brief	Last time the firmware switched the level of a
+ *			pin, to time the start-up of a powered device.
+ *
+ *  @param	Arduino pin number
+ *  @return	wall cycles, 0 if never switched
+ */
+uint64_t sim_pin_changed_at(uint8_t pin);
+
+/* ---- Models, sim/src/sim_main.cpp and model_*.cpp ---- */
+
+/** @brief	I2C write transfer, START to STOP.
+ *
+ *  @param	7 bits address, bytes and count
+ *  @return	SIM_I2C_OK or the NACK
+ */
+uint8_t sim_i2c_write(uint8_t addr, const uint8_t* data, uint8_t len);
+
+/** @brief	I2C read transfer.
+ *
+ *  @param	7 bits address, buffer and count
+ *  @return	bytes read, 0 on an address NACK
+ */
+uint8_t sim_i2c_read(uint8_t addr, uint8_t* data, uint8_t len);
+
+/** @brief	Level of an I2C line, released (1) unless a slave
+ *			holds it.
+ *
+ *  @param	SIM_PIN_SDA or SIM_PIN_SCL
+ *  @return	level
+ */
+uint8_t sim_i2c_line(uint8_t pin);
+
+/** @brief	Chip select of the SD card, driven by its pin.
+ *
+ *  @param	1 when selected (pin low)
+ */
+void sim_sd_select(uint8_t selected);
+
+/** @brief	Exchanges a byte with the SD card.
+ *
+ *  @param	byte shifted out (MOSI)
+ *  @return	byte shifted in (MISO)
+ */
+uint8_t sim_sd_transfer(uint8_t mosi);
+
+/** @brief	Samples an analog input.
+ *
+ *  @param	ADC channel, SIM_ADC_BANDGAP for the internal
+ *			reference
+ *  @return	10 bits result against AVcc
+ */
+uint16_t sim_adc_sample(uint8_t channel);
+
+/** @brief	Level of the RTC INT/SQW output, active low.
+ *
+ *  @return	level
+ */
+uint8_t sim_rtc_int_line(void);
+
+/** @brief	Next time the RTC INT/SQW output goes low.
+ *
+ *  @return	wall cycles, now if it is low, SIM_NEVER if no
+ *			alarm is armed
+ */
+uint64_t sim_rtc_next_int(void);
+
+/** @brief	Byte written on the serial port, once sent.
+ *
+ *  @param	byte
+ */
+void sim_serial_out(uint8_t c);
+
+/** @brief	The firmware allocated from the heap (malloc(),
+ *			new), see hal_sram.cpp.
+ *
+ *  @param	bytes
+ */
+void sim_heap_alloc(uint32_t bytes);
+
+/** @brief	The MCU wakes up, after a sleep.
+ *
+ *  @param	cycles slept
+ */
+void sim_wake(uint64_t slept);
+
+/** @brief	The MCU goes to sleep, the run may stop here.
+ *
+ */
+void sim_sleep(void);
+
+/** @brief	Reports a misuse of the hardware by the firmware,
+ *			the run goes on.
+ *
+ *  @param	printf format and arguments
+ */
+void sim_warn(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+
+/** @brief	Reports a failure the station can't go through
+ *			(watchdog reset, stuck awake), the run stops.
+ *
+ *  @param	printf format and arguments
+ */
+void sim_fatal(const char* fmt, ...) __attribute__((format(printf, 1, 2), noreturn));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_H_ */
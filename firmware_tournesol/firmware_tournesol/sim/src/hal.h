@@ -0,0 +1,37 @@
+/*
+ * hal.h
+ *
+ * Created: 2026-10-19 9:52:36 PM
+ *  Author: Alexis Laframboise
+ *
+ *	Internals shared by the HAL sources of the simulator
+ *	(hal_*.cpp), built with the firmware flags.
+ */
+
+
+#ifndef SIM_HAL_H_
+#define SIM_HAL_H_
+
+#include <stdint.h>
+
+/** @brief	Runs the awake MCU for some time : the wall and awake
+ *			clocks and timer 1 advance, the pending interrupts
+ *			are served, the watchdog and the hang deadlines are
+ *			checked.
+ *
+ *  @param	cycles at F_CPU
+ */
+void hal_advance(uint64_t cycles);
+
+/** @brief	Division of the system clock, CLKPR.
+ *
+ *  @return	shift, the CPU runs at F_CPU >> shift
+ */
+uint8_t hal_clock_shift(void);
+
+/** @brief	Serves the pending interrupts, if enabled.
+ *
+ */
+void hal_dispatch(void);
+
+#endif /* SIM_HAL_H_ */
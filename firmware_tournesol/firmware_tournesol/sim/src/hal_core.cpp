@@ -0,0 +1,634 @@
+/*
+ * hal_core.cpp
+ *
+ * Created: 2026-10-19 9:55:12 PM
+ *  Author: Alexis Laframboise
+ *
+ *	Registers, virtual clocks, timer 1, interrupts, pins, ADC,
+ *	sleep, watchdog and EEPROM of the simulated ATmega328P. It
+ *	replaces wiring*.c and WInterrupts.c of the Arduino core.
+ */
+
+#include <Arduino.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <avr/wdt.h>
+#include <avr/eeprom.h>
+#include <util/delay.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "hal.h"
+#include "sim.h"
+
+/* A wake longer than this is a hang (signal_error() loops forever,
+   the watchdog is only armed for the wake cycles). */
+#define HAL_HANG_S			(60)
+
+/* Pins of the Nano, D0 to A5 */
+#define HAL_PIN_COUNT		(20)
+
+/* EEPROM programming time, erase and write, on its own oscillator */
+#define HAL_EEPROM_WRITE_CYCLES (SIM_CYCLES_US * 3400)
+
+/* ---- Registers ---- */
+
+volatile uint8_t PINB, DDRB, PORTB, PINC, DDRC, PORTC, PIND, DDRD, PORTD;
+volatile uint8_t PCIFR, EIFR, EIMSK, GPIOR0, EECR, EEDR, GTCCR;
+volatile uint8_t TCCR0A, TCCR0B, TCNT0, OCR0A, OCR0B, GPIOR1, GPIOR2;
+volatile uint8_t SPCR, SPSR, ACSR, SMCR, MCUSR, MCUCR, SPMCSR, SREG;
+volatile uint8_t WDTCSR, CLKPR, PRR, OSCCAL, PCICR, EICRA, PCMSK0, PCMSK1, PCMSK2;
+volatile uint8_t TIMSK0, TIMSK1, TIMSK2, ADCSRB, ADMUX, DIDR0, DIDR1;
+volatile uint8_t TCCR1A, TCCR1B, TCCR1C, TCCR2A, TCCR2B, TCNT2, OCR2A, OCR2B, ASSR;
+volatile uint8_t TWBR, TWSR, TWAR, TWDR, TWCR, TWAMR;
+volatile uint8_t UCSR0A, UCSR0B, UCSR0C, UBRR0L, UBRR0H, UDR0;
+volatile uint16_t EEAR, SP, TCNT1, ICR1, OCR1A, OCR1B, ADC;
+
+sim_adcsra_t ADCSRA;
+sim_flags_t TIFR0;
+sim_flags_t TIFR1;
+sim_flags_t TIFR2;
+
+/* ---- Clocks ---- */
+
+static uint64_t wall_cycles = 0;
+static uint64_t awake_cycles = 0;
+static uint64_t wake_start = 0;		/* Awake clock at the last wake-up */
+static uint64_t wdt_deadline = SIM_NEVER;	/* Wall clock */
+static uint8_t wdt_timeout = 0;
+static uint8_t in_isr = 0;
+
+/* Timer 1 clock select, the external clock isn't used */
+static const uint16_t t1_prescaler[8] = { 0, 1, 8, 64, 256, 1024, 0, 0 };
+static uint64_t t1_rest = 0;		/* Cycles toward the next tick */
+
+extern "C" void TIMER1_COMPA_vect(void) __attribute__((weak));
+extern "C" void TIMER1_OVF_vect(void) __attribute__((weak));
+
+static void (*int_handler[2])(void) = { NULL, NULL };
+
+/* ---- Pins ---- */
+
+static uint8_t pin_dir[HAL_PIN_COUNT];
+static uint8_t pin_latch[HAL_PIN_COUNT];
+static uint64_t pin_changed[HAL_PIN_COUNT];
+static uint8_t analog_ref = DEFAULT;
+
+/* ---- EEPROM, erased ---- */
+
+static struct hal_eeprom_t {
+	uint8_t data[E2END + 1];
+	hal_eeprom_t() { memset(data, 0xFF, sizeof(data)); }
+} eeprom;
+
+
+uint8_t hal_clock_shift(void){
+	uint8_t shift = CLKPR & 0x0F;
+	return shift > 8 ? 8 : shift;
+}
+
+/** @brief	Cycles of a timer 1 tick, 0 when it is stopped.
+ *
+ */
+static uint64_t _t1_period(void){
+	if (PRR & _BV(PRTIM1)){
+		return 0;
+	}
+	return (uint64_t)t1_prescaler[TCCR1B & 0x07] << hal_clock_shift();
+}
+
+/** @brief	TOP of the waveform mode. The phase correct modes set
+ *			by init() count up only here, no interrupt is enabled
+ *			with them.
+ *
+ */
+static uint16_t _t1_top(void){
+	uint8_t wgm = (((TCCR1B >> WGM12) & 0x03) << 2) | (TCCR1A & 0x03);
+	switch (wgm){
+	case 1: case 5:
+		return 0x00FF;
+	case 2: case 6:
+		return 0x01FF;
+	case 3: case 7:
+		return 0x03FF;
+	case 4:
+		return OCR1A;
+	case 12:
+		return ICR1;
+	default:
+		return 0xFFFF;
+	}
+}
+
+/** @brief	Flag raised when the counter wraps from TOP to 0.
+ *
+ */
+static uint8_t _t1_wrap_flag(void){
+	uint8_t wgm = (((TCCR1B >> WGM12) & 0x03) << 2) | (TCCR1A & 0x03);
+	if (wgm == 4){
+		return _BV(OCF1A);
+	}
+	if (wgm == 12){
+		return _BV(ICF1);
+	}
+	return _BV(TOV1);
+}
+
+/** @brief	Cycles until timer 1 wraps.
+ *
+ */
+static uint64_t _t1_to_wrap(void){
+	uint64_t period = _t1_period();
+	if (period == 0){
+		return SIM_NEVER;
+	}
+	uint16_t top = _t1_top();
+	uint32_t ticks = (TCNT1 <= top) ? (uint32_t)(top - TCNT1) + 1 : 0x10000UL - TCNT1;
+	uint64_t cycles = ticks * period;
+	return cycles > t1_rest ? cycles - t1_rest : 1;
+}
+
+/** @brief	Counts timer 1 for some cycles, at most until it wraps.
+ *
+ */
+static void _t1_run(uint64_t cycles){
+	uint64_t period = _t1_period();
+	if (period == 0){
+		return;
+	}
+	t1_rest += cycles;
+	uint32_t ticks = (uint32_t)(t1_rest / period);
+	t1_rest %= period;
+	uint16_t top = _t1_top();
+	uint32_t count = (uint32_t)TCNT1 + ticks;
+	uint32_t wrap = (TCNT1 <= top) ? (uint32_t)top + 1 : 0x10000UL;
+	if (count >= wrap){
+		count -= wrap;
+		TIFR1.raise(_t1_wrap_flag());
+	}
+	TCNT1 = (uint16_t)count;
+}
+
+static void _check_deadlines(void){
+	if (wall_cycles >= wdt_deadline){
+		sim_fatal("watchdog reset, WDTO %u expired", wdt_timeout);
+	}
+	if (awake_cycles - wake_start > (uint64_t)HAL_HANG_S * SIM_CYCLES_S){
+		sim_fatal("awake for %d s without sleeping, the firmware hangs", HAL_HANG_S);
+	}
+}
+
+void hal_advance(uint64_t cycles){
+	while (cycles){
+		uint64_t step = _t1_to_wrap();
+		if (step > cycles){
+			step = cycles;
+		}
+		_t1_run(step);
+		wall_cycles += step;
+		awake_cycles += step;
+		cycles -= step;
+		_check_deadlines();
+		hal_dispatch();
+	}
+}
+
+static void _isr(void (*isr)(void)){
+	if (isr == NULL){
+		return;
+	}
+	in_isr = 1;
+	SREG &= ~_BV(SREG_I);
+	isr();
+	SREG |= _BV(SREG_I);
+	in_isr = 0;
+}
+
+/** @brief	Level of the INT1 pin, the RTC alarm output.
+ *
+ */
+static uint8_t _int1_level(void){
+	if (pin_dir[SIM_PIN_RTC_INT]){
+		return pin_latch[SIM_PIN_RTC_INT];
+	}
+	return sim_rtc_int_line();
+}
+
+void hal_dispatch(void){
+	if (in_isr || !(SREG & _BV(SREG_I))){
+		return;
+	}
+	// Only the low level is modeled, it is the one that wakes up from power-down.
+	if ((EIMSK & _BV(INT1)) && int_handler[1] != NULL && ((EICRA >> ISC10) & 0x03) == LOW && !_int1_level()){
+		_isr(int_handler[1]);
+	}
+	for (;;){
+		uint8_t pending = TIFR1 & TIMSK1;
+		if (pending & _BV(OCF1A)){
+			TIFR1 = _BV(OCF1A);
+			_isr(TIMER1_COMPA_vect);
+		}
+		else if (pending & _BV(TOV1)){
+			TIFR1 = _BV(TOV1);
+			_isr(TIMER1_OVF_vect);
+		}
+		else {
+			break;
+		}
+	}
+}
+
+uint64_t sim_cycles(void){
+	return wall_cycles;
+}
+
+uint64_t sim_awake_cycles(void){
+	return awake_cycles;
+}
+
+extern "C" void sim_sei(void){
+	SREG |= _BV(SREG_I);
+	hal_dispatch();
+}
+
+extern "C" void sim_cli(void){
+	SREG &= ~_BV(SREG_I);
+}
+
+extern "C" void sim_delay_cycles(uint32_t cycles){
+	hal_advance((uint64_t)cycles << hal_clock_shift());
+}
+
+/* ---- wiring.c ---- */
+
+void init(void){
+	sei();
+
+	TCCR0A |= _BV(WGM01) | _BV(WGM00);
+	TCCR0B |= _BV(CS01) | _BV(CS00);
+	TIMSK0 |= _BV(TOIE0);
+
+	TCCR1B = _BV(CS11) | _BV(CS10);
+	TCCR1A |= _BV(WGM10);
+
+	TCCR2B |= _BV(CS22);
+	TCCR2A |= _BV(WGM20);
+
+	ADCSRA = _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0) | _BV(ADEN);
+
+	UCSR0B = 0;
+	MCUSR = _BV(PORF);
+}
+
+extern "C" void timer0_set_clock_shift(unsigned char shift){
+	// millis() and micros() read the virtual clock, they don't drift.
+	(void)shift;
+}
+
+void yield(void){
+}
+
+/* The clocks advance by 1 us per call, so that a polling loop
+   ends without a delay in it. The awake clock is the time timer 0
+   counts, it is compensated for the clock division. */
+unsigned long millis(void){
+	hal_advance(SIM_CYCLES_US);
+	return (uint32_t)(awake_cycles / SIM_CYCLES_MS);
+}
+
+unsigned long micros(void){
+	hal_advance(SIM_CYCLES_US);
+	return (uint32_t)(awake_cycles / SIM_CYCLES_US);
+}
+
+void delay(unsigned long ms){
+	hal_advance((uint64_t)ms * SIM_CYCLES_MS);
+}
+
+void delayMicroseconds(unsigned int us){
+	// Busy loop tuned for F_CPU, it lasts longer with the clock divided.
+	hal_advance(((uint64_t)us * SIM_CYCLES_US) << hal_clock_shift());
+}
+
+/* ---- wiring_digital.c ---- */
+
+static uint8_t _pin_level(uint8_t pin){
+	if (pin_dir[pin]){
+		return pin_latch[pin];
+	}
+	// Released : the pull-ups of the card and the boards
+	return 1;
+}
+
+static void _pin_update(uint8_t pin, uint8_t before){
+	uint8_t level = _pin_level(pin);
+	if (level == before){
+		return;
+	}
+	pin_changed[pin] = wall_cycles;
+	if (pin == SIM_PIN_SD_CS){
+		sim_sd_select(!level);
+	}
+}
+
+void pinMode(uint8_t pin, uint8_t mode){
+	if (pin >= HAL_PIN_COUNT){
+		return;
+	}
+	uint8_t before = _pin_level(pin);
+	if (mode == OUTPUT){
+		pin_dir[pin] = 1;
+	}
+	else {
+		pin_dir[pin] = 0;
+		pin_latch[pin] = (mode == INPUT_PULLUP);
+	}
+	_pin_update(pin, before);
+}
+
+void digitalWrite(uint8_t pin, uint8_t val){
+	if (pin >= HAL_PIN_COUNT){
+		return;
+	}
+	uint8_t before = _pin_level(pin);
+	pin_latch[pin] = (val != LOW);
+	_pin_update(pin, before);
+}
+
+int digitalRead(uint8_t pin){
+	if (pin >= HAL_PIN_COUNT){
+		return LOW;
+	}
+	if (pin_dir[pin]){
+		return pin_latch[pin];
+	}
+	if (pin == SIM_PIN_RTC_INT){
+		return sim_rtc_int_line();
+	}
+	if (pin == SIM_PIN_SDA || pin == SIM_PIN_SCL){
+		return sim_i2c_line(pin);
+	}
+	return pin_latch[pin];
+}
+
+int sim_pin_output(uint8_t pin){
+	if (pin >= HAL_PIN_COUNT || !pin_dir[pin]){
+		return -1;
+	}
+	return pin_latch[pin];
+}
+
+uint64_t sim_pin_changed_at(uint8_t pin){
+	return pin < HAL_PIN_COUNT ? pin_changed[pin] : 0;
+}
+
+/* ---- wiring_analog.c ---- */
+
+void analogReference(uint8_t mode){
+	analog_ref = mode;
+}
+
+int analogRead(uint8_t pin){
+	if (pin >= 14){
+		pin -= 14;
+	}
+	ADMUX = (analog_ref << 6) | (pin & 0x07);
+	ADCSRA |= _BV(ADSC);
+	while (bit_is_set(ADCSRA, ADSC));
+	return ADC;
+}
+
+void analogWrite(uint8_t pin, int val){
+	pinMode(pin, OUTPUT);
+	digitalWrite(pin, val < 128 ? LOW : HIGH);
+}
+
+/** @brief	A conversion takes 13 ADC clocks, 25 for the first
+ *			one after the ADC is enabled.
+ *
+ */
+sim_adcsra_t& sim_adcsra_t::operator=(uint8_t v){
+	uint8_t enabled = value & _BV(ADEN);
+	value = v & ~_BV(ADSC);
+	if (!(v & _BV(ADSC))){
+		return *this;
+	}
+	if (!(v & _BV(ADEN)) || (PRR & _BV(PRADC))){
+		sim_warn("ADC conversion started with the ADC %s", (PRR & _BV(PRADC)) ? "gated (PRR)" : "disabled");
+		return *this;
+	}
+	static const uint8_t division[8] = { 2, 2, 4, 8, 16, 32, 64, 128 };
+	uint64_t clocks = enabled ? 13 : 25;
+	hal_advance((clocks * division[v & 0x07]) << hal_clock_shift());
+
+	uint8_t mux = ADMUX & 0x0F;
+	if (mux == 0x0E){
+		ADC = sim_adc_sample(SIM_ADC_BANDGAP);
+	}
+	else if (mux < 8){
+		ADC = sim_adc_sample(mux);
+	}
+	else {
+		ADC = 0;
+	}
+	value |= _BV(ADIF);
+	return *this;
+}
+
+/* ---- WInterrupts.c ---- */
+
+void attachInterrupt(uint8_t interruptNum, void (*userFunc)(void), int mode){
+	if (interruptNum > 1){
+		return;
+	}
+	int_handler[interruptNum] = userFunc;
+	EICRA = (EICRA & ~(0x03 << (interruptNum * 2))) | ((mode & 0x03) << (interruptNum * 2));
+	EIMSK |= _BV(interruptNum);
+}
+
+void detachInterrupt(uint8_t interruptNum){
+	if (interruptNum > 1){
+		return;
+	}
+	EIMSK &= ~_BV(interruptNum);
+	int_handler[interruptNum] = NULL;
+}
+
+/* ---- avr/sleep.h ---- */
+
+extern "C" void sim_sleep_cpu(void){
+	if (!(SMCR & _BV(SE))){
+		// The wake-up interrupt came before, sleep_disable() in it.
+		return;
+	}
+	if ((SMCR & (_BV(SM2) | _BV(SM1) | _BV(SM0))) != SLEEP_MODE_PWR_DOWN){
+		sim_warn("sleep mode 0x%02X, only power-down is modeled", SMCR & 0x0E);
+	}
+	sim_sleep();
+
+	if (!(SREG & _BV(SREG_I))){
+		sim_fatal("sleep with the interrupts disabled, the station never wakes up");
+	}
+	if (!(EIMSK & _BV(INT1)) || int_handler[1] == NULL || ((EICRA >> ISC10) & 0x03) != LOW){
+		sim_fatal("sleep without the RTC level interrupt, the station never wakes up");
+	}
+	uint64_t at = sim_rtc_next_int();
+	if (at == SIM_NEVER){
+		sim_fatal("sleep without an RTC alarm armed, the station never wakes up");
+	}
+	if (at < wall_cycles){
+		at = wall_cycles;
+	}
+	if (at >= wdt_deadline){
+		wall_cycles = wdt_deadline;
+		sim_fatal("watchdog reset during the sleep, WDTO %u", wdt_timeout);
+	}
+
+	// Power-down : timer 1 and the awake clock are stopped.
+	uint64_t slept = at - wall_cycles;
+	wall_cycles = at;
+	wake_start = awake_cycles;
+	sim_wake(slept);
+	hal_dispatch();
+}
+
+/* ---- avr/wdt.h ---- */
+
+extern "C" void sim_wdt_enable(uint8_t timeout){
+	wdt_timeout = timeout;
+	WDTCSR = _BV(WDE) | (timeout & 0x07) | ((timeout & 0x08) ? _BV(WDP3) : 0);
+	sim_wdt_reset();
+}
+
+extern "C" void sim_wdt_reset(void){
+	if (!(WDTCSR & _BV(WDE))){
+		return;
+	}
+	// 2K cycles of the 128 kHz oscillator, doubled per step : 16 ms to 8 s
+	wdt_deadline = wall_cycles + ((uint64_t)16 * SIM_CYCLES_MS << wdt_timeout);
+}
+
+extern "C" void sim_wdt_disable(void){
+	WDTCSR = 0;
+	wdt_deadline = SIM_NEVER;
+}
+
+/* ---- avr/eeprom.h ---- */
+
+static int _eeprom_index(const void* addr){
+	uintptr_t i = (uintptr_t)addr;
+	if (i > E2END){
+		sim_warn("EEPROM access at 0x%lX, past E2END", (unsigned long)i);
+		return -1;
+	}
+	return (int)i;
+}
+
+static void _eeprom_program(const void* addr, uint8_t value, uint8_t update){
+	int i = _eeprom_index(addr);
+	if (i < 0 || (update && eeprom.data[i] == value)){
+		return;
+	}
+	hal_advance(HAL_EEPROM_WRITE_CYCLES);
+	eeprom.data[i] = value;
+}
+
+extern "C" uint8_t eeprom_read_byte(const uint8_t* addr){
+	int i = _eeprom_index(addr);
+	return i < 0 ? 0xFF : eeprom.data[i];
+}
+
+extern "C" uint16_t eeprom_read_word(const uint16_t* addr){
+	uint16_t v;
+	eeprom_read_block(&v, addr, sizeof(v));
+	return v;
+}
+
+extern "C" uint32_t eeprom_read_dword(const uint32_t* addr){
+	uint32_t v;
+	eeprom_read_block(&v, addr, sizeof(v));
+	return v;
+}
+
+extern "C" void eeprom_read_block(void* dst, const void* src, size_t n){
+	for (size_t i = 0; i < n; i++){
+		((uint8_t*)dst)[i] = eeprom_read_byte((const uint8_t*)src + i);
+	}
+}
+
+extern "C" void eeprom_write_byte(uint8_t* addr, uint8_t value){
+	_eeprom_program(addr, value, 0);
+}
+
+extern "C" void eeprom_write_word(uint16_t* addr, uint16_t value){
+	eeprom_write_block(&value, addr, sizeof(value));
+}
+
+extern "C" void eeprom_write_dword(uint32_t* addr, uint32_t value){
+	eeprom_write_block(&value, addr, sizeof(value));
+}
+
+extern "C" void eeprom_write_block(const void* src, void* dst, size_t n){
+	for (size_t i = 0; i < n; i++){
+		_eeprom_program((uint8_t*)dst + i, ((const uint8_t*)src)[i], 0);
+	}
+}
+
+extern "C" void eeprom_update_byte(uint8_t* addr, uint8_t value){
+	_eeprom_program(addr, value, 1);
+}
+
+extern "C" void eeprom_update_word(uint16_t* addr, uint16_t value){
+	eeprom_update_block(&value, addr, sizeof(value));
+}
+
+extern "C" void eeprom_update_dword(uint32_t* addr, uint32_t value){
+	eeprom_update_block(&value, addr, sizeof(value));
+}
+
+extern "C" void eeprom_update_block(const void* src, void* dst, size_t n){
+	for (size_t i = 0; i < n; i++){
+		_eeprom_program((uint8_t*)dst + i, ((const uint8_t*)src)[i], 1);
+	}
+}
+
+/* ---- avr-libc stdlib.h ---- */
+
+/* The host int and long are wider than on the AVR, the values are
+   converted at their host width. */
+extern "C" char* ultoa(unsigned long value, char* s, int radix){
+	char tmp[65];
+	int n = 0;
+	do {
+		uint8_t d = value % radix;
+		tmp[n++] = d < 10 ? '0' + d : 'a' + d - 10;
+		value /= radix;
+	} while (value);
+	for (int i = 0; i < n; i++){
+		s[i] = tmp[n - 1 - i];
+	}
+	s[n] = '\0';
+	return s;
+}
+
+extern "C" char* ltoa(long value, char* s, int radix){
+	if (value < 0 && radix == 10){
+		s[0] = '-';
+		ultoa(-(unsigned long)value, s + 1, radix);
+		return s;
+	}
+	return ultoa((unsigned long)value, s, radix);
+}
+
+extern "C" char* utoa(unsigned int value, char* s, int radix){
+	return ultoa(value, s, radix);
+}
+
+extern "C" char* itoa(int value, char* s, int radix){
+	return ltoa(value, s, radix);
+}
+
+extern "C" char* dtostrf(double value, signed char width, unsigned char prec, char* s){
+	sprintf(s, "%*.*f", width, prec, value);
+	return s;
+}
@@ -0,0 +1,100 @@
+/*
+ * hal_serial.cpp
+ *
+ * Created: 2026-10-19 10:04:48 PM
+ *  Author: Alexis Laframboise
+ *
+ *	USART 0 of the simulator, it replaces HardwareSerial*.cpp.
+ *	The bytes are sent at the baud rate of the UBRR setting : a
+ *	write blocks while the 64 bytes buffer is full and flush()
+ *	waits for the last byte, as on the station.
+ */
+
+#include <Arduino.h>
+#include <HardwareSerial_private.h>	/* Constructor and receive interrupt */
+
+#include "hal.h"
+#include "sim.h"
+
+static uint64_t byte_cycles = 0;	/* Start, 8 data and stop bits */
+static uint64_t idle_at = 0;		/* Awake clock when the last byte is out */
+
+
+void HardwareSerial::begin(unsigned long baud, uint8_t config){
+	// Same UBRR rounding as HardwareSerial.cpp, double speed first
+	uint16_t baud_setting = (F_CPU / 4 / baud - 1) / 2;
+	uint8_t u2x = 1;
+	if (((F_CPU == 16000000UL) && (baud == 57600)) || (baud_setting > 4095)){
+		u2x = 0;
+		baud_setting = (F_CPU / 8 / baud - 1) / 2;
+	}
+	*_ucsra = u2x ? _BV(U2X0) : 0;
+	*_ubrrh = baud_setting >> 8;
+	*_ubrrl = baud_setting;
+	*_ucsrc = config;
+	*_ucsrb |= _BV(RXEN0) | _BV(TXEN0) | _BV(RXCIE0);
+	*_ucsrb &= ~_BV(UDRIE0);
+
+	byte_cycles = (uint64_t)10 * (u2x ? 8 : 16) * (baud_setting + 1);
+	_written = false;
+}
+
+void HardwareSerial::end(){
+	flush();
+	*_ucsrb &= ~(_BV(RXEN0) | _BV(TXEN0) | _BV(RXCIE0) | _BV(UDRIE0));
+}
+
+int HardwareSerial::available(void){
+	return 0;
+}
+
+int HardwareSerial::peek(void){
+	return -1;
+}
+
+int HardwareSerial::read(void){
+	return -1;
+}
+
+int HardwareSerial::availableForWrite(void){
+	uint64_t now = sim_awake_cycles();
+	uint64_t queued = (idle_at > now && byte_cycles) ? (idle_at - now + byte_cycles - 1) / byte_cycles : 0;
+	return queued >= SERIAL_TX_BUFFER_SIZE - 1 ? 0 : SERIAL_TX_BUFFER_SIZE - 1 - (int)queued;
+}
+
+void HardwareSerial::flush(){
+	if (!_written){
+		return;
+	}
+	uint64_t now = sim_awake_cycles();
+	if (idle_at > now){
+		hal_advance(idle_at - now);
+	}
+}
+
+size_t HardwareSerial::write(uint8_t c){
+	_written = true;
+	if (!(*_ucsrb & _BV(TXEN0)) || (PRR & _BV(PRUSART0))){
+		sim_warn("serial write with the USART %s", (PRR & _BV(PRUSART0)) ? "gated (PRR)" : "disabled");
+		return 1;
+	}
+	if (hal_clock_shift() != 0){
+		sim_warn("serial write with the clock divided, the baud rate is wrong");
+	}
+
+	uint64_t now = sim_awake_cycles();
+	idle_at = (idle_at > now ? idle_at : now) + byte_cycles;
+
+	// The buffer holds SERIAL_TX_BUFFER_SIZE - 1 bytes, one more is in UDR.
+	uint64_t room = (uint64_t)SERIAL_TX_BUFFER_SIZE * byte_cycles;
+	if (idle_at > now + room){
+		hal_advance(idle_at - now - room);
+	}
+	sim_serial_out(c);
+	return 1;
+}
+
+void HardwareSerial::_tx_udr_empty_irq(void){
+}
+
+HardwareSerial Serial(&UBRR0H, &UBRR0L, &UCSR0A, &UCSR0B, &UCSR0C, &UDR0);
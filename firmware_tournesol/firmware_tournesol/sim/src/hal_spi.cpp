@@ -0,0 +1,114 @@
+/*
+ * hal_spi.cpp
+ *
+ * Created: 2026-10-19 10:09:23 PM
+ *  Author: Alexis Laframboise
+ *
+ *	SPI master of the simulator, it replaces SPI.cpp (the port
+ *	tables of pins_arduino.h hold 16 bits addresses). Writing
+ *	SPDR shifts a byte with the SD card model, at the SCK rate
+ *	of SPCR and SPSR.
+ */
+
+#include <Arduino.h>
+#include <SPI.h>
+
+#include "hal.h"
+#include "sim.h"
+
+SPIClass SPI;
+
+uint8_t SPIClass::initialized = 0;
+uint8_t SPIClass::interruptMode = 0;
+uint8_t SPIClass::interruptMask = 0;
+uint8_t SPIClass::interruptSave = 0;
+#ifdef SPI_TRANSACTION_MISMATCH_LED
+uint8_t SPIClass::inTransactionFlag = 0;
+#endif
+
+sim_spdr_t SPDR;
+
+static uint8_t spi_in = 0xFF;
+
+
+void SPIClass::begin(){
+	uint8_t sreg = SREG;
+	noInterrupts();
+	if (!initialized){
+		if (sim_pin_output(SS) < 0){
+			digitalWrite(SS, HIGH);
+		}
+		pinMode(SS, OUTPUT);
+		SPCR |= _BV(MSTR);
+		SPCR |= _BV(SPE);
+		pinMode(SCK, OUTPUT);
+		pinMode(MOSI, OUTPUT);
+	}
+	initialized++;
+	SREG = sreg;
+}
+
+void SPIClass::end(){
+	uint8_t sreg = SREG;
+	noInterrupts();
+	if (initialized){
+		initialized--;
+	}
+	if (!initialized){
+		SPCR &= ~_BV(SPE);
+		interruptMode = 0;
+	}
+	SREG = sreg;
+}
+
+void SPIClass::usingInterrupt(uint8_t interruptNumber){
+	uint8_t sreg = SREG;
+	noInterrupts();
+	if (interruptNumber <= 1){
+		interruptMask |= _BV(interruptNumber);
+		if (!interruptMode){
+			interruptMode = 1;
+		}
+	}
+	else {
+		interruptMode = 2;
+	}
+	SREG = sreg;
+}
+
+void SPIClass::notUsingInterrupt(uint8_t interruptNumber){
+	if (interruptMode == 2){
+		return;
+	}
+	uint8_t sreg = SREG;
+	noInterrupts();
+	if (interruptNumber <= 1){
+		interruptMask &= ~_BV(interruptNumber);
+	}
+	if (!interruptMask){
+		interruptMode = 0;
+	}
+	SREG = sreg;
+}
+
+sim_spdr_t& sim_spdr_t::operator=(uint8_t out){
+	if (!(SPCR & _BV(SPE)) || (PRR & _BV(PRSPI))){
+		sim_warn("SPI transfer with the SPI %s", (PRR & _BV(PRSPI)) ? "gated (PRR)" : "disabled");
+		spi_in = 0xFF;
+		SPSR |= _BV(SPIF);
+		return *this;
+	}
+	// SCK = F_CPU / 4, 16, 64 or 128, twice faster with SPI2X
+	static const uint8_t division[4] = { 4, 16, 64, 128 };
+	uint64_t sck = division[SPCR & 0x03] >> (SPSR & _BV(SPI2X) ? 1 : 0);
+	hal_advance((8 * sck) << hal_clock_shift());
+
+	spi_in = sim_sd_transfer(out);
+	SPSR |= _BV(SPIF);
+	return *this;
+}
+
+sim_spdr_t::operator uint8_t() const {
+	SPSR &= ~_BV(SPIF);
+	return spi_in;
+}
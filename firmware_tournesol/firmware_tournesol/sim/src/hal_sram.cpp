@@ -0,0 +1,129 @@
+/*
+ * hal_sram.cpp
+ *
+ * Created: 2026-10-19 10:17:55 PM
+ *  Author: Alexis Laframboise
+ *
+ *	SRAM report of the simulator, it replaces sram.cpp (AVR
+ *	assembly and linker symbols). The host memory says nothing
+ *	about the 2 KB of the station, so the stack and free marks
+ *	are 0 : the logs stay the same from one host to another.
+ *
+ *	The heap is checked : the Makefile renames malloc(), new
+ *	and their kin in the firmware objects to the sim_fw_*
+ *	functions below, every allocation of the firmware (and
+ *	only of the firmware) is accounted and reported to the
+ *	simulator, which warns past the setup.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "sram.h"
+#include "config.h"
+#include "sim.h"
+
+/* Size of the allocation, ahead of the block (aligned like malloc) */
+#define HEAP_HEADER_BYTES	(16)
+
+static uint32_t heap_bytes = 0;		/* In use */
+static uint32_t heap_high = 0;
+
+
+static void* _heap_take(void* block, size_t size){
+	if (block == NULL){
+		return NULL;
+	}
+	memcpy(block, &size, sizeof(size));
+	heap_bytes += size;
+	if (heap_bytes > heap_high){
+		heap_high = heap_bytes;
+	}
+	sim_heap_alloc((uint32_t)size);
+	return (uint8_t*)block + HEAP_HEADER_BYTES;
+}
+
+static void* _heap_give(void* ptr){
+	size_t size;
+	uint8_t* block = (uint8_t*)ptr - HEAP_HEADER_BYTES;
+
+	memcpy(&size, block, sizeof(size));
+	heap_bytes -= size;
+	return block;
+}
+
+extern "C" void* sim_fw_malloc(size_t size){
+	return _heap_take(malloc(HEAP_HEADER_BYTES + size), size);
+}
+
+extern "C" void* sim_fw_calloc(size_t count, size_t size){
+	return _heap_take(calloc(1, HEAP_HEADER_BYTES + count * size), count * size);
+}
+
+extern "C" void sim_fw_free(void* ptr){
+	if (ptr != NULL){
+		free(_heap_give(ptr));
+	}
+}
+
+extern "C" void* sim_fw_realloc(void* ptr, size_t size){
+	if (ptr == NULL){
+		return sim_fw_malloc(size);
+	}
+	void* block = _heap_give(ptr);
+	void* grown = realloc(block, HEAP_HEADER_BYTES + size);
+	if (grown == NULL){
+		size_t kept;
+		memcpy(&kept, block, sizeof(kept));
+		heap_bytes += kept;		// The block is left as is
+		return NULL;
+	}
+	return _heap_take(grown, size);
+}
+
+/* operator new / new[] and delete / delete[], sized or not */
+extern "C" void* sim_fw_new(size_t size){
+	return sim_fw_malloc(size ? size : 1);
+}
+
+extern "C" void* sim_fw_new_array(size_t size){
+	return sim_fw_new(size);
+}
+
+extern "C" void sim_fw_delete(void* ptr){
+	sim_fw_free(ptr);
+}
+
+extern "C" void sim_fw_delete_array(void* ptr){
+	sim_fw_free(ptr);
+}
+
+extern "C" void sim_fw_delete_sized(void* ptr, size_t){
+	sim_fw_free(ptr);
+}
+
+extern "C" void sim_fw_delete_array_sized(void* ptr, size_t){
+	sim_fw_free(ptr);
+}
+
+uint16_t sram_heap_high(void){
+	return (heap_high < 0xFFFF) ? (uint16_t)heap_high : 0xFFFF;
+}
+
+uint16_t sram_stack_high(void){
+	return 0;
+}
+
+uint16_t sram_free_low(void){
+	return 0;
+}
+
+void sram_dump(void){
+#if SERIAL_EN
+	Serial.print("SRAM (B) data: "); Serial.print(0);
+	Serial.print(", bss: "); Serial.print(0);
+	Serial.print(", heap: "); Serial.print(sram_heap_high());
+	Serial.print(", stack: "); Serial.print(sram_stack_high());
+	Serial.print(", free: "); Serial.println(sram_free_low());
+#endif
+}
@@ -0,0 +1,149 @@
+/*
+ * hal_twi.cpp
+ *
+ * Created: 2026-10-19 10:13:40 PM
+ *  Author: Alexis Laframboise
+ *
+ *	TWI master of the simulator, it replaces twi.c under Wire.
+ *	A transfer takes 9 SCL clocks per byte, address included, and
+ *	goes to the I2C models. With the TWI off or gated, the transfer
+ *	times out like on the station and the timeout flag is set.
+ */
+
+#include <Arduino.h>
+
+extern "C" {
+#include "utility/twi.h"
+}
+
+#include "hal.h"
+#include "sim.h"
+
+static uint8_t twi_on = 0;
+static uint32_t twi_freq = TWI_FREQ;
+static uint32_t twi_timeout_us = 0;
+static bool twi_timeout_reset = false;
+static bool twi_timed_out = false;
+
+
+/** @brief	Bus time of a transfer, START and STOP included.
+ *
+ */
+static void _twi_transfer_time(uint8_t bytes){
+	uint64_t clocks = 9 * ((uint64_t)bytes + 1) + 2;
+	// TWBR is set for F_CPU, SCL is divided with the clock.
+	hal_advance((clocks * SIM_F_CPU / twi_freq) << hal_clock_shift());
+}
+
+/** @brief	Checks the TWI can run, times out otherwise.
+ *
+ */
+static uint8_t _twi_ready(void){
+	if (twi_on && !(PRR & _BV(PRTWI))){
+		return 1;
+	}
+	sim_warn("TWI transfer with the TWI %s", (PRR & _BV(PRTWI)) ? "gated (PRR)" : "disabled");
+	if (twi_timeout_us == 0){
+		sim_fatal("TWI transfer without a timeout, the firmware hangs");
+	}
+	hal_advance((uint64_t)twi_timeout_us * SIM_CYCLES_US);
+	twi_handleTimeout(twi_timeout_reset);
+	return 0;
+}
+
+void twi_init(void){
+	twi_on = 1;
+	// Internal pull-ups, as twi.c
+	digitalWrite(SDA, 1);
+	digitalWrite(SCL, 1);
+	TWSR &= ~(_BV(TWPS0) | _BV(TWPS1));
+	TWBR = ((F_CPU / twi_freq) - 16) / 2;
+	TWCR = _BV(TWEN) | _BV(TWIE) | _BV(TWEA);
+}
+
+void twi_disable(void){
+	twi_on = 0;
+	TWCR &= ~(_BV(TWEN) | _BV(TWIE) | _BV(TWEA));
+	digitalWrite(SDA, 0);
+	digitalWrite(SCL, 0);
+}
+
+void twi_setAddress(uint8_t address){
+	TWAR = address << 1;
+}
+
+void twi_setFrequency(uint32_t frequency){
+	twi_freq = frequency;
+	TWBR = ((F_CPU / frequency) - 16) / 2;
+}
+
+uint8_t twi_readFrom(uint8_t address, uint8_t* data, uint8_t length, uint8_t sendStop){
+	(void)sendStop;
+	if (length > TWI_BUFFER_LENGTH || !_twi_ready()){
+		return 0;
+	}
+	uint8_t read = sim_i2c_read(address, data, length);
+	_twi_transfer_time(read);
+	return read;
+}
+
+uint8_t twi_writeTo(uint8_t address, uint8_t* data, uint8_t length, uint8_t wait, uint8_t sendStop){
+	(void)wait;
+	(void)sendStop;
+	if (length > TWI_BUFFER_LENGTH){
+		return 1;
+	}
+	if (!_twi_ready()){
+		return 5;
+	}
+	uint8_t result = sim_i2c_write(address, data, length);
+	_twi_transfer_time(result == SIM_I2C_NACK_ADDR ? 0 : length);
+	return result;
+}
+
+uint8_t twi_transmit(const uint8_t* data, uint8_t length){
+	// Slave mode only, the station is the master.
+	(void)data;
+	(void)length;
+	return 1;
+}
+
+void twi_attachSlaveRxEvent(void (*function)(uint8_t*, int)){
+	(void)function;
+}
+
+void twi_attachSlaveTxEvent(void (*function)(void)){
+	(void)function;
+}
+
+void twi_reply(uint8_t ack){
+	(void)ack;
+}
+
+void twi_stop(void){
+}
+
+void twi_releaseBus(void){
+}
+
+void twi_setTimeoutInMicros(uint32_t timeout, bool reset_with_timeout){
+	twi_timed_out = false;
+	twi_timeout_us = timeout;
+	twi_timeout_reset = reset_with_timeout;
+}
+
+void twi_handleTimeout(bool reset){
+	twi_timed_out = true;
+	if (reset && twi_on){
+		twi_disable();
+		twi_init();
+	}
+}
+
+bool twi_manageTimeoutFlag(bool clear_flag){
+	bool flag = twi_timed_out;
+	if (clear_flag){
+		twi_timed_out = false;
+	}
+	return flag;
+}
@@ -0,0 +1,43 @@
+/*
+ * model_analog.cpp
+ *
+ * Created: 2026-10-19 11:16:05 PM
+ *  Author: Alexis Laframboise
+ *
+ *	Analog inputs : the anemometer and the PT100 front-end give
+ *	the next count of their capture while their rail is on, and 0
+ *	otherwise (reported, the firmware must power them first). The
+ *	bandgap reads against the simulated supply.
+ */
+
+#include "models.h"
+
+static uint16_t vcc_mv = 5000;
+
+
+void analog_model_init(uint16_t supply_mv){
+	vcc_mv = supply_mv;
+}
+
+uint16_t sim_adc_sample(uint8_t channel){
+	sim_stack_mark();
+	switch (channel){
+	case SIM_ADC_ANEMOMETER:
+		// The 9V relay is on when its pin is low.
+		if (sim_powered_for(SIM_PIN_RELAY_9V, 0) == SIM_NEVER){
+			sim_warn("anemometer read with the 9V relay off");
+			return 0;
+		}
+		return replay_anemometer_next();
+	case SIM_ADC_PT100:
+		if (sim_powered_for(SIM_PIN_PT100_POWER, 1) == SIM_NEVER){
+			sim_warn("PT100 read with its front-end off");
+			return 0;
+		}
+		return replay_pt100_next();
+	case SIM_ADC_BANDGAP:
+		return (uint16_t)(1100UL * 1024UL / vcc_mv);
+	default:
+		return 0;
+	}
+}
@@ -0,0 +1,190 @@
+/*
+ * model_as7262.cpp
+ *
+ * Created: 2026-10-19 10:46:19 PM
+ *  Author: Alexis Laframboise
+ *
+ *	AS7262 model : the I2C slave registers (status, write, read)
+ *	in front of the virtual registers. A one-shot conversion
+ *	(BANK 3) lasts two integration periods, it takes the next
+ *	reading of Spectro_calib.txt when it completes. The calibrated
+ *	channels are the captured ones, the raw counts are scaled from
+ *	them by the gain and the integration time and saturate, so the
+ *	auto-ranging has something to chase.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "models.h"
+
+/* I2C slave registers */
+#define SLAVE_STATUS	(0x00)
+#define SLAVE_WRITE		(0x01)
+#define SLAVE_READ		(0x02)
+#define STATUS_RX_VALID	(1 << 0)
+
+/* Virtual registers */
+#define VREG_HW_VERSION	(0x00)
+#define VREG_FW_VERSION	(0x02)
+#define VREG_CONTROL	(0x04)
+#define VREG_INT_T		(0x05)
+#define VREG_DEVICE_TEMP (0x06)
+#define VREG_LED		(0x07)
+#define VREG_RAW		(0x08)
+#define VREG_CAL		(0x14)
+#define VREG_END		(0x2C)
+
+#define CONTROL_DATA_RDY (1 << 1)
+#define CONTROL_BANK(c)	(((c) >> 2) & 0x03)
+#define CONTROL_GAIN(c)	(((c) >> 4) & 0x03)
+#define CONTROL_RST		(1 << 7)
+#define CONTROL_DEFAULT	(0x28)		/* 16x, BANK 2 continuous */
+#define BANK_ONE_SHOT	(3)
+
+#define CYCLE_US		(2800)
+#define STARTUP_CYCLES	(50 * SIM_CYCLES_MS)
+
+/* Raw counts of a calibrated unit at 64x and 50 cycles, the capture
+   conditions. The bright capture gives 26k counts, 40 % of the scale. */
+#define RAW_PER_CAL		(40)
+
+static uint8_t vregs[VREG_END];
+static uint8_t pointer = 0;
+static uint8_t pending = 0;		/* Virtual address of a write, bit 7 set */
+static uint8_t read_data = 0;
+static uint8_t status = 0;
+static uint8_t converting = 0;
+static uint64_t ready_at = 0;
+static uint64_t powered_at = SIM_NEVER;
+
+
+static void _reset(void){
+	memset(vregs, 0, sizeof(vregs));
+	vregs[VREG_HW_VERSION] = 0x40;
+	vregs[VREG_HW_VERSION + 1] = 0x3E;
+	vregs[VREG_FW_VERSION] = 0x00;
+	vregs[VREG_FW_VERSION + 1] = 0x7C;
+	vregs[VREG_CONTROL] = CONTROL_DEFAULT;
+	vregs[VREG_INT_T] = 0xFF;
+	vregs[VREG_DEVICE_TEMP] = 25;
+	pending = 0;
+	status = 0;
+	converting = 0;
+}
+
+/** @brief	Data registers of a completed conversion.
+ *
+ */
+static void _complete(void){
+	static const uint16_t gain_x10[4] = { 10, 37, 160, 640 };
+	const float* cal = replay_spectro_next();
+	uint8_t gain = CONTROL_GAIN(vregs[VREG_CONTROL]);
+	uint8_t cycles = vregs[VREG_INT_T];
+
+	for (uint8_t i = 0; i < AS7262_CHANNELS; i++){
+		uint64_t c100 = (uint64_t)llroundf(cal[i] * 100.0f);
+		uint64_t raw = c100 * gain_x10[gain] * cycles * RAW_PER_CAL / (640UL * 50UL * 100UL);
+		if (raw > 0xFFFF){
+			raw = 0xFFFF;
+		}
+		vregs[VREG_RAW + 2 * i] = (uint8_t)(raw >> 8);
+		vregs[VREG_RAW + 2 * i + 1] = (uint8_t)raw;
+
+		uint32_t bits;
+		memcpy(&bits, &cal[i], sizeof(bits));
+		for (uint8_t b = 0; b < 4; b++){
+			vregs[VREG_CAL + 4 * i + b] = (uint8_t)(bits >> (24 - 8 * b));
+		}
+	}
+	vregs[VREG_CONTROL] |= CONTROL_DATA_RDY;
+	converting = 0;
+}
+
+static uint8_t _virtual_read(uint8_t addr){
+	if (converting && sim_cycles() >= ready_at){
+		_complete();
+	}
+	return addr < VREG_END ? vregs[addr] : 0;
+}
+
+static void _virtual_write(uint8_t addr, uint8_t value){
+	if (addr == VREG_CONTROL){
+		if (value & CONTROL_RST){
+			_reset();
+			return;
+		}
+		// DATA_RDY is cleared by writing 0, the BANK starts a conversion.
+		uint8_t rdy = vregs[VREG_CONTROL] & value & CONTROL_DATA_RDY;
+		vregs[VREG_CONTROL] = (value & ~CONTROL_DATA_RDY) | rdy;
+		if (CONTROL_BANK(value) == BANK_ONE_SHOT){
+			converting = 1;
+			ready_at = sim_cycles() + 2ULL * vregs[VREG_INT_T] * CYCLE_US * SIM_CYCLES_US;
+		}
+	}
+	else if (addr == VREG_INT_T || addr == VREG_LED || (addr >= 0x08 && addr < VREG_END)){
+		vregs[addr] = value;
+	}
+}
+
+static bool _powered(void){
+	uint64_t on = sim_powered_for(SIM_PIN_AS7262_POWER, 1);
+	if (on == SIM_NEVER){
+		powered_at = SIM_NEVER;
+		return false;
+	}
+	uint64_t at = sim_cycles() - on;
+	if (at != powered_at){
+		powered_at = at;
+		_reset();
+	}
+	return on >= STARTUP_CYCLES;
+}
+
+uint8_t as7262_model_write(const uint8_t* data, uint8_t len){
+	if (!_powered()){
+		return SIM_I2C_NACK_ADDR;
+	}
+	if (len == 0){
+		return SIM_I2C_OK;
+	}
+	pointer = data[0];
+	if (pointer != SLAVE_WRITE || len < 2){
+		return SIM_I2C_OK;
+	}
+	for (uint8_t i = 1; i < len; i++){
+		uint8_t v = data[i];
+		if (pending){
+			_virtual_write(pending & 0x7F, v);
+			pending = 0;
+		}
+		else if (v & 0x80){
+			pending = v;
+		}
+		else {
+			read_data = _virtual_read(v);
+			status |= STATUS_RX_VALID;
+		}
+	}
+	return SIM_I2C_OK;
+}
+
+uint8_t as7262_model_read(uint8_t* data, uint8_t len){
+	if (!_powered()){
+		return 0;
+	}
+	for (uint8_t i = 0; i < len; i++){
+		if (pointer == SLAVE_STATUS){
+			// The virtual writes are taken at once, TX_VALID stays clear.
+			data[i] = status;
+		}
+		else if (pointer == SLAVE_READ){
+			data[i] = read_data;
+			status &= ~STATUS_RX_VALID;
+		}
+		else {
+			data[i] = 0;
+		}
+	}
+	return len;
+}
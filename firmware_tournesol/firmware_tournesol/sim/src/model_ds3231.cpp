@@ -0,0 +1,326 @@
+/*
+ * model_ds3231.cpp
+ *
+ * Created: 2026-10-19 10:31:02 PM
+ *  Author: Alexis Laframboise
+ *
+ *	DS3231 model : the calendar counts the seconds of the wall
+ *	clock, the alarms match on the seconds (alarm 2 on second 00)
+ *	with the masks of the datasheet and raise their flags, the
+ *	INT/SQW output is low while an enabled flag is set with INTCN.
+ *	The flags are updated lazily, on each access, from the last
+ *	second checked : the next match is searched field by field,
+ *	so a sleep of days costs a few steps, and kept until it passes
+ *	or the alarm registers change.
+ */
+
+#include <string.h>
+
+#include "models.h"
+
+#define REG_SEC			(0x00)
+#define REG_DOW			(0x03)
+#define REG_ALARM1		(0x07)
+#define REG_ALARM2		(0x0B)
+#define REG_CONTROL		(0x0E)
+#define REG_STATUS		(0x0F)
+#define REG_AGING		(0x10)
+#define REG_TEMP_MSB	(0x11)
+#define REG_TEMP_LSB	(0x12)
+#define REG_COUNT		(0x13)
+
+#define CONTROL_A1IE	(1 << 0)
+#define CONTROL_A2IE	(1 << 1)
+#define CONTROL_INTCN	(1 << 2)
+#define STATUS_A1F		(1 << 0)
+#define STATUS_A2F		(1 << 1)
+#define STATUS_OSF		(1 << 7)
+
+#define ALARM_MASK		(1 << 7)
+#define ALARM_DY		(1 << 6)
+
+#define DAY_S			(86400UL)
+#define SEARCH_DAYS		(400)		/* A date alarm matches within a year */
+
+/* Calendar of the RTC, 2000 to 2099 */
+struct calendar_t {
+	uint16_t year;
+	uint8_t mon;		/* 1-12 */
+	uint8_t date;		/* 1-31 */
+	uint8_t dow;		/* 1-7, 2000-01-01 is 7 */
+	uint8_t hour;
+	uint8_t min;
+	uint8_t sec;
+};
+
+static uint8_t regs[REG_COUNT];
+static uint8_t pointer = 0;
+static uint32_t base_s = 0;			/* Calendar at base_cycles */
+static uint64_t base_cycles = 0;
+static uint32_t checked_s = 0;		/* Last second the alarms were matched */
+static uint32_t alarm_next[2];		/* Next match after checked_s, 0 : none */
+static uint32_t alarm_until = 0;	/* End of the search, alarm_next stale after */
+static uint8_t alarm_valid = 0;
+
+static const uint8_t days_in_month[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+
+static uint8_t _bcd2dec(uint8_t bcd){
+	return ((bcd >> 4) & 0x0F) * 10 + (bcd & 0x0F);
+}
+
+static uint8_t _dec2bcd(uint8_t dec){
+	return ((dec / 10) << 4) | (dec % 10);
+}
+
+static bool _leap(uint16_t year){
+	return (year % 4 == 0) && (year % 100 != 0 || year % 400 == 0);
+}
+
+static uint8_t _month_days(uint16_t year, uint8_t mon){
+	return days_in_month[mon - 1] + (mon == 2 && _leap(year));
+}
+
+static calendar_t _to_calendar(uint32_t s){
+	calendar_t c;
+	uint32_t days = s / DAY_S;
+	uint32_t rest = s % DAY_S;
+	c.dow = (days + 6) % 7 + 1;
+	c.year = 2000;
+	while (days >= (uint32_t)(_leap(c.year) ? 366 : 365)){
+		days -= _leap(c.year) ? 366 : 365;
+		c.year++;
+	}
+	c.mon = 1;
+	while (days >= _month_days(c.year, c.mon)){
+		days -= _month_days(c.year, c.mon);
+		c.mon++;
+	}
+	c.date = days + 1;
+	c.hour = rest / 3600;
+	c.min = rest / 60 % 60;
+	c.sec = rest % 60;
+	return c;
+}
+
+static uint32_t _to_seconds(const calendar_t& c){
+	uint32_t days = 0;
+	for (uint16_t y = 2000; y < c.year; y++){
+		days += _leap(y) ? 366 : 365;
+	}
+	for (uint8_t m = 1; m < c.mon; m++){
+		days += _month_days(c.year, m);
+	}
+	days += c.date - 1;
+	return days * DAY_S + c.hour * 3600UL + c.min * 60UL + c.sec;
+}
+
+static uint32_t _now(void){
+	return base_s + (uint32_t)((sim_cycles() - base_cycles) / SIM_CYCLES_S);
+}
+
+/** @brief	First second after a time that matches an alarm.
+ *
+ *  @param	alarm (0 or 1) and time
+ *  @return	seconds since 2000, 0 if it never matches
+ */
+static uint32_t _next_match(uint8_t alarm, uint32_t after){
+	const uint8_t* a = regs + (alarm ? REG_ALARM2 : REG_ALARM1);
+	// Alarm 2 has no seconds register, it matches on second 00.
+	bool sec_en = alarm ? true : !(a[0] & ALARM_MASK);
+	uint8_t sec = alarm ? 0 : _bcd2dec(a[0] & 0x7F);
+	const uint8_t* m = alarm ? a : a + 1;
+	bool min_en = !(m[0] & ALARM_MASK);
+	bool hour_en = !(m[1] & ALARM_MASK);
+	bool day_en = !(m[2] & ALARM_MASK);
+	uint8_t min = _bcd2dec(m[0] & 0x7F);
+	uint8_t hour = _bcd2dec(m[1] & 0x3F);
+	uint8_t day = _bcd2dec(m[2] & 0x3F);
+	bool dow = m[2] & ALARM_DY;
+
+	uint32_t t = after + 1;
+	while (t - after <= SEARCH_DAYS * DAY_S){
+		calendar_t c = _to_calendar(t);
+		uint32_t day_start = t - (t % DAY_S);
+		if (day_en && (dow ? c.dow : c.date) != day){
+			t = day_start + DAY_S;
+		}
+		else if (hour_en && c.hour != hour){
+			t = c.hour < hour ? day_start + hour * 3600UL : day_start + DAY_S;
+		}
+		else if (min_en && c.min != min){
+			uint32_t hour_start = t - (t % 3600);
+			t = c.min < min ? hour_start + min * 60UL : hour_start + 3600;
+		}
+		else if (sec_en && c.sec != sec){
+			uint32_t min_start = t - (t % 60);
+			t = c.sec < sec ? min_start + sec : min_start + 60;
+		}
+		else {
+			return t;
+		}
+	}
+	return 0;
+}
+
+/** @brief	Raises the flags of the alarms matched since the last
+ *			access.
+ *
+ */
+static void _search(uint32_t after){
+	for (uint8_t alarm = 0; alarm < 2; alarm++){
+		alarm_next[alarm] = _next_match(alarm, after);
+	}
+	alarm_until = after + SEARCH_DAYS * DAY_S;
+	alarm_valid = 1;
+}
+
+static void _update(void){
+	uint32_t now = _now();
+	if (!alarm_valid){
+		_search(checked_s);
+	}
+	if (now == checked_s){
+		return;
+	}
+	uint8_t passed = now >= alarm_until;
+	for (uint8_t alarm = 0; alarm < 2; alarm++){
+		uint32_t match = alarm_next[alarm];
+		if (match != 0 && match <= now){
+			regs[REG_STATUS] |= alarm ? STATUS_A2F : STATUS_A1F;
+			passed = 1;
+		}
+	}
+	checked_s = now;
+	if (passed){
+		_search(now);
+	}
+}
+
+/** @brief	Time keeping registers, from the calendar.
+ *
+ */
+static void _load_time(void){
+	calendar_t c = _to_calendar(_now());
+	regs[REG_SEC] = _dec2bcd(c.sec);
+	regs[REG_SEC + 1] = _dec2bcd(c.min);
+	regs[REG_SEC + 2] = _dec2bcd(c.hour);
+	regs[REG_DOW] = c.dow;
+	regs[REG_DOW + 1] = _dec2bcd(c.date);
+	regs[REG_DOW + 2] = _dec2bcd(c.mon);
+	regs[REG_DOW + 3] = _dec2bcd(c.year - 2000);
+}
+
+/** @brief	Sets a time keeping register, the countdown chain
+ *			restarts with the seconds.
+ *
+ */
+static void _store_time(uint8_t reg, uint8_t value){
+	calendar_t c = _to_calendar(_now());
+	switch (reg){
+	case 0: c.sec = _bcd2dec(value & 0x7F) % 60; break;
+	case 1: c.min = _bcd2dec(value & 0x7F) % 60; break;
+	case 2: c.hour = _bcd2dec(value & 0x3F) % 24; break;
+	case 3: return;		// Day of the week follows the date here
+	case 4: c.date = _bcd2dec(value & 0x3F); break;
+	case 5: c.mon = _bcd2dec(value & 0x1F); break;
+	case 6: c.year = 2000 + _bcd2dec(value); break;
+	}
+	if (c.mon < 1 || c.mon > 12){
+		c.mon = 1;
+	}
+	if (c.date < 1 || c.date > _month_days(c.year, c.mon)){
+		c.date = 1;
+	}
+	base_s = _to_seconds(c);
+	base_cycles = sim_cycles();
+	checked_s = base_s;
+	alarm_valid = 0;
+}
+
+void ds3231_model_init(uint32_t unix_time){
+	memset(regs, 0, sizeof(regs));
+	// Running on its battery since it was set : no oscillator stop.
+	regs[REG_CONTROL] = CONTROL_INTCN | (1 << 4) | (1 << 3);
+	regs[REG_STATUS] = 1 << 3;
+	regs[REG_TEMP_MSB] = 25;
+	base_s = unix_time - MODEL_YEAR_2000_S;
+	base_cycles = sim_cycles();
+	checked_s = base_s;
+	alarm_valid = 0;
+}
+
+uint32_t ds3231_model_now(void){
+	return _now();
+}
+
+uint8_t ds3231_model_write(const uint8_t* data, uint8_t len){
+	if (len == 0){
+		return SIM_I2C_OK;
+	}
+	_update();
+	pointer = data[0] % REG_COUNT;
+	for (uint8_t i = 1; i < len; i++){
+		uint8_t v = data[i];
+		if (pointer <= 6){
+			_store_time(pointer, v);
+		}
+		else if (pointer == REG_STATUS){
+			// The flags are only cleared, by writing 0.
+			uint8_t flags = STATUS_A1F | STATUS_A2F | STATUS_OSF;
+			regs[REG_STATUS] = (regs[REG_STATUS] & flags & v) | (v & ~flags & 0x08);
+		}
+		else if (pointer < REG_TEMP_MSB){
+			regs[pointer] = v;
+			if (pointer < REG_CONTROL){
+				alarm_valid = 0;
+			}
+		}
+		pointer = (pointer + 1) % REG_COUNT;
+	}
+	return SIM_I2C_OK;
+}
+
+uint8_t ds3231_model_read(uint8_t* data, uint8_t len){
+	_update();
+	_load_time();
+	for (uint8_t i = 0; i < len; i++){
+		data[i] = regs[pointer];
+		pointer = (pointer + 1) % REG_COUNT;
+	}
+	return len;
+}
+
+uint8_t sim_rtc_int_line(void){
+	_update();
+	uint8_t c = regs[REG_CONTROL];
+	uint8_t s = regs[REG_STATUS];
+	if (!(c & CONTROL_INTCN)){
+		return 1;
+	}
+	return !(((c & CONTROL_A1IE) && (s & STATUS_A1F)) || ((c & CONTROL_A2IE) && (s & STATUS_A2F)));
+}
+
+uint64_t sim_rtc_next_int(void){
+	if (!sim_rtc_int_line()){
+		return sim_cycles();
+	}
+	uint8_t c = regs[REG_CONTROL];
+	if (!(c & CONTROL_INTCN)){
+		return SIM_NEVER;
+	}
+	uint32_t next = 0;
+	for (uint8_t alarm = 0; alarm < 2; alarm++){
+		if (!(c & (alarm ? CONTROL_A2IE : CONTROL_A1IE))){
+			continue;
+		}
+		uint32_t match = alarm_next[alarm];
+		if (match != 0 && (next == 0 || match < next)){
+			next = match;
+		}
+	}
+	if (next == 0){
+		return SIM_NEVER;
+	}
+	return base_cycles + (uint64_t)(next - base_s) * SIM_CYCLES_S;
+}
@@ -0,0 +1,318 @@
+/*
+ * model_fat.cpp
+ *
+ * Created: 2026-10-19 11:07:51 PM
+ *  Author: Alexis Laframboise
+ *
+ *	Formatter and reader of the simulated card, out of the SPI
+ *	protocol : an MBR with one FAT16 partition at 1 MiB, as the
+ *	SD Association formatter lays out a small card, 8 KiB
+ *	clusters. The files of the root directory are copied out at
+ *	the end of a run, the settings file can be put there before.
+ *	A raw partition (SD_STREAM_RAW) can follow the FAT one, it is
+ *	copied out whole as raw.bin.
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "models.h"
+
+#define FAT_PART_START		(2048UL)
+#define FAT_PART_TYPE		(0x06)		/* FAT16, 32 MiB and more */
+#define RAW_PART_TYPE		(0xDA)		/* SD_STREAM_PART_TYPE */
+#define RAW_FILE_NAME		("raw.bin")
+#define FAT_RESERVED		(1)
+#define FAT_COUNT			(2)
+#define FAT_ROOT_ENTRIES	(512)
+#define FAT_CLUSTER_BLOCKS	(16)
+#define FAT_EOC				(0xFFFF)
+
+#define DIR_ENTRY_BYTES		(32)
+#define DIR_ATTR_VOLUME		(0x08)
+#define DIR_ATTR_DIRECTORY	(0x10)
+#define DIR_ATTR_LFN		(0x0F)
+
+/* Geometry of the volume, set by the formatter or read back */
+struct fat_volume_t {
+	uint32_t start;
+	uint32_t fat_start;
+	uint32_t fat_blocks;
+	uint32_t root_start;
+	uint32_t root_entries;
+	uint32_t data_start;
+	uint32_t cluster_blocks;
+	uint32_t clusters;
+};
+
+
+static void _put16(uint8_t* p, uint16_t v){
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+}
+
+static void _put32(uint8_t* p, uint32_t v){
+	_put16(p, (uint16_t)v);
+	_put16(p + 2, (uint16_t)(v >> 16));
+}
+
+static uint16_t _get16(const uint8_t* p){
+	return p[0] | ((uint16_t)p[1] << 8);
+}
+
+static uint32_t _get32(const uint8_t* p){
+	return _get16(p) | ((uint32_t)_get16(p + 2) << 16);
+}
+
+/** @brief	Reads the geometry back from the MBR and the boot sector.
+ *
+ */
+static bool _mount(fat_volume_t* v){
+	const uint8_t* mbr = sd_model_block(0);
+	if (mbr[510] != 0x55 || mbr[511] != 0xAA){
+		return false;
+	}
+	v->start = _get32(mbr + 446 + 8);
+	const uint8_t* bs = sd_model_block(v->start);
+	if (_get16(bs + 11) != 512 || bs[13] == 0 || bs[16] == 0){
+		return false;
+	}
+	v->cluster_blocks = bs[13];
+	v->fat_start = v->start + _get16(bs + 14);
+	v->fat_blocks = _get16(bs + 22);
+	v->root_entries = _get16(bs + 17);
+	v->root_start = v->fat_start + bs[16] * v->fat_blocks;
+	v->data_start = v->root_start + (v->root_entries * DIR_ENTRY_BYTES + 511) / 512;
+	uint32_t total = _get16(bs + 19) ? _get16(bs + 19) : _get32(bs + 32);
+	v->clusters = (total - (v->data_start - v->start)) / v->cluster_blocks;
+	return v->fat_blocks != 0 && v->clusters >= 4085 && v->clusters < 65525;
+}
+
+static uint16_t _fat_get(const fat_volume_t* v, uint16_t cluster){
+	const uint8_t* b = sd_model_block(v->fat_start + cluster / 256);
+	return _get16(b + (cluster % 256) * 2);
+}
+
+static void _fat_set(const fat_volume_t* v, uint16_t cluster, uint16_t next){
+	for (uint32_t f = 0; f < FAT_COUNT; f++){
+		uint32_t lba = v->fat_start + f * v->fat_blocks + cluster / 256;
+		uint8_t b[512];
+		memcpy(b, sd_model_block(lba), sizeof(b));
+		_put16(b + (cluster % 256) * 2, next);
+		sd_model_put(lba, b);
+	}
+}
+
+/** @brief	Fills a primary partition entry of the MBR.
+ *
+ */
+static void _mbr_part(uint8_t* p, uint8_t type, uint32_t start, uint32_t blocks){
+	p[0] = 0x00;
+	p[1] = 0xFE; p[2] = 0xFF; p[3] = 0xFF;		// CHS unused, LBA only
+	p[4] = type;
+	p[5] = 0xFE; p[6] = 0xFF; p[7] = 0xFF;
+	_put32(p + 8, start);
+	_put32(p + 12, blocks);
+}
+
+void fat_model_format(uint32_t raw_blocks){
+	uint32_t total = sd_model_blocks() - FAT_PART_START - raw_blocks;
+	uint8_t b[512];
+
+	// MBR, the FAT partition then the raw one at the end of the card
+	memset(b, 0, sizeof(b));
+	_mbr_part(b + 446, FAT_PART_TYPE, FAT_PART_START, total);
+	if (raw_blocks != 0){
+		_mbr_part(b + 446 + 16, RAW_PART_TYPE, FAT_PART_START + total, raw_blocks);
+	}
+	b[510] = 0x55;
+	b[511] = 0xAA;
+	sd_model_put(0, b);
+
+	// FAT size : two bytes per cluster, clusters 0 and 1 reserved
+	uint32_t root_blocks = FAT_ROOT_ENTRIES * DIR_ENTRY_BYTES / 512;
+	uint32_t fat_blocks = 1;
+	for (;;){
+		uint32_t data = total - FAT_RESERVED - FAT_COUNT * fat_blocks - root_blocks;
+		uint32_t needed = ((data / FAT_CLUSTER_BLOCKS + 2) * 2 + 511) / 512;
+		if (needed <= fat_blocks){
+			break;
+		}
+		fat_blocks = needed;
+	}
+
+	// Boot sector
+	memset(b, 0, sizeof(b));
+	b[0] = 0xEB; b[1] = 0x3C; b[2] = 0x90;
+	memcpy(b + 3, "TOURNSIM", 8);
+	_put16(b + 11, 512);
+	b[13] = FAT_CLUSTER_BLOCKS;
+	_put16(b + 14, FAT_RESERVED);
+	b[16] = FAT_COUNT;
+	_put16(b + 17, FAT_ROOT_ENTRIES);
+	_put16(b + 19, 0);
+	b[21] = 0xF8;
+	_put16(b + 22, (uint16_t)fat_blocks);
+	_put16(b + 24, 63);
+	_put16(b + 26, 255);
+	_put32(b + 28, FAT_PART_START);
+	_put32(b + 32, total);
+	b[36] = 0x80;
+	b[38] = 0x29;
+	_put32(b + 39, 0x20261019);
+	memcpy(b + 43, "TOURNESOL  ", 11);
+	memcpy(b + 54, "FAT16   ", 8);
+	b[510] = 0x55;
+	b[511] = 0xAA;
+	sd_model_put(FAT_PART_START, b);
+
+	// Both FATs : media and end of chain in the reserved entries
+	fat_volume_t v;
+	_mount(&v);
+	_fat_set(&v, 0, 0xFFF8);
+	_fat_set(&v, 1, FAT_EOC);
+}
+
+/** @brief	Name of a directory entry, 8.3 in upper case.
+ *
+ */
+static bool _dir_name(const char* name, uint8_t* out){
+	memset(out, ' ', 11);
+	const char* dot = strchr(name, '.');
+	size_t base = dot ? (size_t)(dot - name) : strlen(name);
+	size_t ext = dot ? strlen(dot + 1) : 0;
+	if (base == 0 || base > 8 || ext > 3){
+		return false;
+	}
+	for (size_t i = 0; i < base; i++){
+		out[i] = toupper((unsigned char)name[i]);
+	}
+	for (size_t i = 0; i < ext; i++){
+		out[8 + i] = toupper((unsigned char)dot[1 + i]);
+	}
+	return true;
+}
+
+bool fat_model_add(const char* name, const uint8_t* data, uint32_t size){
+	fat_volume_t v;
+	uint8_t entry[DIR_ENTRY_BYTES];
+	if (!_mount(&v)){
+		return false;
+	}
+	memset(entry, 0, sizeof(entry));
+	if (!_dir_name(name, entry)){
+		return false;
+	}
+
+	// Contiguous clusters after the last used one
+	uint32_t cluster_bytes = v.cluster_blocks * 512;
+	uint32_t count = (size + cluster_bytes - 1) / cluster_bytes;
+	uint16_t first = 2;
+	for (uint16_t c = 2; c < v.clusters + 2; c++){
+		if (_fat_get(&v, c) != 0){
+			first = c + 1;
+		}
+	}
+	if (first + count > v.clusters + 2){
+		return false;
+	}
+	for (uint32_t i = 0; i < count; i++){
+		_fat_set(&v, first + i, i + 1 < count ? first + i + 1 : FAT_EOC);
+	}
+	for (uint32_t off = 0; off < size; off += 512){
+		uint8_t b[512];
+		memset(b, 0, sizeof(b));
+		memcpy(b, data + off, size - off < 512 ? size - off : 512);
+		sd_model_put(v.data_start + (first - 2) * v.cluster_blocks + off / 512, b);
+	}
+
+	entry[11] = 0x20;		// Archive
+	_put16(entry + 26, count ? first : 0);
+	_put32(entry + 28, size);
+
+	for (uint32_t i = 0; i < v.root_entries; i++){
+		uint32_t lba = v.root_start + i * DIR_ENTRY_BYTES / 512;
+		uint8_t b[512];
+		memcpy(b, sd_model_block(lba), sizeof(b));
+		uint8_t* e = b + (i * DIR_ENTRY_BYTES) % 512;
+		if (e[0] == 0x00 || e[0] == 0xE5){
+			memcpy(e, entry, sizeof(entry));
+			sd_model_put(lba, b);
+			return true;
+		}
+	}
+	return false;
+}
+
+int fat_model_extract(const char* dir){
+	fat_volume_t v;
+	if (!_mount(&v)){
+		return -1;
+	}
+	int files = 0;
+	for (uint32_t i = 0; i < v.root_entries; i++){
+		const uint8_t* e = sd_model_block(v.root_start + i * DIR_ENTRY_BYTES / 512) + (i * DIR_ENTRY_BYTES) % 512;
+		if (e[0] == 0x00){
+			break;
+		}
+		if (e[0] == 0xE5 || e[11] == DIR_ATTR_LFN || (e[11] & (DIR_ATTR_VOLUME | DIR_ATTR_DIRECTORY))){
+			continue;
+		}
+
+		char name[13];
+		size_t n = 0;
+		for (size_t k = 0; k < 8 && e[k] != ' '; k++){
+			name[n++] = tolower(e[k]);
+		}
+		if (e[8] != ' '){
+			name[n++] = '.';
+			for (size_t k = 8; k < 11 && e[k] != ' '; k++){
+				name[n++] = tolower(e[k]);
+			}
+		}
+		name[n] = '\0';
+
+		char path[512];
+		snprintf(path, sizeof(path), "%s/%s", dir, name);
+		FILE* f = fopen(path, "wb");
+		if (f == NULL){
+			fprintf(stderr, "sim: can't write %s\n", path);
+			continue;
+		}
+		uint32_t size = _get32(e + 28);
+		uint16_t cluster = _get16(e + 26);
+		while (size > 0 && cluster >= 2 && cluster < v.clusters + 2){
+			for (uint32_t k = 0; k < v.cluster_blocks && size > 0; k++){
+				uint32_t len = size < 512 ? size : 512;
+				fwrite(sd_model_block(v.data_start + (cluster - 2) * v.cluster_blocks + k), 1, len, f);
+				size -= len;
+			}
+			cluster = _fat_get(&v, cluster);
+		}
+		fclose(f);
+		files++;
+	}
+
+	const uint8_t* mbr = sd_model_block(0);
+	for (uint32_t i = 0; i < 4; i++){
+		const uint8_t* p = mbr + 446 + i * 16;
+		if (p[4] != RAW_PART_TYPE){
+			continue;
+		}
+		char path[512];
+		snprintf(path, sizeof(path), "%s/%s", dir, RAW_FILE_NAME);
+		FILE* f = fopen(path, "wb");
+		if (f == NULL){
+			fprintf(stderr, "sim: can't write %s\n", path);
+			break;
+		}
+		for (uint32_t k = 0; k < _get32(p + 12); k++){
+			fwrite(sd_model_block(_get32(p + 8) + k), 1, 512, f);
+		}
+		fclose(f);
+		files++;
+		break;
+	}
+	return files;
+}
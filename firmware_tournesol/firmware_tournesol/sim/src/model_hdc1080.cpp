@@ -0,0 +1,156 @@
+/*
+ * model_hdc1080.cpp
+ *
+ * Created: 2026-10-19 10:38:47 PM
+ *  Author: Alexis Laframboise
+ *
+ *	HDC1080 model : there is no capture of it in tests/, the
+ *	temperature and the humidity follow a daily cycle of the RTC
+ *	time, coldest and wettest at 03:00, warmest at 15:00. Writing
+ *	the pointer to 0x00 or 0x01 starts a conversion, the device
+ *	doesn't acknowledge a read before it is done nor before its
+ *	start-up time after the rail is switched on.
+ */
+
+#include "models.h"
+
+#define REG_TEMPERATURE	(0x00)
+#define REG_HUMIDITY	(0x01)
+#define REG_CONFIG		(0x02)
+#define REG_SERIAL_0	(0xFB)
+#define REG_SERIAL_1	(0xFC)
+#define REG_SERIAL_2	(0xFD)
+#define REG_MANUFACTURER (0xFE)
+#define REG_DEVICE_ID	(0xFF)
+
+#define CONFIG_RST		(1 << 15)
+#define CONFIG_MODE		(1 << 12)
+#define CONFIG_TRES		(1 << 10)
+#define CONFIG_HRES		(3 << 8)
+#define CONFIG_DEFAULT	(0x1000)
+
+#define STARTUP_CYCLES	(15 * SIM_CYCLES_MS)	/* Datasheet maximum */
+
+/* Daily cycle, in hundredths */
+#define TEMP_MIN_C100	(1200)
+#define TEMP_MAX_C100	(2400)
+#define RH_MAX_100		(7500)
+#define RH_MIN_100		(4500)
+
+static uint16_t config = CONFIG_DEFAULT;
+static uint8_t pointer = 0;
+static uint64_t ready_at = 0;
+static uint64_t powered_at = SIM_NEVER;
+
+
+/** @brief	Conversion time of a measurement, in us.
+ *
+ */
+static uint32_t _conversion_us(uint8_t reg){
+	uint32_t t = (config & CONFIG_TRES) ? 3650 : 6350;
+	static const uint16_t h[4] = { 6500, 3850, 2500, 2500 };
+	uint32_t rh = h[(config & CONFIG_HRES) >> 8];
+	if (config & CONFIG_MODE){
+		return reg == REG_TEMPERATURE ? t + rh : rh;
+	}
+	return reg == REG_TEMPERATURE ? t : rh;
+}
+
+/** @brief	Position in the daily cycle, 0 at 03:00 to 43200 at 15:00.
+ *
+ */
+static uint32_t _day_phase(void){
+	uint32_t s = (ds3231_model_now() + 86400UL - 3 * 3600UL) % 86400UL;
+	return s < 43200UL ? s : 86400UL - s;
+}
+
+static uint16_t _measure(uint8_t reg){
+	uint32_t phase = _day_phase();
+	uint32_t raw;
+	uint8_t bits;
+	if (reg == REG_TEMPERATURE){
+		int32_t c100 = TEMP_MIN_C100 + (int32_t)(phase * (TEMP_MAX_C100 - TEMP_MIN_C100) / 43200UL);
+		raw = (uint32_t)(c100 + 4000) * 65536UL / 16500UL;
+		bits = (config & CONFIG_TRES) ? 11 : 14;
+	}
+	else {
+		uint32_t rh100 = RH_MAX_100 - phase * (RH_MAX_100 - RH_MIN_100) / 43200UL;
+		raw = rh100 * 65536UL / 10000UL;
+		static const uint8_t h[4] = { 14, 11, 8, 8 };
+		bits = h[(config & CONFIG_HRES) >> 8];
+	}
+	if (raw > 0xFFFF){
+		raw = 0xFFFF;
+	}
+	return (uint16_t)raw & (uint16_t)(0xFFFF << (16 - bits));
+}
+
+/** @brief	Checks the rail, a power cycle resets the device.
+ *
+ */
+static bool _powered(void){
+	uint64_t on = sim_powered_for(SIM_PIN_HDC1080_POWER, 1);
+	if (on == SIM_NEVER){
+		powered_at = SIM_NEVER;
+		return false;
+	}
+	uint64_t at = sim_cycles() - on;
+	if (at != powered_at){
+		powered_at = at;
+		config = CONFIG_DEFAULT;
+		pointer = 0;
+		ready_at = 0;
+	}
+	return on >= STARTUP_CYCLES;
+}
+
+uint8_t hdc1080_model_write(const uint8_t* data, uint8_t len){
+	if (!_powered()){
+		return SIM_I2C_NACK_ADDR;
+	}
+	if (len == 0){
+		return SIM_I2C_OK;
+	}
+	pointer = data[0];
+	if (pointer == REG_CONFIG && len >= 3){
+		uint16_t v = ((uint16_t)data[1] << 8) | data[2];
+		config = (v & CONFIG_RST) ? CONFIG_DEFAULT : (v & 0x3700) | (config & ~0x3700);
+	}
+	if (pointer == REG_TEMPERATURE || pointer == REG_HUMIDITY){
+		ready_at = sim_cycles() + (uint64_t)_conversion_us(pointer) * SIM_CYCLES_US;
+	}
+	return SIM_I2C_OK;
+}
+
+uint8_t hdc1080_model_read(uint8_t* data, uint8_t len){
+	if (!_powered()){
+		return 0;
+	}
+	uint16_t words[2];
+	uint8_t count = 1;
+	switch (pointer){
+	case REG_TEMPERATURE:
+	case REG_HUMIDITY:
+		if (sim_cycles() < ready_at){
+			return 0;
+		}
+		words[0] = _measure(pointer);
+		if (pointer == REG_TEMPERATURE && (config & CONFIG_MODE)){
+			words[1] = _measure(REG_HUMIDITY);
+			count = 2;
+		}
+		break;
+	case REG_CONFIG:		words[0] = config; break;
+	case REG_SERIAL_0:		words[0] = 0x0213; break;
+	case REG_SERIAL_1:		words[0] = 0x4C8A; break;
+	case REG_SERIAL_2:		words[0] = 0x1D80; break;
+	case REG_MANUFACTURER:	words[0] = 0x5449; break;
+	case REG_DEVICE_ID:		words[0] = 0x1050; break;
+	default:				words[0] = 0x0000; break;
+	}
+	for (uint8_t i = 0; i < len; i++){
+		uint16_t w = i / 2 < count ? words[i / 2] : 0xFFFF;
+		data[i] = (i & 1) ? (uint8_t)w : (uint8_t)(w >> 8);
+	}
+	return len;
+}
@@ -0,0 +1,677 @@
+/*
+ * model_sd.cpp
+ *
+ * Created: 2026-10-19 10:58:33 PM
+ *  Author: Alexis Laframboise
+ *
+ *	SD card model, SPI mode, SDHC (block addressing). The card
+ *	answers the commands used by Sd2Card : init (CMD0, CMD8,
+ *	ACMD41, CMD58), CSD and CID, single and multiple block reads
+ *	and writes, erase. It is busy (MISO low) while it programs.
+ *
+ *	The blocks are kept in a mapping of the card, anonymous or of
+ *	an image file that outlives the run. The flash is modeled per
+ *	erase block : a block written again since the last erase goes
+ *	to a log, and once the log of its erase block is full the card
+ *	merges it, an internal erase that keeps it busy for 100 ms and
+ *	more (Sd2Card::waitNotBusy polls through it). Each erase, by a
+ *	merge or by CMD38, wears its erase block.
+ *
+ *	The latencies are drawn from the distributions of the profile,
+ *	with a seeded generator so that a run is repeatable, and the
+ *	failures are injected from a second generator, so enabling
+ *	them keeps the latencies of the run.
+ */
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <deque>
+#include <vector>
+
+#include "models.h"
+
+/* R1 bits */
+#define R1_READY		(0x00)
+#define R1_IDLE			(0x01)
+#define R1_ILLEGAL		(0x04)
+#define R1_ADDRESS		(0x20)
+
+/* Data tokens */
+#define TOKEN_START		(0xFE)
+#define TOKEN_MULTI		(0xFC)
+#define TOKEN_STOP		(0xFD)
+#define DATA_ACCEPTED	(0xE5)
+#define DATA_WRITE_ERROR (0x0D)
+#define TOKEN_ECC_ERROR	(0x04)		/* Data error token, card ECC failed */
+
+#define ACMD41_POLLS	(2)			/* Power up, busy until then */
+#define BLOCK_BYTES		(512)
+
+/* Profile of a typical class 4 card, latencies in us */
+#define SD_DEFAULT_PROFILE	"read=fixed:200,write=uniform:700:1300,multi=uniform:500:900," \
+							"stop=fixed:300,erase=fixed:2000,merge=uniform:100000:250000," \
+							"erase_kib=128,log=32,seed=1"
+
+enum sd_dist_kind_t {
+	SD_FIXED,		/* a */
+	SD_UNIFORM,		/* a to b */
+	SD_EXP			/* a plus an exponential tail, mean b */
+};
+
+struct sd_dist_t {
+	sd_dist_kind_t kind;
+	double a;
+	double b;
+};
+
+struct sd_profile_t {
+	sd_dist_t read;			/* Command to start token */
+	sd_dist_t write;		/* Single block programming */
+	sd_dist_t multi;		/* Block of a CMD25 sequence */
+	sd_dist_t stop;			/* Stop token of a CMD25 sequence */
+	sd_dist_t erase;		/* CMD38, per erase block */
+	sd_dist_t merge;		/* Internal erase of a full log */
+	uint32_t erase_blocks;	/* Blocks per erase block */
+	uint32_t log;			/* Rewrites absorbed by an erase block */
+	uint32_t wear_limit;	/* Erases before an erase block fails, 0 : none */
+	double fail_write;		/* Chance of a write error per block */
+	double fail_read;		/* Chance of an ECC error per block */
+	double stall;			/* Chance of a program past the timeouts */
+	uint32_t stall_ms;
+	uint64_t seed;
+};
+
+/* Flash state of an erase block */
+struct sd_erase_block_t {
+	uint32_t erases;
+	uint32_t rewrites;		/* In the log since the last erase */
+};
+
+enum sd_state_t {
+	SD_COMMAND,		/* Waits for a command */
+	SD_WRITE,		/* CMD24, waits for the start token and the block */
+	SD_WRITE_MULTI	/* CMD25, waits for the tokens and the blocks */
+};
+
+static const uint8_t csd[16] = { 0x40, 0x0E, 0x00, 0x32, 0x5B, 0x59, 0x00, 0x00,
+								 0x00, 0x00, 0x7F, 0x80, 0x0A, 0x40, 0x00, 0x01 };
+static const uint8_t cid[16] = { 0x03, 'S', 'D', 'S', 'I', 'M', '0', '1',
+								 0x10, 0x00, 0x00, 0x00, 0x01, 0x01, 0x6A, 0x01 };
+static const uint8_t zeros[512] = { 0 };
+
+static uint8_t* card = NULL;
+static uint32_t card_blocks = 0;
+static int card_fd = -1;
+static std::vector<uint8_t> programmed;		/* Bit per block, since its erase */
+static std::vector<sd_erase_block_t> erase_blocks;
+static sd_profile_t profile;
+static uint64_t latency_rng = 0;
+static uint64_t failure_rng = 0;
+static uint64_t busy_peak = 0;
+static uint8_t csd_card[16];
+
+static sd_state_t state = SD_COMMAND;
+static uint8_t selected = 0;
+static uint8_t idle = 1;
+static uint8_t app = 0;
+static uint8_t acmd41_polls = 0;
+static uint8_t cmd[6];
+static uint8_t cmd_len = 0;
+static std::deque<uint8_t> out;
+static uint64_t busy_until = 0;
+
+static uint32_t read_block = 0;
+static uint8_t read_pending = 0;
+static uint64_t read_at = 0;
+
+static uint32_t write_block = 0;
+static uint8_t rx[514];
+static uint16_t rx_len = 0;
+static uint8_t rx_active = 0;
+
+static uint32_t erase_first = 0;
+static uint32_t erase_last = 0;
+
+static sd_stats_t stats;
+
+
+/* ---- Profile ---- */
+
+/** @brief	xorshift64*, one state per stream.
+ *
+ */
+static uint64_t _random(uint64_t* state){
+	uint64_t x = *state;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	*state = x;
+	return x * 0x2545F4914F6CDD1DULL;
+}
+
+/** @brief	Uniform in [0, 1).
+ *
+ */
+static double _uniform(uint64_t* state){
+	return (_random(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static bool _chance(double p){
+	return p > 0 && _uniform(&failure_rng) < p;
+}
+
+static uint64_t _draw(const sd_dist_t& d){
+	double us = d.a;
+	if (d.kind == SD_UNIFORM){
+		us = d.a + (d.b - d.a) * _uniform(&latency_rng);
+	}
+	else if (d.kind == SD_EXP){
+		us = d.a - (d.b - d.a) * log(1.0 - _uniform(&latency_rng));
+	}
+	return (uint64_t)(us * SIM_CYCLES_US);
+}
+
+static bool _parse_dist(const char* text, sd_dist_t* d){
+	char kind[16];
+	double a, b;
+	int n = sscanf(text, "%15[a-z]:%lf:%lf", kind, &a, &b);
+	if (n == 2 && !strcmp(kind, "fixed")){
+		*d = { SD_FIXED, a, a };
+	}
+	else if (n == 3 && !strcmp(kind, "uniform") && b >= a){
+		*d = { SD_UNIFORM, a, b };
+	}
+	else if (n == 3 && !strcmp(kind, "exp") && b >= a){
+		*d = { SD_EXP, a, b };
+	}
+	else {
+		return false;
+	}
+	return a >= 0;
+}
+
+/** @brief	Sets the entries of a profile, key=value separated
+ *			by commas.
+ *
+ */
+static bool _parse_profile(const char* spec){
+	std::vector<char> copy(spec, spec + strlen(spec) + 1);
+	for (char* item = strtok(copy.data(), ","); item; item = strtok(NULL, ",")){
+		char* value = strchr(item, '=');
+		if (value == NULL){
+			fprintf(stderr, "sim: SD profile entry without a value: %s\n", item);
+			return false;
+		}
+		*value++ = '\0';
+		bool ok = true;
+		if (!strcmp(item, "read")) ok = _parse_dist(value, &profile.read);
+		else if (!strcmp(item, "write")) ok = _parse_dist(value, &profile.write);
+		else if (!strcmp(item, "multi")) ok = _parse_dist(value, &profile.multi);
+		else if (!strcmp(item, "stop")) ok = _parse_dist(value, &profile.stop);
+		else if (!strcmp(item, "erase")) ok = _parse_dist(value, &profile.erase);
+		else if (!strcmp(item, "merge")) ok = _parse_dist(value, &profile.merge);
+		else if (!strcmp(item, "erase_kib")) profile.erase_blocks = strtoul(value, NULL, 0) * 1024 / BLOCK_BYTES;
+		else if (!strcmp(item, "log")) profile.log = strtoul(value, NULL, 0);
+		else if (!strcmp(item, "wear_limit")) profile.wear_limit = strtoul(value, NULL, 0);
+		else if (!strcmp(item, "fail_write")) profile.fail_write = strtod(value, NULL);
+		else if (!strcmp(item, "fail_read")) profile.fail_read = strtod(value, NULL);
+		else if (!strcmp(item, "stall")) profile.stall = strtod(value, NULL);
+		else if (!strcmp(item, "stall_ms")) profile.stall_ms = strtoul(value, NULL, 0);
+		else if (!strcmp(item, "seed")) profile.seed = strtoull(value, NULL, 0);
+		else ok = false;
+		if (!ok){
+			fprintf(stderr, "sim: bad SD profile entry %s=%s\n", item, value);
+			return false;
+		}
+	}
+	if (profile.erase_blocks == 0){
+		fprintf(stderr, "sim: SD erase block smaller than 1 KiB\n");
+		return false;
+	}
+	return true;
+}
+
+bool sd_model_configure(const char* spec){
+	memset(&profile, 0, sizeof(profile));
+	profile.stall_ms = 1000;
+	if (!_parse_profile(SD_DEFAULT_PROFILE) || (spec && !_parse_profile(spec))){
+		return false;
+	}
+	// The streams can't start at 0, xorshift would stay there.
+	latency_rng = profile.seed * 2 + 1;
+	failure_rng = profile.seed * 2 + 2;
+	return true;
+}
+
+/* ---- Storage ---- */
+
+static bool _programmed(uint32_t lba){
+	return programmed[lba / 8] & (1 << (lba % 8));
+}
+
+static void _program(uint32_t lba){
+	programmed[lba / 8] |= 1 << (lba % 8);
+}
+
+bool sd_model_init(uint32_t count, const char* image){
+	if (profile.erase_blocks == 0 && !sd_model_configure(NULL)){
+		return false;
+	}
+	size_t bytes = (size_t)count * BLOCK_BYTES;
+	if (image){
+		card_fd = open(image, O_RDWR | O_CREAT, 0644);
+		struct stat st;
+		if (card_fd < 0 || fstat(card_fd, &st) != 0){
+			fprintf(stderr, "sim: can't open the card image %s\n", image);
+			return false;
+		}
+		// An image keeps its size, a new one is sparse.
+		if (st.st_size >= 1024L * BLOCK_BYTES){
+			count = (uint32_t)(st.st_size / BLOCK_BYTES);
+			bytes = (size_t)count * BLOCK_BYTES;
+		}
+		else if (ftruncate(card_fd, bytes) != 0){
+			fprintf(stderr, "sim: can't size the card image %s\n", image);
+			return false;
+		}
+		card = (uint8_t*)mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, card_fd, 0);
+	}
+	else {
+		card = (uint8_t*)mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	}
+	if (card == MAP_FAILED){
+		fprintf(stderr, "sim: can't map the card\n");
+		card = NULL;
+		return false;
+	}
+	card_blocks = count;
+	programmed.assign((count + 7) / 8, 0);
+	erase_blocks.assign((count + profile.erase_blocks - 1) / profile.erase_blocks, sd_erase_block_t());
+	if (image){
+		// What the image holds is programmed, its wear is unknown.
+		for (uint32_t lba = 0; lba < count; lba++){
+			if (memcmp(card + (size_t)lba * BLOCK_BYTES, zeros, BLOCK_BYTES) != 0){
+				_program(lba);
+			}
+		}
+	}
+
+	memcpy(csd_card, csd, sizeof(csd_card));
+	// C_SIZE : (C_SIZE + 1) * 512 KiB
+	uint32_t c_size = count / 1024 - 1;
+	csd_card[7] = (c_size >> 16) & 0x3F;
+	csd_card[8] = c_size >> 8;
+	csd_card[9] = c_size;
+	memset(&stats, 0, sizeof(stats));
+	return true;
+}
+
+void sd_model_close(void){
+	if (card && card_fd >= 0){
+		msync(card, (size_t)card_blocks * BLOCK_BYTES, MS_SYNC);
+		munmap(card, (size_t)card_blocks * BLOCK_BYTES);
+		close(card_fd);
+		card = NULL;
+		card_fd = -1;
+	}
+}
+
+uint32_t sd_model_blocks(void){
+	return card_blocks;
+}
+
+const uint8_t* sd_model_block(uint32_t lba){
+	if (lba >= card_blocks){
+		return zeros;
+	}
+	return card + (size_t)lba * BLOCK_BYTES;
+}
+
+void sd_model_put(uint32_t lba, const uint8_t* data){
+	if (lba >= card_blocks){
+		return;
+	}
+	memcpy(card + (size_t)lba * BLOCK_BYTES, data, BLOCK_BYTES);
+	_program(lba);
+}
+
+const sd_stats_t* sd_model_stats(void){
+	return &stats;
+}
+
+uint64_t sd_model_peak(void){
+	uint64_t peak = busy_peak;
+	busy_peak = 0;
+	return peak;
+}
+
+bool sd_model_write_wear(const char* path){
+	FILE* f = fopen(path, "w");
+	if (f == NULL){
+		return false;
+	}
+	fprintf(f, "erase_block,first_block,erases\n");
+	for (size_t i = 0; i < erase_blocks.size(); i++){
+		if (erase_blocks[i].erases){
+			fprintf(f, "%zu,%zu,%u\n", i, i * profile.erase_blocks, erase_blocks[i].erases);
+		}
+	}
+	fclose(f);
+	return true;
+}
+
+static void _busy(uint64_t cycles){
+	busy_until = sim_cycles() + cycles;
+	stats.busy_cycles += cycles;
+	if (cycles > busy_peak){
+		busy_peak = cycles;
+	}
+	if (cycles > stats.busy_max){
+		stats.busy_max = cycles;
+	}
+	uint8_t bucket = 0;
+	for (uint64_t ms = cycles / SIM_CYCLES_MS; ms && bucket < SD_LATENCY_BUCKETS - 1; ms >>= 1){
+		bucket++;
+	}
+	stats.latency[bucket]++;
+}
+
+/** @brief	Erases an erase block, it wears.
+ *
+ */
+static void _erase_block(uint32_t eb){
+	sd_erase_block_t& e = erase_blocks[eb];
+	e.erases++;
+	e.rewrites = 0;
+	stats.block_erases++;
+	if (e.erases > stats.wear_max){
+		stats.wear_max = e.erases;
+	}
+}
+
+/** @brief	CMD38 : the blocks of the range read 0 again, each
+ *			erase block they touch is erased.
+ *
+ */
+static void _erase(uint32_t first, uint32_t last){
+	uint64_t cycles = 0;
+	for (uint32_t eb = first / profile.erase_blocks; eb <= last / profile.erase_blocks; eb++){
+		_erase_block(eb);
+		cycles += _draw(profile.erase);
+	}
+	memset(card + (size_t)first * BLOCK_BYTES, 0, (size_t)(last - first + 1) * BLOCK_BYTES);
+	for (uint32_t lba = first; lba <= last; lba++){
+		programmed[lba / 8] &= ~(1 << (lba % 8));
+	}
+	stats.erases++;
+	_busy(cycles);
+}
+
+/** @brief	Programs a block received from the host.
+ *
+ *  @return	busy cycles, 0 if the write fails
+ */
+static uint64_t _write(uint32_t lba, const uint8_t* data, const sd_dist_t& latency){
+	uint32_t eb = lba / profile.erase_blocks;
+	sd_erase_block_t& e = erase_blocks[eb];
+	uint64_t cycles = _draw(latency);
+	if ((profile.wear_limit && e.erases >= profile.wear_limit) || _chance(profile.fail_write)){
+		stats.failures++;
+		return 0;
+	}
+	if (_programmed(lba) && ++e.rewrites > profile.log){
+		// The log is full : the valid blocks are copied to a fresh
+		// erase block and the old one is erased.
+		_erase_block(eb);
+		stats.merges++;
+		cycles += _draw(profile.merge);
+	}
+	memcpy(card + (size_t)lba * BLOCK_BYTES, data, BLOCK_BYTES);
+	_program(lba);
+	if (_chance(profile.stall)){
+		stats.failures++;
+		cycles += (uint64_t)profile.stall_ms * SIM_CYCLES_MS;
+	}
+	return cycles;
+}
+
+static void _respond(uint8_t r1){
+	// One byte of NCR before the response
+	out.push_back(0xFF);
+	out.push_back(r1);
+}
+
+static void _respond_register(const uint8_t* reg){
+	_respond(R1_READY);
+	out.push_back(0xFF);
+	out.push_back(TOKEN_START);
+	out.insert(out.end(), reg, reg + 16);
+	out.push_back(0xFF);
+	out.push_back(0xFF);
+}
+
+static void _execute(void){
+	uint8_t index = cmd[0] & 0x3F;
+	uint32_t arg = ((uint32_t)cmd[1] << 24) | ((uint32_t)cmd[2] << 16) | ((uint32_t)cmd[3] << 8) | cmd[4];
+	uint8_t acmd = app;
+	app = 0;
+	stats.commands++;
+
+	if (index == 0){
+		idle = 1;
+		acmd41_polls = 0;
+		state = SD_COMMAND;
+		_respond(R1_IDLE);
+		return;
+	}
+	if (acmd && index == 41){
+		if (++acmd41_polls >= ACMD41_POLLS){
+			idle = 0;
+		}
+		_respond(idle ? R1_IDLE : R1_READY);
+		return;
+	}
+	uint8_t r1 = idle ? R1_IDLE : R1_READY;
+	switch (index){
+	case 8:
+		_respond(r1);
+		out.push_back(0x00);
+		out.push_back(0x00);
+		out.push_back((arg >> 8) & 0x0F);
+		out.push_back(arg & 0xFF);
+		return;
+	case 55:
+		app = 1;
+		_respond(r1);
+		return;
+	case 58:
+		_respond(r1);
+		// Powered up, CCS (SDHC), 2.7 to 3.6 V
+		out.push_back(idle ? 0x40 : 0xC0);
+		out.push_back(0xFF);
+		out.push_back(0x80);
+		out.push_back(0x00);
+		return;
+	case 59:
+	case 16:
+		_respond(r1);
+		return;
+	}
+	if (idle){
+		_respond(R1_IDLE | R1_ILLEGAL);
+		return;
+	}
+	switch (index){
+	case 9:
+		_respond_register(csd_card);
+		break;
+	case 10:
+		_respond_register(cid);
+		break;
+	case 12:
+		state = SD_COMMAND;
+		_respond(R1_READY);
+		break;
+	case 13:
+		_respond(R1_READY);
+		out.push_back(0x00);
+		break;
+	case 17:
+		if (arg >= card_blocks){
+			_respond(R1_ADDRESS);
+			break;
+		}
+		_respond(R1_READY);
+		read_block = arg;
+		read_pending = 1;
+		read_at = sim_cycles() + _draw(profile.read);
+		break;
+	case 23:
+		if (!acmd){
+			_respond(R1_ILLEGAL);
+			break;
+		}
+		_respond(R1_READY);
+		break;
+	case 24:
+	case 25:
+		if (arg >= card_blocks){
+			_respond(R1_ADDRESS);
+			break;
+		}
+		_respond(R1_READY);
+		write_block = arg;
+		state = index == 24 ? SD_WRITE : SD_WRITE_MULTI;
+		rx_active = 0;
+		break;
+	case 32:
+		erase_first = arg;
+		_respond(R1_READY);
+		break;
+	case 33:
+		erase_last = arg;
+		_respond(R1_READY);
+		break;
+	case 38:
+		if (erase_first > erase_last || erase_last >= card_blocks){
+			_respond(R1_ADDRESS);
+			break;
+		}
+		_respond(R1_READY);
+		_erase(erase_first, erase_last);
+		break;
+	default:
+		_respond(R1_ILLEGAL);
+		break;
+	}
+}
+
+/** @brief	Byte of a data block sent by the host.
+ *
+ */
+static void _receive_data(uint8_t b){
+	if (!rx_active){
+		if (state == SD_WRITE && b == TOKEN_START){
+			rx_active = 1;
+			rx_len = 0;
+		}
+		else if (state == SD_WRITE_MULTI && b == TOKEN_MULTI){
+			rx_active = 1;
+			rx_len = 0;
+		}
+		else if (state == SD_WRITE_MULTI && b == TOKEN_STOP){
+			state = SD_COMMAND;
+			out.push_back(0xFF);
+			_busy(_draw(profile.stop));
+		}
+		return;
+	}
+	rx[rx_len++] = b;
+	if (rx_len < sizeof(rx)){
+		return;
+	}
+	// Block and CRC received
+	rx_active = 0;
+	uint64_t cycles = 0;
+	if (write_block < card_blocks){
+		cycles = _write(write_block, rx, state == SD_WRITE ? profile.write : profile.multi);
+	}
+	if (cycles == 0){
+		out.push_back(DATA_WRITE_ERROR);
+		state = SD_COMMAND;
+		return;
+	}
+	stats.blocks_written++;
+	out.push_back(DATA_ACCEPTED);
+	_busy(cycles);
+	if (state == SD_WRITE){
+		state = SD_COMMAND;
+	}
+	else {
+		write_block++;
+	}
+}
+
+static uint8_t _miso(void){
+	if (out.empty() && read_pending && sim_cycles() >= read_at){
+		read_pending = 0;
+		if (_chance(profile.fail_read)){
+			stats.failures++;
+			out.push_back(TOKEN_ECC_ERROR);
+			return _miso();
+		}
+		const uint8_t* data = sd_model_block(read_block);
+		out.push_back(TOKEN_START);
+		out.insert(out.end(), data, data + 512);
+		out.push_back(0xFF);
+		out.push_back(0xFF);
+		stats.blocks_read++;
+	}
+	if (!out.empty()){
+		uint8_t b = out.front();
+		out.pop_front();
+		return b;
+	}
+	return sim_cycles() < busy_until ? 0x00 : 0xFF;
+}
+
+void sim_sd_select(uint8_t sel){
+	selected = sel;
+	if (!sel){
+		// The rest of a response is lost, a block in progress too.
+		out.clear();
+		cmd_len = 0;
+		read_pending = 0;
+	}
+}
+
+uint8_t sim_sd_transfer(uint8_t mosi){
+	sim_stack_mark();
+	if (!selected){
+		return 0xFF;
+	}
+	uint8_t miso = _miso();
+
+	if (state != SD_COMMAND && cmd_len == 0 && (rx_active || (mosi & 0xC0) != 0x40)){
+		_receive_data(mosi);
+		return miso;
+	}
+	if (cmd_len == 0){
+		if ((mosi & 0xC0) != 0x40){
+			return miso;
+		}
+		out.clear();
+		read_pending = 0;
+	}
+	cmd[cmd_len++] = mosi;
+	if (cmd_len == sizeof(cmd)){
+		cmd_len = 0;
+		_execute();
+	}
+	return miso;
+}
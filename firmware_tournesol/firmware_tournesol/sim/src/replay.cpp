@@ -0,0 +1,113 @@
+/*
+ * replay.cpp
+ *
+ * Created: 2026-10-19 10:26:14 PM
+ *  Author: Alexis Laframboise
+ *
+ *	Sensor captures of tests/, replayed in a loop by the models :
+ *	the AS7262 readings of Spectro_calib.txt (dark, ambient and
+ *	bright sets), the anemometer counts of Anemometre_calib.txt
+ *	and the PT100 counts of rtd_calib.txt, rounded to the ADC
+ *	resolution. Only the serial lines of a reading are kept.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "models.h"
+
+struct spectro_row_t {
+	float ch[AS7262_CHANNELS];
+};
+
+static std::vector<spectro_row_t> spectro;
+static std::vector<uint16_t> anemometer;
+static std::vector<uint16_t> pt100;
+static size_t spectro_ix = 0;
+static size_t anemometer_ix = 0;
+static size_t pt100_ix = 0;
+
+
+static FILE* _open(const char* dir, const char* name){
+	char path[512];
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	FILE* f = fopen(path, "r");
+	if (f == NULL){
+		fprintf(stderr, "sim: can't read %s\n", path);
+	}
+	return f;
+}
+
+static bool _load_spectro(const char* dir){
+	FILE* f = _open(dir, "Spectro_calib.txt");
+	if (f == NULL){
+		return false;
+	}
+	char line[256];
+	spectro_row_t row;
+	int next = 0;
+	while (fgets(line, sizeof(line), f)){
+		int ch;
+		float value;
+		// "CH 0 : 5.84," : the six channels of a reading, in order
+		if (sscanf(line, "CH %d : %f", &ch, &value) != 2 || ch != next){
+			next = 0;
+			continue;
+		}
+		row.ch[next++] = value;
+		if (next == AS7262_CHANNELS){
+			spectro.push_back(row);
+			next = 0;
+		}
+	}
+	fclose(f);
+	return !spectro.empty();
+}
+
+static bool _load_counts(const char* dir, const char* name, const char* format, std::vector<uint16_t>& counts){
+	FILE* f = _open(dir, name);
+	if (f == NULL){
+		return false;
+	}
+	char line[256];
+	while (fgets(line, sizeof(line), f)){
+		float value;
+		if (sscanf(line, format, &value) == 1 && value >= 0 && value <= 1023){
+			counts.push_back((uint16_t)lroundf(value));
+		}
+	}
+	fclose(f);
+	return !counts.empty();
+}
+
+bool replay_load(const char* dir){
+	bool ok = _load_spectro(dir);
+	ok &= _load_counts(dir, "Anemometre_calib.txt", "Anemometer raw data : %f", anemometer);
+	// The "stabilized" summaries don't match, only the readings do.
+	ok &= _load_counts(dir, "rtd_calib.txt", "Temp(PT100) : %f raw count", pt100);
+	if (ok){
+		sim_log("replay: %zu AS7262 readings, %zu anemometer and %zu PT100 counts",
+				spectro.size(), anemometer.size(), pt100.size());
+	}
+	return ok;
+}
+
+const float* replay_spectro_next(void){
+	const float* row = spectro[spectro_ix].ch;
+	spectro_ix = (spectro_ix + 1) % spectro.size();
+	return row;
+}
+
+uint16_t replay_anemometer_next(void){
+	uint16_t count = anemometer[anemometer_ix];
+	anemometer_ix = (anemometer_ix + 1) % anemometer.size();
+	return count;
+}
+
+uint16_t replay_pt100_next(void){
+	uint16_t count = pt100[pt100_ix];
+	pt100_ix = (pt100_ix + 1) % pt100.size();
+	return count;
+}
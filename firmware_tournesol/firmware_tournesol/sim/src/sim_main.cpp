@@ -0,0 +1,463 @@
+/*
+ * sim_main.cpp
+ *
+ * Created: 2026-10-19 11:19:42 PM
+ *  Author: Alexis Laframboise
+ *
+ *	Host simulator of the station : the firmware of main.cpp runs
+ *	unchanged on the HAL of sim/src, the sensors replay the
+ *	captures of tests/ and the virtual clock jumps over the
+ *	sleeps. A run is deterministic : the same traces and options
+ *	give the same serial output, log and SD files, bit for bit.
+ *
+ *	Usage : tournesol_sim [--wakes N] [--hours H] [--start unix]
+ *			[--traces dir] [--settings config.bin] [--vcc mV]
+ *			[--out dir] [--soak soak.csv] [--quiet 1]
+ *			[--card card.img] [--sd profile] [--raw blocks]
+ *
+ *	The out directory gets serial.log (what the station prints),
+ *	sim.log (wakes and model events) and the files of the card.
+ *	An allocation of the firmware past its setup is a warning
+ *	(sram.h : the heap must stay empty).
+ *
+ *	A soak run (--soak, --wakes 0 --hours 8760 for a year) adds
+ *	one line per wake to a CSV : virtual awake time, host CPU time
+ *	of the firmware code (the virtual clock doesn't count it), SD
+ *	operations and stack depth, for Sertools/soak_report.py.
+ *	--quiet drops the serial output and the wake lines of sim.log.
+ *
+ *	The card is kept in memory, or in an image file (--card) that
+ *	the next run mounts again : a blank image is formatted first.
+ *	--raw puts a raw partition of that size at the end of a blank
+ *	card, for the firmware built with SD_STREAM_RAW.
+ *	--sd sets its latencies, wear and injected failures (see
+ *	sd_model_configure()), sd_wear.csv gets the erase counts.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <vector>
+
+#include "models.h"
+
+#define SIM_DEFAULT_START	(1649628900UL)	/* UNIX_CURRENT_TIMESTAMP */
+#define SIM_DEFAULT_WAKES	(100)
+#define SIM_CARD_BLOCKS		(524288UL)		/* 256 MiB */
+
+/* Firmware entry, main() of main.cpp renamed by the Makefile */
+int firmware_main();
+
+struct sim_options_t {
+	uint32_t wakes;			/* 0 : no limit */
+	uint32_t hours;			/* 0 : no limit */
+	uint32_t start;
+	uint16_t vcc_mv;
+	const char* traces;
+	const char* settings;
+	const char* out;
+	const char* soak;
+	uint8_t quiet;
+	const char* card;
+	const char* sd;
+	uint32_t raw_blocks;
+};
+
+static sim_options_t options = { SIM_DEFAULT_WAKES, 0, SIM_DEFAULT_START, 5000,
+								 "../tests", NULL, "out", NULL, 0, NULL, NULL, 0 };
+
+static FILE* serial_log = NULL;
+static FILE* run_log = NULL;
+static uint32_t wakes = 0;
+static uint32_t warnings = 0;
+static uint64_t awake_at_wake = 0;
+
+/* Soak record of the wake in progress */
+static FILE* soak_log = NULL;
+static uint64_t slept_cycles = 0;
+static sd_stats_t sd_at_wake;
+static uint64_t host_ns_at_wake = 0;
+static uintptr_t stack_base = 0;	/* Frame of main(), before the firmware */
+static uintptr_t stack_low = 0;		/* Deepest frame of the wake */
+
+/* Heap of the firmware, which must stay empty past the setup */
+static uint32_t heap_allocs = 0;
+static uint32_t heap_alloc_bytes = 0;
+static uint32_t heap_warned_wake = 0;
+
+
+static void _vlog(const char* prefix, const char* fmt, va_list args){
+	if (run_log == NULL){
+		return;
+	}
+	uint64_t c = sim_cycles();
+	fprintf(run_log, "[%8" PRIu64 ".%06" PRIu64 "] %s", c / SIM_CYCLES_S,
+			(c % SIM_CYCLES_S) / SIM_CYCLES_US, prefix);
+	vfprintf(run_log, fmt, args);
+	fputc('\n', run_log);
+}
+
+void sim_log(const char* fmt, ...){
+	va_list args;
+	va_start(args, fmt);
+	_vlog("", fmt, args);
+	va_end(args);
+}
+
+extern "C" void sim_warn(const char* fmt, ...){
+	va_list args;
+	va_start(args, fmt);
+	_vlog("warning: ", fmt, args);
+	va_end(args);
+	warnings++;
+}
+
+/** @brief	Histogram of the busy periods of the card.
+ *
+ */
+static void _log_latency(const sd_stats_t* sd){
+	char line[512];
+	size_t n = 0;
+	for (uint8_t i = 0; i < SD_LATENCY_BUCKETS; i++){
+		if (sd->latency[i] == 0){
+			continue;
+		}
+		const char* sep = n ? ", " : "";
+		if (i == 0){
+			n += snprintf(line + n, sizeof(line) - n, "%s<1 ms %" PRIu32, sep, sd->latency[i]);
+		}
+		else if (i == SD_LATENCY_BUCKETS - 1){
+			n += snprintf(line + n, sizeof(line) - n, "%s>=%u ms %" PRIu32, sep, 1u << (i - 1), sd->latency[i]);
+		}
+		else {
+			n += snprintf(line + n, sizeof(line) - n, "%s%u-%u ms %" PRIu32, sep, 1u << (i - 1), 1u << i,
+						  sd->latency[i]);
+		}
+	}
+	sim_log("sd busy: %s", n ? line : "none");
+}
+
+/** @brief	Ends the run : copies the card out and reports.
+ *
+ */
+static void __attribute__((noreturn)) _finish(int code){
+	const sd_stats_t* sd = sd_model_stats();
+	uint64_t wall = sim_cycles();
+	uint64_t awake = sim_awake_cycles();
+
+	sim_log("end: %" PRIu32 " wakes, %" PRIu64 " s, awake %" PRIu64 " ms, %" PRIu32 " warnings",
+			wakes, wall / SIM_CYCLES_S, awake / SIM_CYCLES_MS, warnings);
+	sim_log("sd: %" PRIu32 " commands, %" PRIu32 " blocks read, %" PRIu32 " written, %" PRIu32
+			" erases, busy %" PRIu64 " ms", sd->commands, sd->blocks_read, sd->blocks_written,
+			sd->erases, sd->busy_cycles / SIM_CYCLES_MS);
+	sim_log("sd: %" PRIu32 " merges, %" PRIu32 " erase blocks erased, most worn %" PRIu32
+			", %" PRIu32 " failures, longest busy %" PRIu64 " us", sd->merges, sd->block_erases,
+			sd->wear_max, sd->failures, sd->busy_max / SIM_CYCLES_US);
+	_log_latency(sd);
+	sim_log("heap: %" PRIu32 " allocations, %" PRIu32 " B", heap_allocs, heap_alloc_bytes);
+
+	int files = fat_model_extract(options.out);
+	if (files < 0){
+		sim_log("card unreadable, no file copied");
+	}
+	char path[512];
+	snprintf(path, sizeof(path), "%s/sd_wear.csv", options.out);
+	sd_model_write_wear(path);
+	sd_model_close();
+	if (serial_log){
+		fclose(serial_log);
+	}
+	if (soak_log){
+		fclose(soak_log);
+	}
+	if (run_log){
+		fclose(run_log);
+	}
+	printf("%" PRIu32 " wakes, %.1f h, awake %.3f s, %" PRIu32 " warnings, %d files in %s\n",
+		   wakes, (double)wall / SIM_CYCLES_S / 3600.0, (double)awake / SIM_CYCLES_S,
+		   warnings, files, options.out);
+	exit(code);
+}
+
+extern "C" void sim_fatal(const char* fmt, ...){
+	va_list args;
+	va_start(args, fmt);
+	_vlog("fatal: ", fmt, args);
+	va_end(args);
+	_finish(1);
+}
+
+/* ---- Serial port ---- */
+
+extern "C" void sim_serial_out(uint8_t c){
+	sim_stack_mark();
+	if (!options.quiet){
+		fputc(c, serial_log);
+	}
+}
+
+/* ---- Heap ---- */
+
+extern "C" void sim_heap_alloc(uint32_t bytes){
+	heap_allocs++;
+	heap_alloc_bytes += bytes;
+	// Once per wake, a leak would fill the log otherwise.
+	if (wakes > 0 && heap_warned_wake != wakes){
+		heap_warned_wake = wakes;
+		sim_warn("heap: the firmware allocated %" PRIu32 " B during wake %" PRIu32, bytes, wakes);
+	}
+}
+
+/* ---- Soak records ---- */
+
+void sim_stack_mark(void){
+	uintptr_t frame = (uintptr_t)__builtin_frame_address(0);
+	if (frame < stack_low){
+		stack_low = frame;
+	}
+}
+
+/** @brief	CPU time of the simulator, the firmware code included.
+ *
+ */
+static uint64_t _host_ns(void){
+	struct timespec t;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+	return (uint64_t)t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+
+/** @brief	Line of the wake that ends in the soak CSV.
+ *
+ */
+static void _soak_record(uint64_t awake){
+	const sd_stats_t* sd = sd_model_stats();
+	fprintf(soak_log, "%" PRIu32 ",%" PRIu32 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu32 ",%" PRIu32
+			",%" PRIu32 ",%" PRIu32 ",%" PRIu64 ",%" PRIu64 ",%" PRIu32 ",%" PRIu32 ",%" PRIu64 "\n",
+			wakes, ds3231_model_now() + (uint32_t)MODEL_YEAR_2000_S, slept_cycles / SIM_CYCLES_MS,
+			awake / SIM_CYCLES_US, (_host_ns() - host_ns_at_wake) / 1000,
+			sd->commands - sd_at_wake.commands, sd->blocks_read - sd_at_wake.blocks_read,
+			sd->blocks_written - sd_at_wake.blocks_written, sd->erases - sd_at_wake.erases,
+			(sd->busy_cycles - sd_at_wake.busy_cycles) / SIM_CYCLES_US,
+			sd_model_peak() / SIM_CYCLES_US, sd->merges - sd_at_wake.merges, sd->wear_max,
+			(uint64_t)(stack_base - stack_low));
+}
+
+/* ---- Sleeps ---- */
+
+extern "C" void sim_sleep(void){
+	uint64_t awake = sim_awake_cycles() - awake_at_wake;
+	if (wakes == 0){
+		sim_log("setup: awake %" PRIu64 " us", awake / SIM_CYCLES_US);
+	}
+	else if (!options.quiet){
+		sim_log("sleep: awake %" PRIu64 " us", awake / SIM_CYCLES_US);
+	}
+	if (soak_log && wakes > 0){
+		_soak_record(awake);
+	}
+	if (options.wakes && wakes >= options.wakes){
+		_finish(0);
+	}
+	if (options.hours && sim_cycles() >= (uint64_t)options.hours * 3600 * SIM_CYCLES_S){
+		_finish(0);
+	}
+}
+
+extern "C" void sim_wake(uint64_t slept){
+	wakes++;
+	awake_at_wake = sim_awake_cycles();
+	slept_cycles = slept;
+	sd_at_wake = *sd_model_stats();
+	sd_model_peak();
+	host_ns_at_wake = _host_ns();
+	stack_low = stack_base;
+	if (options.quiet){
+		return;
+	}
+	sim_log("wake %" PRIu32 ": slept %" PRIu64 " ms, RTC %" PRIu32, wakes,
+			slept / SIM_CYCLES_MS, ds3231_model_now());
+}
+
+/* ---- Powered devices ---- */
+
+uint64_t sim_powered_for(uint8_t pin, uint8_t on_level){
+	if (sim_pin_output(pin) != on_level){
+		return SIM_NEVER;
+	}
+	return sim_cycles() - sim_pin_changed_at(pin);
+}
+
+/* ---- I2C bus ---- */
+
+extern "C" uint8_t sim_i2c_write(uint8_t addr, const uint8_t* data, uint8_t len){
+	sim_stack_mark();
+	switch (addr){
+	case DS3231_MODEL_ADDR:
+		return ds3231_model_write(data, len);
+	case HDC1080_MODEL_ADDR:
+		return hdc1080_model_write(data, len);
+	case AS7262_MODEL_ADDR:
+		return as7262_model_write(data, len);
+	default:
+		return SIM_I2C_NACK_ADDR;
+	}
+}
+
+extern "C" uint8_t sim_i2c_read(uint8_t addr, uint8_t* data, uint8_t len){
+	sim_stack_mark();
+	switch (addr){
+	case DS3231_MODEL_ADDR:
+		return ds3231_model_read(data, len);
+	case HDC1080_MODEL_ADDR:
+		return hdc1080_model_read(data, len);
+	case AS7262_MODEL_ADDR:
+		return as7262_model_read(data, len);
+	default:
+		return 0;
+	}
+}
+
+extern "C" uint8_t sim_i2c_line(uint8_t pin){
+	// No slave stretches the clock nor holds the data line.
+	(void)pin;
+	return 1;
+}
+
+/* ---- Run ---- */
+
+static FILE* _create(const char* name){
+	char path[512];
+	snprintf(path, sizeof(path), "%s/%s", options.out, name);
+	FILE* f = fopen(path, "wb");
+	if (f == NULL){
+		fprintf(stderr, "sim: can't write %s\n", path);
+		exit(2);
+	}
+	return f;
+}
+
+/** @brief	Puts the settings block on the card, config.bin.
+ *
+ */
+static bool _load_settings(const char* path){
+	FILE* f = fopen(path, "rb");
+	if (f == NULL){
+		fprintf(stderr, "sim: can't read %s\n", path);
+		return false;
+	}
+	std::vector<uint8_t> data;
+	int c;
+	while ((c = fgetc(f)) != EOF){
+		data.push_back((uint8_t)c);
+	}
+	fclose(f);
+	return fat_model_add("config.bin", data.data(), (uint32_t)data.size());
+}
+
+static void _usage(void){
+	fprintf(stderr, "usage: tournesol_sim [--wakes N] [--hours H] [--start unix] [--traces dir]\n"
+					"                     [--settings config.bin] [--vcc mV] [--out dir]\n"
+					"                     [--soak soak.csv] [--quiet 1] [--card card.img]\n"
+					"                     [--sd read=fixed:200,merge=uniform:100000:250000,...]\n"
+					"                     [--raw blocks]\n");
+	exit(2);
+}
+
+static void _parse(int argc, char** argv){
+	for (int i = 1; i < argc; i++){
+		const char* opt = argv[i];
+		if (i + 1 >= argc){
+			_usage();
+		}
+		const char* val = argv[++i];
+		if (!strcmp(opt, "--wakes")){
+			options.wakes = strtoul(val, NULL, 0);
+		}
+		else if (!strcmp(opt, "--hours")){
+			options.hours = strtoul(val, NULL, 0);
+		}
+		else if (!strcmp(opt, "--start")){
+			options.start = strtoul(val, NULL, 0);
+		}
+		else if (!strcmp(opt, "--vcc")){
+			options.vcc_mv = (uint16_t)strtoul(val, NULL, 0);
+		}
+		else if (!strcmp(opt, "--traces")){
+			options.traces = val;
+		}
+		else if (!strcmp(opt, "--settings")){
+			options.settings = val;
+		}
+		else if (!strcmp(opt, "--out")){
+			options.out = val;
+		}
+		else if (!strcmp(opt, "--soak")){
+			options.soak = val;
+		}
+		else if (!strcmp(opt, "--quiet")){
+			options.quiet = (uint8_t)strtoul(val, NULL, 0);
+		}
+		else if (!strcmp(opt, "--card")){
+			options.card = val;
+		}
+		else if (!strcmp(opt, "--sd")){
+			options.sd = val;
+		}
+		else if (!strcmp(opt, "--raw")){
+			options.raw_blocks = strtoul(val, NULL, 0);
+		}
+		else {
+			_usage();
+		}
+	}
+}
+
+int main(int argc, char** argv){
+	_parse(argc, argv);
+
+	if (mkdir(options.out, 0755) != 0 && errno != EEXIST){
+		fprintf(stderr, "sim: can't create %s\n", options.out);
+		return 2;
+	}
+	serial_log = _create("serial.log");
+	run_log = _create("sim.log");
+	if (options.soak){
+		soak_log = fopen(options.soak, "w");
+		if (soak_log == NULL){
+			fprintf(stderr, "sim: can't write %s\n", options.soak);
+			return 2;
+		}
+		fprintf(soak_log, "wake,rtc,slept_ms,awake_us,host_us,sd_commands,sd_read,sd_written,"
+						  "sd_erases,sd_busy_us,sd_peak_us,sd_merges,sd_wear_max,stack_bytes\n");
+	}
+
+	if (!sd_model_configure(options.sd) || !sd_model_init(SIM_CARD_BLOCKS, options.card)){
+		return 2;
+	}
+	const uint8_t* mbr = sd_model_block(0);
+	if (mbr[510] != 0x55 || mbr[511] != 0xAA){
+		fat_model_format(options.raw_blocks);
+		if (options.settings && !_load_settings(options.settings)){
+			return 2;
+		}
+	}
+	else if (options.settings){
+		fprintf(stderr, "sim: the card of %s is formatted, its config.bin is kept\n", options.card);
+	}
+	ds3231_model_init(options.start);
+	analog_model_init(options.vcc_mv);
+	if (!replay_load(options.traces)){
+		return 2;
+	}
+	sim_log("start: RTC %" PRIu32 ", %" PRIu32 " wakes", options.start, options.wakes);
+
+	stack_base = (uintptr_t)__builtin_frame_address(0);
+	stack_low = stack_base;
+	firmware_main();
+	sim_fatal("main() returned");
+}